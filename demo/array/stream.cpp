@@ -0,0 +1,91 @@
+#include <iostream>
+#include <Stream.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_stream {
+
+    class Employee : extends Object {
+    public:
+        Employee(const string &name, const string &department, int salary) :
+            name(name), department(department), salary(salary) {}
+        string name;
+        string department;
+        int salary;
+    };
+
+    void groupEmployees() {
+        RefArr<Employee> employees = RefArray<Employee>::of({
+            new_<Employee>("Tom", "Development", 9000),
+            new_<Employee>("Jerry", "Development", 12000),
+            new_<Employee>("Lily", "Marketing", 7000),
+            new_<Employee>("Lucy", "Marketing", 8500),
+            new_<Employee>("Jim", "Finance", 6000)
+        });
+        auto groups = Arrays::stream(employees)
+            .filter([](const Ref<Employee> &employee) { return employee->salary > 6500; })
+            .groupingBy([](const Ref<Employee> &employee) { return employee->department; });
+        for (auto &group : groups) {
+            cout << group.first << ":";
+            for (const Ref<Employee> &employee : group.second) {
+                cout << ' ' << employee->name;
+            }
+            cout << endl;
+        }
+        Arr<int> salaries = Arrays::stream(employees)
+            .map([](const Ref<Employee> &employee) { return employee->salary; })
+            .toArray();
+        cout << "Salary count: " << salaries.length() << endl;
+
+        vector<string> names = { "Tom", "Jerry", "Lily" };
+        cout << "Total length of names: "
+             << Collections::stream(names)
+                .map([](const string &name) { return (long)name.length(); })
+                .reduce(0L, [](long a, long b) { return a + b; })
+             << endl;
+    }
+
+    long sumOfEvenSquaresByLoop(Arr<int> arr) {
+        long sum = 0;
+        for (int value : arr) {
+            if (value % 2 == 0) {
+                sum += (long)value * value;
+            }
+        }
+        return sum;
+    }
+
+    void compareWithLoop() {
+        Arr<int> arr = Array<int>::newInstance(10000000, false);
+        for (int i = 0; i < arr.length(); i++) {
+            arr[i] = i % 1000;
+        }
+        auto stream = Arrays::stream(arr)
+            .filter([](int value) { return value % 2 == 0; })
+            .map([](int value) { return (long)value * value; });
+        Ref<ExecutorService> executorService = new_<ExecutorService>(4);
+
+        time_t start = System::currentTimeMillis();
+        long byLoop = sumOfEvenSquaresByLoop(arr);
+        time_t loopMillis = System::currentTimeMillis() - start;
+
+        start = System::currentTimeMillis();
+        long byStream = stream.reduce(0L, [](long a, long b) { return a + b; });
+        time_t streamMillis = System::currentTimeMillis() - start;
+
+        start = System::currentTimeMillis();
+        long byParallelStream = stream.parallel(executorService).reduce(0L, [](long a, long b) { return a + b; });
+        time_t parallelStreamMillis = System::currentTimeMillis() - start;
+
+        cout << "Loop: " << byLoop << ", " << loopMillis << "ms" << endl;
+        cout << "Stream: " << byStream << ", " << streamMillis << "ms" << endl;
+        cout << "Parallel stream: " << byParallelStream << ", " << parallelStreamMillis << "ms" << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    demo_stream::groupEmployees();
+    demo_stream::compareWithLoop();
+    return 0;
+}
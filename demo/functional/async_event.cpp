@@ -0,0 +1,95 @@
+#include <iostream>
+#include <thread>
+#include <AsyncConsumer.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_async_event {
+
+    class PriceChangedEventArgs : extends Object {
+    public:
+        PriceChangedEventArgs(const string &symbol, double price) : symbol(symbol), price(price) {}
+        string symbol;
+        double price;
+    };
+
+    class Market : extends Object {
+    public:
+        void setPrice(const string &symbol, double price) {
+            if (this->priceChangedListener != nullptr) {
+                this->priceChangedListener(new_<PriceChangedEventArgs>(symbol, price));
+            }
+        }
+        void addPriceChangedListener(Ref<RefConsumer<PriceChangedEventArgs>> listener) {
+            this->priceChangedListener += listener;
+        }
+    private:
+        Ref<RefConsumer<PriceChangedEventArgs>> priceChangedListener;
+    };
+
+    const char *SYMBOLS[] = { "AAPL", "GOOG", "MSFT" };
+
+    time_t changePrices(Ref<Market> market, int count) {
+        time_t start = System::currentTimeMillis();
+        for (int i = 0; i < count; i++) {
+            market->setPrice(SYMBOLS[i % 3], 100 + i * 0.01);
+        }
+        return System::currentTimeMillis() - start;
+    }
+}
+
+using namespace demo_async_event;
+
+int main(int argc, char *argv[]) {
+    const int changeCount = 300000;
+
+    // 慢速的监听者: 每个事件耗时1微秒以上
+    volatile int deliveredCount = 0;
+    Ref<RefConsumer<PriceChangedEventArgs>> slowListener = RefConsumer<PriceChangedEventArgs>::of(
+        [&deliveredCount](Ref<PriceChangedEventArgs> e) {
+            this_thread::sleep_for(chrono::microseconds(1));
+            deliveredCount = deliveredCount + 1;
+        }
+    );
+
+    // 同步监听: 修改价格的线程被监听者拖慢
+    Ref<Market> market = new_<Market>();
+    market->addPriceChangedListener(slowListener);
+    cout << "Synchronous listener, writer spent " << changePrices(market, changeCount / 100) << "ms for "
+         << changeCount / 100 << " changes" << endl;
+
+    // 按股票代码合并: 监听者跟不上时只收到每只股票的最新价格, 修改价格的线程从不等待监听者
+    deliveredCount = 0;
+    Ref<AsyncConsumer<Ref<PriceChangedEventArgs>>> coalescingListener =
+        AsyncConsumer<Ref<PriceChangedEventArgs>>::coalescing(
+            slowListener,
+            [](const Ref<PriceChangedEventArgs> &e) { return e->symbol; }
+        );
+    market = new_<Market>();
+    market->addPriceChangedListener(coalescingListener);
+    cout << "Coalescing asynchronous listener, writer spent " << changePrices(market, changeCount) << "ms for "
+         << changeCount << " changes";
+    coalescingListener->close();
+    cout << ", " << deliveredCount << " events are delivered" << endl;
+
+    // 批量投递给批量监听者, 缓冲区有界, 满时阻塞写线程(背压)
+    int batchCount = 0, eventCount = 0;
+    Ref<AsyncConsumer<Ref<PriceChangedEventArgs>>> batchListener = AsyncConsumer<Ref<PriceChangedEventArgs>>::ofBatch(
+        AsyncConsumer<Ref<PriceChangedEventArgs>>::BatchConsumer::of(
+            [&](const vector<tuple<Ref<PriceChangedEventArgs>>> &batch) {
+                batchCount++;
+                eventCount += (int)batch.size();
+            }
+        ),
+        nullptr,
+        1024
+    );
+    market = new_<Market>();
+    market->addPriceChangedListener(batchListener);
+    cout << "Batch asynchronous listener, writer spent " << changePrices(market, changeCount) << "ms for "
+         << changeCount << " changes";
+    batchListener->close();
+    cout << ", " << eventCount << " events are delivered in " << batchCount << " batches" << endl;
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <vector>
+#include <Functional.h>
+#include <Auxiliary.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_functional_benchmark {
+
+    const int LISTENER_COUNT = 50;
+    const int FIRE_COUNT = 200000;
+
+    // 返回调用FIRE_COUNT次所花费的毫秒数
+    template <typename F>
+    int64_t measure(F fire) {
+        int64_t start = System::currentTimeMillis();
+        for (int i = 0; i < FIRE_COUNT; i++) {
+            fire(i);
+        }
+        return System::currentTimeMillis() - start;
+    }
+
+    void benchmarkListeners() {
+        long sum = 0;
+        vector<Ref<Consumer<int>>> listeners;
+        for (int i = 0; i < LISTENER_COUNT; i++) {
+            listeners.push_back(Consumer<int>::of([&sum, i](int value) {
+                sum += value ^ i;
+            }));
+        }
+
+        // 逐个两两嵌套的组合方式, 调用时沿着一棵深度为LISTENER_COUNT的树递归
+        Ref<Consumer<int>> nested = listeners[0];
+        for (int i = 1; i < LISTENER_COUNT; i++) {
+            Ref<Consumer<int>> a = nested, b = listeners[i];
+            nested = Consumer<int>::of([a, b](int value) {
+                a(value);
+                b(value);
+            });
+        }
+
+        // "+="得到的合并实例, 调用时顺序遍历一段连续的调用列表
+        Ref<Consumer<int>> combined;
+        for (Ref<Consumer<int>> &listener : listeners) {
+            combined += listener;
+        }
+
+        measure([&nested](int value) { nested(value); }); //预热
+        int64_t nestedMillis = measure([&nested](int value) { nested(value); });
+        int64_t combinedMillis = measure([&combined](int value) { combined(value); });
+        int64_t loopMillis = measure([&listeners](int value) {
+            for (Ref<Consumer<int>> &listener : listeners) {
+                listener(value);
+            }
+        });
+        cout << LISTENER_COUNT << " listeners fired " << FIRE_COUNT << " times" << endl;
+        cout << "    nested pairs:      " << nestedMillis << " ms" << endl;
+        cout << "    combined by '+=':  " << combinedMillis << " ms" << endl;
+        cout << "    hand-written loop: " << loopMillis << " ms" << endl;
+        cout << "    (checksum " << sum << ")" << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    demo_functional_benchmark::benchmarkListeners();
+    return 0;
+}
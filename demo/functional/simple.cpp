@@ -31,5 +31,22 @@ int main(int argc, char *argv[]) {
     all -= plus + multiply;
     cout << "all is " << (all == nullptr ? "nullptr" : "a valid function") << endl;
 
+    // andThen/compose: 编译期组合为一个具体类型, 整条流水线被内联, 没有虚函数调用
+    auto pipeline = Functions::andThen(
+        [](int value) { return value + 1; },
+        [](int value) { return value * 2; }
+    ).andThen([](int value) { return to_string(value); });
+    cout << "pipeline(20) is " << pipeline(20) << endl;
+
+    // 需要类型擦除时, 整条流水线只被包装一次
+    Ref<Function<string(int)>> erased = Function<string(int)>::of(pipeline);
+    cout << "erased(20) is " << erased(20) << endl;
+
+    // 对于已经类型擦除的函数, 运行时组合得到一个新的函数
+    Ref<Function<int(int)>> increment = Function<int(int)>::of([](int value) { return value + 1; });
+    Ref<Function<int(int)>> square = Function<int(int)>::of([](int value) { return value * value; });
+    cout << "increment.andThen(square)(3) is " << increment.andThen(square)(3) << endl;
+    cout << "increment.compose(square)(3) is " << increment.compose(square)(3) << endl;
+
     return 0;
 };
@@ -0,0 +1,114 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <AtomicRef.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_atomic_ref {
+
+    const int READER_COUNT = 4;
+    const int WRITER_COUNT = 2;
+    const int INCREMENTER_COUNT = 4;
+    const int WRITE_COUNT = 100000;
+    const int INCREMENT_COUNT = 50000;
+
+    AtomicInteger liveConfigCount(0);
+
+    // 不可变的配置对象, 读者取得后无需加锁即可访问; checksum用于检测是否读到了已被释放的对象
+    class Config : extends Object {
+    public:
+        Config(int version) : version(version), checksum(~version) {
+            ++liveConfigCount;
+        }
+        ~Config() {
+            this->version = -1;
+            this->checksum = -1;
+            --liveConfigCount;
+        }
+        int getVersion() const {
+            return this->version;
+        }
+        bool isIntact() const {
+            return this->checksum == ~this->version;
+        }
+    private:
+        int version;
+        int checksum;
+    };
+
+    // 读者不停地get, 写者交替使用set和getAndSet热替换配置
+    void demoHotSwap() {
+        AtomicRef<Config> config(new_<Config>(0));
+        AtomicBoolean stopped(false);
+        AtomicInteger brokenCount(0);
+        vector<thread> threads;
+        for (int r = 0; r < READER_COUNT; r++) {
+            threads.emplace_back([&config, &stopped, &brokenCount] {
+                while (!stopped) {
+                    Ref<Config> snapshot = config.get();
+                    if (!snapshot->isIntact()) {
+                        ++brokenCount;
+                    }
+                }
+            });
+        }
+        vector<thread> writers;
+        for (int w = 0; w < WRITER_COUNT; w++) {
+            writers.emplace_back([&config, &brokenCount, w] {
+                for (int i = 1; i <= WRITE_COUNT; i++) {
+                    if (i % 2 == 0) {
+                        config.set(new_<Config>(i));
+                    } else if (!config.getAndSet(new_<Config>(i))->isIntact()) {
+                        ++brokenCount;
+                    }
+                }
+            });
+        }
+        for (thread &writer : writers) {
+            writer.join();
+        }
+        stopped.store(true);
+        for (thread &reader : threads) {
+            reader.join();
+        }
+        cout << "Hot swap: final version = " << config.get()->getVersion()
+             << ", broken snapshots = " << brokenCount.load() << endl;
+    }
+
+    // 多个线程以compareAndSet循环实现无锁递增, 最终版本号必须等于递增的总次数
+    void demoCompareAndSet() {
+        AtomicRef<Config> counter(new_<Config>(0));
+        AtomicInteger retryCount(0);
+        vector<thread> threads;
+        for (int t = 0; t < INCREMENTER_COUNT; t++) {
+            threads.emplace_back([&counter, &retryCount] {
+                for (int i = 0; i < INCREMENT_COUNT; i++) {
+                    while (true) {
+                        Ref<Config> current = counter.get();
+                        if (counter.compareAndSet(current, new_<Config>(current->getVersion() + 1))) {
+                            break;
+                        }
+                        ++retryCount;
+                    }
+                }
+            });
+        }
+        for (thread &t : threads) {
+            t.join();
+        }
+        cout << "Compare and set: final version = " << counter.get()->getVersion()
+             << ", expected = " << INCREMENTER_COUNT * INCREMENT_COUNT
+             << ", retries = " << retryCount.load() << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    demo_atomic_ref::demoHotSwap();
+    demo_atomic_ref::demoCompareAndSet();
+    // 被替换下来的旧引用由各线程延迟释放, 已退出线程的遗留部分在此交由主线程回收
+    Reclamation::flush();
+    cout << "Live configs: " << demo_atomic_ref::liveConfigCount.load() << endl;
+    return 0;
+}
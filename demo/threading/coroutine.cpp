@@ -0,0 +1,92 @@
+#include <iostream>
+#include <ExecutorService.h>
+#include <BlockingQueue.h>
+#include <Coroutine.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+class Reading : extends Object {
+public:
+    Reading(int sensorId, int value) : sensorId(sensorId), value(value) {}
+    int sensorId;
+    int value;
+};
+
+// 每个传感器周期性地产生读数, 等待期间不占用任何线程
+Task<> sensor(Ref<ScheduledExecutorService> scheduler, Ref<BlockingQueue<Reading>> queue, int sensorId) {
+    for (int round = 1; round <= 3; round++) {
+        co_await scheduler->delay(100);
+        queue->put(new_<Reading>(sensorId, round));
+    }
+}
+
+// 队列为空时挂起而不是阻塞线程
+Task<long> collector(Ref<BlockingQueue<Reading>> queue, int count) {
+    long sum = 0;
+    for (int i = 0; i < count; i++) {
+        Ref<Reading> reading = co_await queue->takeAsync();
+        sum += reading->value;
+    }
+    co_return sum;
+}
+
+Task<int> answer(Ref<ExecutorService> executorService) {
+    co_await executorService->schedule();
+    int value = co_await executorService->submit(Supplier<int>::of([] { return 6; }));
+    co_return value * 7;
+}
+
+Task<int> failure(Ref<ExecutorService> executorService) {
+    co_await executorService->schedule();
+    throw_new(IllegalStateException, "Something is wrong in coroutine");
+}
+
+Task<> rescue(Ref<ExecutorService> executorService) {
+    try_ {
+        co_await failure(executorService);
+    } catch_(IllegalStateException, ex) {
+        cout << "Caught in caller coroutine: " << ex->getMessage() << endl;
+    } end_try
+}
+
+// 线程池关闭之后, 切换线程和延迟都会抛出异常, 而不是让协程永远挂起
+Task<> afterShutdown(Ref<ScheduledExecutorService> scheduler) {
+    try_ {
+        co_await scheduler->schedule();
+    } catch_(IllegalStateException, ex) {
+        cout << "schedule() after shutdown: " << ex->getMessage() << endl;
+    } end_try
+    try_ {
+        co_await scheduler->delay(100);
+    } catch_(IllegalStateException, ex) {
+        cout << "delay() after shutdown: " << ex->getMessage() << endl;
+    } end_try
+    try_ {
+        co_await scheduler->submit(Supplier<int>::of([] { return 0; }));
+    } catch_(ExecutionException, ex) {
+        cout << "submit() after shutdown: " << ex->getCause()->getMessage() << endl;
+    } end_try
+}
+
+int main(int argc, char *argv[]) {
+    const int sensorCount = 10000;
+    Ref<ScheduledExecutorService> scheduler = new_<ScheduledExecutorService>(2);
+    Ref<BlockingQueue<Reading>> queue = new_<LinkedBlockingQueue<Reading>>();
+
+    time_t start = System::currentTimeMillis();
+    Ref<CompletableFuture<long>> total = collector(queue, sensorCount * 3).start();
+    for (int i = 0; i < sensorCount; i++) {
+        sensor(scheduler, queue, i).start();
+    }
+    cout << sensorCount << " sensors on 2 threads, sum of readings: " << total->get()
+         << ", elapsed millis: " << System::currentTimeMillis() - start << endl;
+
+    cout << "Answer: " << answer(scheduler).start()->get() << endl;
+    rescue(scheduler).start()->get();
+
+    // 协程帧中也持有线程池的引用, 显式关闭以等待它们在工作线程中销毁
+    scheduler->shutdown();
+    afterShutdown(scheduler).start()->get();
+    return 0;
+}
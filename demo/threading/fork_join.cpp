@@ -0,0 +1,115 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <ForkJoinPool.h>
+#include <ExecutorService.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_fork_join {
+
+    const int ELEMENT_COUNT = 1 << 22;
+    const int THRESHOLD = 1 << 10; //元素个数不超过该值时不再拆分
+    const int THREAD_COUNT = 4;
+
+    long sequentialSum(const int *data, int from, int to) {
+        long sum = 0;
+        for (int i = from; i < to; i++) {
+            sum += data[i];
+        }
+        return sum;
+    }
+
+    // 分治求和: fork左半部分, 在当前线程计算右半部分, 再join左半部分
+    class SumTask : extends RecursiveTask<long> {
+    public:
+        SumTask(const int *data, int from, int to) : data(data), from(from), to(to) {}
+    protected:
+        virtual long compute() override {
+            if (this->to - this->from <= THRESHOLD) {
+                return sequentialSum(this->data, this->from, this->to);
+            }
+            int middle = (this->from + this->to) / 2;
+            Ref<SumTask> left = new_<SumTask>(this->data, this->from, middle);
+            Ref<SumTask> right = new_<SumTask>(this->data, middle, this->to);
+            left->fork();
+            long rightSum = right->invoke();
+            return left->join() + rightSum;
+        }
+    private:
+        const int *data;
+        int from;
+        int to;
+    };
+
+    /*
+     * 同样的分治算法在ExecutorService上实现: 工作线程不能阻塞地等待子任务(所有线程都在等待时会死锁),
+     * 只能用CompletableFuture把合并操作挂到两个子任务之后, 所有子任务都经过同一个共享队列
+     */
+    Ref<CompletableFuture<long>> sumAsync(Ref<ExecutorService> executor, const int *data, int from, int to) {
+        if (to - from <= THRESHOLD) {
+            return CompletableFuture<long>::supplyAsync([=] { return sequentialSum(data, from, to); }, executor);
+        }
+        return CompletableFuture<bool>::supplyAsync([] { return true; }, executor)->thenCompose([=](bool) {
+            int middle = (from + to) / 2;
+            return sumAsync(executor, data, from, middle)->thenCombine(
+                sumAsync(executor, data, middle, to),
+                [](long left, long right) { return left + right; }
+            );
+        });
+    }
+
+    template <typename F>
+    void measure(const char *name, long expected, F sum) {
+        int64_t start = System::currentTimeMillis();
+        long result = 0;
+        for (int round = 0; round < 8; round++) {
+            result = sum();
+        }
+        int64_t millis = System::currentTimeMillis() - start;
+        cout << setw(32) << name << setw(8) << millis << "ms" << (result == expected ? "" : "  (wrong result)") << endl;
+    }
+}
+
+using namespace demo_fork_join;
+
+int main(int argc, char *argv[]) {
+    vector<int> data(ELEMENT_COUNT);
+    for (int i = 0; i < ELEMENT_COUNT; i++) {
+        data[i] = i % 1000;
+    }
+    const int *p = data.data();
+    long expected = sequentialSum(p, 0, ELEMENT_COUNT);
+    cout << "Sum " << ELEMENT_COUNT << " integers 8 times, split until at most " << THRESHOLD
+         << " integers are left, " << THREAD_COUNT << " threads" << endl;
+
+    measure("Sequential", expected, [=] {
+        return sequentialSum(p, 0, ELEMENT_COUNT);
+    });
+
+    Ref<ForkJoinPool> forkJoinPool = new_<ForkJoinPool>(THREAD_COUNT);
+    measure("ForkJoinPool", expected, [=] {
+        return forkJoinPool->invoke<long>(new_<SumTask>(p, 0, ELEMENT_COUNT));
+    });
+    cout << setw(32) << "Steal count" << setw(8) << forkJoinPool->getStealCount() << endl;
+
+    Ref<ExecutorService> executorService = new_<ExecutorService>(THREAD_COUNT);
+    measure("ExecutorService", expected, [=] {
+        return sumAsync(executorService, p, 0, ELEMENT_COUNT)->get();
+    });
+
+    // 子任务抛出的异常由join重新抛出
+    class FailingTask : extends RecursiveTask<int> {
+    protected:
+        virtual int compute() override {
+            throw_new(IllegalStateException, "Failed in the subtask");
+        }
+    };
+    try_ {
+        forkJoinPool->invoke<int>(new_<FailingTask>());
+    } catch_(Exception, ex) {
+        cout << "Caught exception: " << ex->getMessage() << endl;
+    } end_try
+    return 0;
+}
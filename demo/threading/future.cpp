@@ -0,0 +1,69 @@
+#include <iostream>
+#include <thread>
+#include <ExecutorService.h>
+#include <ThreadPoolExecutor.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+void threadSafeOutputWithTime(const string &text) {
+    static Mutex mutex;
+    Mutex::Scope scope(mutex);
+    cout << "[millis: " << System::currentTimeMillis() << "] "  << text << endl;
+}
+
+int main(int argc, char *argv[]) {
+    Ref<ExecutorService> executorService = new_<ExecutorService>(4);
+
+    Ref<CompletableFuture<string>> user = executorService->submit(Supplier<string>::of([] {
+        this_thread::sleep_for(chrono::milliseconds(500));
+        threadSafeOutputWithTime("User loaded");
+        return string("Tom");
+    }));
+    Ref<CompletableFuture<int>> score = executorService->submit(Supplier<int>::of([] {
+        this_thread::sleep_for(chrono::milliseconds(300));
+        threadSafeOutputWithTime("Score loaded");
+        return 90;
+    }));
+
+    // 两个任务并行执行, 都完成后在线程池中组合结果, 全程没有线程阻塞等待
+    Ref<CompletableFuture<string>> report = user->thenCombine(score, [](const string &name, int score) {
+        ostringstream oss;
+        oss << name << "'s score is " << score;
+        return oss.str();
+    }, executorService);
+
+    // 异常沿调用链传递, 直到被exceptionally处理
+    Ref<CompletableFuture<int>> failed = score
+        ->thenApply([](int score) -> int {
+            throw_new(IllegalStateException, "Cannot calculate the rank");
+        })
+        ->exceptionally([](Ref<Exception> ex) {
+            threadSafeOutputWithTime("Recovered from: " + ex->getMessage());
+            return -1;
+        });
+
+    threadSafeOutputWithTime("Report: " + report->get());
+    cout << "Rank: " << failed->get() << endl;
+
+    Ref<CompletableFuture<int>> never = new_<CompletableFuture<int>>();
+    try_ {
+        never->get(100);
+    } catch_(TimeoutException, ex) {
+        threadSafeOutputWithTime("Timeout: " + ex->getMessage());
+    } end_try
+
+    // executor拒绝后续操作时, 该后续操作以RejectedExecutionException完成, 同一future的其他后续操作不受影响
+    Ref<ThreadPoolExecutor> pool = new_<ThreadPoolExecutor>(1, 1, 0, 1, RejectionPolicy::ABORT);
+    pool->shutdown(); //ABORT策略下, 已关闭的线程池对任何任务都抛出RejectedExecutionException
+    Ref<CompletableFuture<int>> source = new_<CompletableFuture<int>>();
+    Ref<CompletableFuture<int>> rejected = source->thenApply([](int value) { return value + 1; }, pool);
+    Ref<CompletableFuture<int>> accepted = source->thenApply([](int value) { return value * 10; });
+    source->complete(1);
+    try_ {
+        rejected->get();
+    } catch_(ExecutionException, ex) {
+        threadSafeOutputWithTime("Rejected: " + ex->getCause()->getMessage());
+    } end_try
+    threadSafeOutputWithTime("Accepted: " + to_string(accepted->get()));
+}
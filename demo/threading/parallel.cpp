@@ -0,0 +1,108 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <Parallel.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_parallel {
+
+    const int ELEMENT_COUNT = 1 << 23;
+    const int GRAIN = 4096; //每块至少4096个元素, 使领取块的开销可以忽略
+
+    float transform(float value) {
+        return sqrtf(value) * 1.5f + 1.0f;
+    }
+
+    // 逐元素变换: 串行循环和Parallel::forEach的比较
+    void demoForEach() {
+        Arr<float> serial = Array<float>::newInstance(ELEMENT_COUNT);
+        Arr<float> parallel = Array<float>::newInstance(ELEMENT_COUNT);
+        for (int i = 0; i < ELEMENT_COUNT; i++) {
+            serial[i] = parallel[i] = (float)i;
+        }
+
+        int64_t begin = System::currentTimeMillis();
+        float *data = serial.unsafe();
+        for (int i = 0; i < ELEMENT_COUNT; i++) {
+            data[i] = transform(data[i]);
+        }
+        int64_t serialMillis = System::currentTimeMillis() - begin;
+
+        begin = System::currentTimeMillis();
+        Parallel::forEach(parallel, [](float &value) {
+            value = transform(value);
+        }, GRAIN);
+        int64_t parallelMillis = System::currentTimeMillis() - begin;
+
+        bool same = true;
+        for (int i = 0; i < ELEMENT_COUNT && same; i++) {
+            same = serial[i] == parallel[i];
+        }
+        cout << "Transform " << ELEMENT_COUNT << " floats, serial: " << serialMillis << " ms, Parallel::forEach: "
+             << parallelMillis << " ms, same result: " << (same ? "true" : "false") << endl;
+    }
+
+    // 归约: 每个参与者累加到自己的槽中, 最后由调用者合并
+    void demoReduce() {
+        Arr<double> values = Array<double>::newInstance(ELEMENT_COUNT);
+        double *data = values.unsafe();
+        Parallel::forEach(0, ELEMENT_COUNT, [data](int64_t i) {
+            data[i] = 1.0 / (i + 1);
+        }, GRAIN);
+        double sumOfSquares = Parallel::reduce(
+            0,
+            ELEMENT_COUNT,
+            0.0,
+            [data](int64_t i) {
+                return data[i] * data[i];
+            },
+            [](double a, double b) {
+                return a + b;
+            },
+            GRAIN
+        );
+        cout << "Sum of 1/n^2: " << sumOfSquares << " (pi^2/6 = " << M_PI * M_PI / 6 << ")" << endl;
+    }
+
+    // 指定线程池, 并行执行若干个独立的任务
+    void demoInvokeAll() {
+        Ref<ExecutorService> executorService = new_<ExecutorService>(2);
+        vector<long> results(3);
+        vector<Ref<Runnable>> tasks;
+        for (int i = 0; i < 3; i++) {
+            tasks.push_back(Runnable::of([&results, i] {
+                long sum = 0;
+                for (long n = 0; n < 10000000L * (i + 1); n++) {
+                    sum += n % 7;
+                }
+                results[i] = sum;
+            }));
+        }
+        Parallel::invokeAll(executorService, tasks);
+        cout << "Results of invokeAll: " << results[0] << ", " << results[1] << ", " << results[2] << endl;
+    }
+
+    // 循环体抛出的异常在调用者线程中重新抛出
+    void demoException() {
+        try_ {
+            Parallel::forEach(0, 1000000, [](int64_t i) {
+                if (i == 123456) {
+                    throw_new(IllegalArgumentException, "Bad element at index 123456");
+                }
+            });
+        } catch_(Exception, ex) {
+            cout << "Caught: " << ex->getMessage() << endl;
+        } end_try
+    }
+}
+
+int main(int argc, char *argv[]) {
+    cout << "Parallelism of common pool: " << ForkJoinPool::commonPool()->getParallelism() << endl;
+    demo_parallel::demoForEach();
+    demo_parallel::demoReduce();
+    demo_parallel::demoInvokeAll();
+    demo_parallel::demoException();
+    return 0;
+}
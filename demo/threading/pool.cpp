@@ -1,5 +1,6 @@
 #include <iostream>
 #include <thread>
+#include <vector>
 #include <ExecutorService.h>
 
 using namespace std;
@@ -11,6 +12,124 @@ void threadSafeOutputWithTime(const string &text) {
     cout << "[millis: " << System::currentTimeMillis() << "] "  << text << endl;
 }
 
+void measureTaskOverhead(const char *name, bool viaStdFunction) {
+    const int taskCount = 200000;
+    Ref<ExecutorService> executorService = new_<ExecutorService>(4);
+    Ref<Semaphore> semaphore = new_<Semaphore>();
+    AtomicInteger counter;
+    AtomicInteger *counterPointer = &counter;
+    string tag = name; //使捕获的状态超出std::function的内部缓冲区
+    int64_t begin = System::currentTimeMillis();
+    for (int i = 0; i < taskCount; i++) {
+        auto lambda = [=] {
+            if (!tag.empty()) {
+                *counterPointer += i & 1;
+            }
+            semaphore->signal();
+        };
+        if (viaStdFunction) {
+            executorService->execute(Runnable::of(function<void()>(lambda)));
+        } else {
+            executorService->execute(Runnable::of(lambda));
+        }
+    }
+    semaphore->acquire(taskCount);
+    int64_t elapsed = System::currentTimeMillis() - begin;
+    cout << name << ": " << taskCount << " tasks in " << elapsed << " ms, "
+         << elapsed * 1000000 / taskCount << " ns per task" << endl;
+}
+
+// 每个任务再提交若干子任务: SHARED_QUEUE模式下所有任务争用同一个队列, WORK_STEALING模式下子任务进入提交者自己的队列
+void measureSpawningTasks(const char *name, ExecutorMode mode) {
+    const int parentCount = 20000, childCount = 10;
+    Ref<ExecutorService> executorService = new_<ExecutorService>(4, mode);
+    Ref<Semaphore> semaphore = new_<Semaphore>();
+    ExecutorService *executor = executorService.get(); //任务不能持有线程池的强引用, 否则线程池无法析构
+    int64_t begin = System::currentTimeMillis();
+    for (int i = 0; i < parentCount; i++) {
+        executorService->execute(Runnable::of([=] {
+            for (int j = 0; j < childCount; j++) {
+                executor->execute(Runnable::of([=] {
+                    semaphore->signal();
+                }));
+            }
+        }));
+    }
+    semaphore->acquire(parentCount * childCount);
+    cout << name << ": " << parentCount * (childCount + 1) << " tasks in "
+         << System::currentTimeMillis() - begin << " ms" << endl;
+}
+
+// affinityKey相同的任务由同一个线程依次执行, 所以每个会话的计数器无需加锁
+void demoAffinity() {
+    const int sessionCount = 8, messageCount = 10000;
+    vector<int> counters(sessionCount);
+    {
+        Ref<ExecutorService> executorService = new_<ExecutorService>(4, ExecutorMode::WORK_STEALING, false);
+        for (int i = 0; i < messageCount; i++) {
+            int session = i % sessionCount;
+            executorService->execute(Runnable::of([&counters, session] {
+                counters[session]++;
+            }), session);
+        }
+    } //析构时等待已提交的任务执行完毕
+    cout << "Messages per session:";
+    for (int counter : counters) {
+        cout << ' ' << counter;
+    }
+    cout << endl;
+}
+
+// 线程名称可以在top -H和perf中看到; 工作线程绑定到第一个NUMA节点的CPU上
+void demoPlacement() {
+    cout << "NUMA nodes: " << NumaTopology::nodeCount() << endl;
+    Ref<ExecutorService> executorService = new_<ExecutorService>(
+        2,
+        ExecutorMode::SHARED_QUEUE,
+        true,
+        ThreadPlacement::onNumaNode("demo-pool", 0)
+    );
+    Ref<Semaphore> semaphore = new_<Semaphore>();
+    executorService->execute(Runnable::of([=] {
+        char name[16];
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        threadSafeOutputWithTime(string("Running in thread '") + name + "'");
+        semaphore->signal();
+    }));
+    semaphore->acquire();
+}
+
+// 采样每个任务的排队时间和执行时间, 定期输出统计; 抛出异常的任务被计数并交给uncaughtExceptionHandler
+void demoStats() {
+    const int taskCount = 20000;
+    Ref<ExecutorService> executorService = new_<ExecutorService>(2);
+    executorService->setSamplingInterval(1);
+    executorService->setUncaughtExceptionHandler(RefConsumer<Exception>::of([](Ref<Exception> ex) {
+        threadSafeOutputWithTime("Task failed: " + ex->getMessage());
+    }));
+    executorService->dumpStatsAtFixedRate(RefConsumer<ExecutorStats>::of([](Ref<ExecutorStats> stats) {
+        threadSafeOutputWithTime("Stats: " + stats->toString());
+    }), 100);
+    Ref<Semaphore> semaphore = new_<Semaphore>();
+    for (int i = 0; i < taskCount; i++) {
+        executorService->execute(Runnable::of([=] {
+            defer([=]() {
+                semaphore->signal();
+            });
+            if (i % 5000 == 4999) {
+                throw_new(IllegalStateException, "Simulated failure");
+            }
+            this_thread::sleep_for(chrono::microseconds(i % 100 == 0 ? 1000 : 10));
+        }));
+    }
+    semaphore->acquire(taskCount);
+    Ref<ExecutorStats> stats = executorService->getStats();
+    cout << "Completed: " << stats->getCompletedTaskCount()
+         << ", failed: " << stats->getFailedTaskCount()
+         << ", p99 execution time: " << stats->getExecutionTime().getValueAtPercentile(99) / 1000 << " us"
+         << endl;
+}
+
 int main(int argc, char *argv[]) {
     Ref<ExecutorService> executorService = new_<ExecutorService>(4);
     for (int i = 0; i < 12; i++) {
@@ -29,4 +148,14 @@ int main(int argc, char *argv[]) {
         cout << "--------------------------------------" << endl;
         this_thread::sleep_for(chrono::seconds(1));
     }
+
+    // 比较每个任务的额外开销: 经std::function包装的lambda需要分配两次内存, 直接传入lambda只需分配一次
+    measureTaskOverhead("Runnable::of(function<void()>)", true);
+    measureTaskOverhead("Runnable::of(lambda)", false);
+
+    measureSpawningTasks("ExecutorMode::SHARED_QUEUE", ExecutorMode::SHARED_QUEUE);
+    measureSpawningTasks("ExecutorMode::WORK_STEALING", ExecutorMode::WORK_STEALING);
+    demoAffinity();
+    demoPlacement();
+    demoStats();
 }
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <string>
+#include <ExecutorService.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_priority_queue {
+
+    class Job : extends Object, implements Prioritized {
+    public:
+        Job(const string &name, int priority) : name(name), priority(priority) {}
+        virtual int getPriority() override {
+            return this->priority;
+        }
+        const string &getName() const {
+            return this->name;
+        }
+    private:
+        string name;
+        int priority;
+        interface_refcount()
+    };
+
+    class Reminder : extends Object, implements Delayed {
+    public:
+        Reminder(const string &text, int64_t delay) : text(text), deadline(System::currentTimeMillis() + delay) {}
+        virtual int64_t getDelay() override {
+            return this->deadline - System::currentTimeMillis();
+        }
+        const string &getText() const {
+            return this->text;
+        }
+    private:
+        string text;
+        int64_t deadline;
+        interface_refcount()
+    };
+
+    // 优先级高的先出队, 优先级相同的按入队顺序出队
+    void demoPriorityBlockingQueue() {
+        Ref<PriorityBlockingQueue<Job>> queue = new_<PriorityBlockingQueue<Job>>();
+        queue->put(new_<Job>("report", 1));
+        queue->put(new_<Job>("backup", 0));
+        queue->put(new_<Job>("alarm", 9));
+        queue->put(new_<Job>("email", 1));
+        while (queue->size() != 0) {
+            Ref<Job> job = queue->take();
+            cout << "Job: " << job->getName() << ", priority: " << job->getPriority() << endl;
+        }
+    }
+
+    // 到期时间早的先出队, take一直等待到堆顶元素到期
+    void demoDelayQueue() {
+        Ref<DelayQueue<Reminder>> queue = new_<DelayQueue<Reminder>>();
+        int64_t begin = System::currentTimeMillis();
+        queue->put(new_<Reminder>("third", 300));
+        queue->put(new_<Reminder>("first", 100));
+        queue->put(new_<Reminder>("second", 200));
+        for (int i = 0; i < 3; i++) {
+            Ref<Reminder> reminder = queue->take();
+            cout << "Reminder: " << reminder->getText() << " after " << System::currentTimeMillis() - begin << " ms" << endl;
+        }
+    }
+
+    // 作为线程池的任务队列: 积压时紧急任务插队执行; 开启采样后被包装的任务仍保留优先级
+    void demoPriorityExecutor(int samplingInterval) {
+        cout << "Sampling interval: " << samplingInterval << endl;
+        Ref<ExecutorService> executorService = new_<ExecutorService>(1, new_<PriorityBlockingQueue<Runnable>>(), false);
+        executorService->setSamplingInterval(samplingInterval);
+        executorService->execute(Runnable::of([] {
+            this_thread::sleep_for(chrono::milliseconds(100)); //让后面的任务积压在队列中
+        }));
+        for (int i = 0; i < 3; i++) {
+            executorService->execute(Prioritized::of(0, Runnable::of([i] {
+                cout << "Normal task " << i << endl;
+            })));
+        }
+        executorService->execute(Prioritized::of(10, Runnable::of([] {
+            cout << "Urgent task" << endl;
+        })));
+        executorService->shutdown();
+    }
+
+    // 作为线程池的任务队列: 任务在截止时间之后才执行; 开启采样后被包装的任务仍保留截止时间
+    void demoDelayExecutor(int samplingInterval) {
+        cout << "Sampling interval: " << samplingInterval << endl;
+        Ref<ExecutorService> executorService = new_<ExecutorService>(2, new_<DelayQueue<Runnable>>());
+        executorService->setSamplingInterval(samplingInterval);
+        int64_t begin = System::currentTimeMillis();
+        AtomicInteger pending(3);
+        for (int i = 3; i >= 1; i--) {
+            executorService->execute(Delayed::of(i * 100, Runnable::of([begin, i, &pending] {
+                cout << "Delayed task " << i << " after " << System::currentTimeMillis() - begin << " ms" << endl;
+                pending.fetch_sub(1);
+            })));
+        }
+        while (pending.load() != 0) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        executorService->shutdown();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    demo_priority_queue::demoPriorityBlockingQueue();
+    demo_priority_queue::demoDelayQueue();
+    demo_priority_queue::demoPriorityExecutor(0);
+    demo_priority_queue::demoPriorityExecutor(1);
+    demo_priority_queue::demoDelayExecutor(0);
+    demo_priority_queue::demoDelayExecutor(1);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <BlockingQueue.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_queue_benchmark {
+
+    class Message : extends Object {
+    public:
+        Message(int value) : value(value) {}
+        int value;
+    };
+
+    const int MESSAGE_COUNT = 1 << 18;
+    const int QUEUE_CAPACITY = 1024;
+
+    // 返回threadCount个生产者和threadCount个消费者传递所有消息所花费的毫秒数
+    int64_t measure(Ref<BlockingQueue<Message>> queue, RefArr<Message> messages, int threadCount) {
+        int countPerThread = messages.length() / threadCount;
+        atomic<long> sum(0);
+        vector<thread> threads;
+        int64_t start = System::currentTimeMillis();
+        for (int t = 0; t < threadCount; t++) {
+            threads.emplace_back([=] {
+                for (int i = t * countPerThread; i < (t + 1) * countPerThread; i++) {
+                    queue->put(messages[i]);
+                }
+            });
+            threads.emplace_back([=, &sum] {
+                long localSum = 0;
+                for (int i = 0; i < countPerThread; i++) {
+                    localSum += queue->take()->value;
+                }
+                sum += localSum;
+            });
+        }
+        for (thread &t : threads) {
+            t.join();
+        }
+        int64_t millis = System::currentTimeMillis() - start;
+        if (sum != (long)messages.length() * (messages.length() - 1) / 2) {
+            cout << "Some messages are lost" << endl;
+        }
+        return millis;
+    }
+}
+
+using namespace demo_queue_benchmark;
+
+int main(int argc, char *argv[]) {
+    RefArr<Message> messages = RefArray<Message>::newInstance(MESSAGE_COUNT);
+    for (int i = 0; i < MESSAGE_COUNT; i++) {
+        messages[i] = new_<Message>(i);
+    }
+    cout << "Transfer " << MESSAGE_COUNT << " messages through a queue whose capacity is " << QUEUE_CAPACITY << endl;
+    cout << setw(24) << "Producers/Consumers"
+         << setw(24) << "ArrayBlockingQueue"
+         << setw(24) << "LinkedBlockingQueue"
+         << setw(32) << "ConcurrentArrayBlockingQueue" << endl;
+    for (int threadCount = 1; threadCount <= 64; threadCount *= 2) {
+        int64_t lockBasedMillis = measure(new_<ArrayBlockingQueue<Message>>(QUEUE_CAPACITY), messages, threadCount);
+        int64_t twoLockMillis = measure(new_<LinkedBlockingQueue<Message>>(QUEUE_CAPACITY), messages, threadCount);
+        int64_t lockFreeMillis = measure(new_<ConcurrentArrayBlockingQueue<Message>>(QUEUE_CAPACITY), messages, threadCount);
+        ostringstream threads, lockBased, twoLock, lockFree;
+        threads << threadCount << '/' << threadCount;
+        lockBased << lockBasedMillis << "ms";
+        twoLock << twoLockMillis << "ms";
+        lockFree << lockFreeMillis << "ms";
+        cout << setw(24) << threads.str() << setw(24) << lockBased.str() << setw(24) << twoLock.str() << setw(32) << lockFree.str() << endl;
+    }
+    return 0;
+}
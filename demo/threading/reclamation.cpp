@@ -0,0 +1,134 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <Reclamation.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_reclamation {
+
+    const int SLOT_COUNT = 16;
+    const int READER_COUNT = 4;
+    const int WRITER_COUNT = 2;
+    const int REPLACE_COUNT = 100000;
+
+    AtomicInteger createdCount(0);
+    AtomicInteger finalizedCount(0);
+
+    // 无锁结构中的节点, 引用计数耗尽后由Reclamation推迟到所有读者离开之后才finalize并析构
+    class Node : extends Reclaimable {
+    public:
+        Node(int value) : value(value), checksum(~value) {
+            ++createdCount;
+        }
+        ~Node() {
+            this->value = -1;
+            this->checksum = -1;
+        }
+        int getValue() const {
+            return this->value;
+        }
+        bool isIntact() const {
+            return this->checksum == ~this->value;
+        }
+    protected:
+        virtual void finalize() override {
+            ++finalizedCount;
+            Reclaimable::finalize();
+        }
+    private:
+        int value;
+        int checksum;
+    };
+
+    // 每个槽持有其节点的一个引用, 替换之后释放旧节点的引用
+    void replace(atomic<Node*> &slot, int value) {
+        Ref<Node> node = new_<Node>(value);
+        node->retain();
+        Node *old = slot.exchange(node.get());
+        old->release();
+    }
+
+    // 当前线程自己就是读者: 临界区内被释放的节点不会被回收, 离开临界区之后才会
+    void demoDeferredFinalize() {
+        atomic<Node*> slot(nullptr);
+        Ref<Node> first = new_<Node>(1);
+        first->retain();
+        slot.store(first.get());
+        first = nullptr;
+        int finalizedBefore = finalizedCount.load();
+        {
+            Reclamation::EpochGuard guard;
+            Node *seen = slot.load();
+            replace(slot, 2);
+            Reclamation::flush();
+            cout << "Inside epoch guard: finalized = " << finalizedCount.load() - finalizedBefore
+                 << ", seen value = " << seen->getValue() << ", intact = " << seen->isIntact() << endl;
+        }
+        Reclamation::flush();
+        cout << "After epoch guard: finalized = " << finalizedCount.load() - finalizedBefore << endl;
+        slot.load()->release();
+        Reclamation::flush();
+    }
+
+    // 读者在纪元临界区内遍历所有槽, 写者同时不停地替换并释放旧节点
+    void demoConcurrentReaders() {
+        atomic<Node*> slots[SLOT_COUNT];
+        for (int i = 0; i < SLOT_COUNT; i++) {
+            Ref<Node> node = new_<Node>(i);
+            node->retain();
+            slots[i].store(node.get());
+        }
+        AtomicBoolean stopped(false);
+        AtomicInteger brokenCount(0);
+        AtomicInteger releasedCount(0);
+        AtomicInteger maxPendingCount(0);
+        vector<thread> readers;
+        for (int r = 0; r < READER_COUNT; r++) {
+            readers.emplace_back([&slots, &stopped, &brokenCount] {
+                while (!stopped) {
+                    Reclamation::EpochGuard guard;
+                    for (int i = 0; i < SLOT_COUNT; i++) {
+                        if (!slots[i].load()->isIntact()) {
+                            ++brokenCount;
+                        }
+                    }
+                }
+            });
+        }
+        vector<thread> writers;
+        for (int w = 0; w < WRITER_COUNT; w++) {
+            writers.emplace_back([&slots, &releasedCount, &maxPendingCount, w] {
+                for (int i = 0; i < REPLACE_COUNT; i++) {
+                    replace(slots[(i + w) % SLOT_COUNT], i);
+                    int pending = ++releasedCount - finalizedCount.load();
+                    int maxPending = maxPendingCount.load();
+                    while (pending > maxPending && !maxPendingCount.compare_exchange_weak(maxPending, pending));
+                }
+            });
+        }
+        for (thread &writer : writers) {
+            writer.join();
+        }
+        stopped.store(true);
+        for (thread &reader : readers) {
+            reader.join();
+        }
+        for (int i = 0; i < SLOT_COUNT; i++) {
+            slots[i].load()->release();
+        }
+        // 已退出的写者线程未能回收的节点被移交给其他线程, 在此由主线程回收
+        Reclamation::flush();
+        cout << "Concurrent readers: broken = " << brokenCount.load()
+             << ", max pending finalizations = " << maxPendingCount.load() << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    demo_reclamation::demoDeferredFinalize();
+    demo_reclamation::demoConcurrentReaders();
+    cout << "Created: " << demo_reclamation::createdCount.load()
+         << ", finalized: " << demo_reclamation::finalizedCount.load() << endl;
+    return 0;
+}
@@ -42,7 +42,7 @@ int main(int argc, char *argv[]) {
     scheduledFuture->cancel(); //Cancel "fixedRateAtFixedRate" to prepare "scheduledWithFixedDelay"
 
     cout << "--------------------sheduleWithFixedDelay--------------------" << endl;
-    scheduledExecutorService->scheduleWithFixedDelay(
+    scheduledFuture = scheduledExecutorService->scheduleWithFixedDelay(
         Runnable::of([=] {
             threadSafeOutputWithTime("Scheduled task with fixed delay: 500ms");
             this_thread::sleep_for(chrono::milliseconds(500));
@@ -51,6 +51,35 @@ int main(int argc, char *argv[]) {
         1000
     );
     this_thread::sleep_for(chrono::milliseconds(5 * 1000 + 100));
+    scheduledFuture->cancel();
+
+    cout << "--------------------sub-millisecond fixed rate--------------------" << endl;
+    // 时间轮精度为100微秒; 第n次执行的计划时刻总是起点 + n * 周期, 误差不会累积
+    Ref<ScheduledExecutorService> preciseExecutorService =
+        new_<ScheduledExecutorService>(1, true, nullptr, chrono::microseconds(100));
+    const int64_t periodNanos = 2500 * 1000;
+    int64_t startNanos = System::nanoTime() + periodNanos;
+    AtomicInteger count;
+    AtomicInteger *countPointer = &count;
+    atomic<int64_t> maxLateness { 0 };
+    atomic<int64_t> *maxLatenessPointer = &maxLateness;
+    Ref<ScheduledFuture> preciseFuture = preciseExecutorService->scheduleAtFixedRate(
+        Runnable::of([=] {
+            int n = countPointer->fetch_add(1);
+            int64_t lateness = System::nanoTime() - (startNanos + n * periodNanos);
+            if (lateness > maxLatenessPointer->load()) {
+                maxLatenessPointer->store(lateness); //同一个任务不会并发执行
+            }
+        }),
+        chrono::nanoseconds(periodNanos),
+        chrono::nanoseconds(periodNanos)
+    );
+    this_thread::sleep_for(chrono::seconds(2));
+    preciseFuture->cancel();
+    this_thread::sleep_for(chrono::milliseconds(10));
+    ostringstream oss;
+    oss << "Executed " << count << " times at 2.5ms, max lateness: " << maxLateness / 1000 << "us";
+    threadSafeOutputWithTime(oss.str());
 
     return 0;
 }
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <BlockingQueue.h>
+#include <SpscQueue.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_spsc {
+
+    // 解析线程产生的记录, 交给写入线程
+    class Record : extends Object {
+    public:
+        Record(long id) : id(id) {}
+        long id;
+    };
+
+    const int RECORD_COUNT = 1 << 20;
+    const int QUEUE_CAPACITY = 1024;
+    const int BATCH_SIZE = 64;
+
+    RefArr<Record> parse() {
+        RefArr<Record> records = RefArray<Record>::newInstance(RECORD_COUNT);
+        for (int i = 0; i < RECORD_COUNT; i++) {
+            records[i] = new_<Record>(i);
+        }
+        return records;
+    }
+
+    void report(const char *name, int64_t millis, long sum) {
+        bool correct = sum == (long)RECORD_COUNT * (RECORD_COUNT - 1) / 2;
+        cout << name << ": " << millis << "ms" << (correct ? "" : ", some records are lost") << endl;
+    }
+
+    void handOffByArrayBlockingQueue(RefArr<Record> records) {
+        Ref<BlockingQueue<Record>> queue = new_<ArrayBlockingQueue<Record>>(QUEUE_CAPACITY);
+        long sum = 0;
+        int64_t start = System::currentTimeMillis();
+        thread writer([&] {
+            for (int i = 0; i < RECORD_COUNT; i++) {
+                sum += queue->take()->id;
+            }
+        });
+        for (Ref<Record> &record : records) {
+            queue->put(record);
+        }
+        writer.join();
+        report("ArrayBlockingQueue", System::currentTimeMillis() - start, sum);
+    }
+
+    void handOffBySpscQueue(RefArr<Record> records, WaitStrategy waitStrategy, const char *name) {
+        Ref<SpscQueue<Ref<Record>>> queue = new_<SpscQueue<Ref<Record>>>(QUEUE_CAPACITY, waitStrategy);
+        long sum = 0;
+        int64_t start = System::currentTimeMillis();
+        thread writer([&] {
+            for (int i = 0; i < RECORD_COUNT; i++) {
+                sum += queue->take()->id;
+            }
+        });
+        for (Ref<Record> &record : records) {
+            queue->put(record);
+        }
+        writer.join();
+        report(name, System::currentTimeMillis() - start, sum);
+    }
+
+    void handOffBySpscQueueInBatch(RefArr<Record> records) {
+        Ref<SpscQueue<Ref<Record>>> queue = new_<SpscQueue<Ref<Record>>>(QUEUE_CAPACITY);
+        long sum = 0;
+        int64_t start = System::currentTimeMillis();
+        thread writer([&] {
+            vector<Ref<Record>> batch;
+            for (int count = 0; count < RECORD_COUNT; ) {
+                batch.clear();
+                count += queue->takeAll(batch, BATCH_SIZE);
+                for (const Ref<Record> &record : batch) {
+                    sum += record->id;
+                }
+            }
+        });
+        for (int i = 0; i < RECORD_COUNT; i += BATCH_SIZE) {
+            queue->putAll(records->unsafe() + i, min(BATCH_SIZE, RECORD_COUNT - i));
+        }
+        writer.join();
+        report("SpscQueue<Ref<Record>>, batch", System::currentTimeMillis() - start, sum);
+    }
+
+    // 元素为POD时直接存放在环形缓冲区中, 完全不涉及引用计数
+    void handOffPodBySpscQueueInBatch() {
+        Ref<SpscQueue<long>> queue = new_<SpscQueue<long>>(QUEUE_CAPACITY);
+        long sum = 0;
+        int64_t start = System::currentTimeMillis();
+        thread writer([&] {
+            vector<long> batch;
+            for (int count = 0; count < RECORD_COUNT; ) {
+                batch.clear();
+                count += queue->takeAll(batch, BATCH_SIZE);
+                for (long id : batch) {
+                    sum += id;
+                }
+            }
+        });
+        long ids[BATCH_SIZE];
+        for (int i = 0; i < RECORD_COUNT; i += BATCH_SIZE) {
+            for (int j = 0; j < BATCH_SIZE; j++) {
+                ids[j] = i + j;
+            }
+            queue->putAll(ids, BATCH_SIZE);
+        }
+        writer.join();
+        report("SpscQueue<long>, batch", System::currentTimeMillis() - start, sum);
+    }
+}
+
+using namespace demo_spsc;
+
+int main(int argc, char *argv[]) {
+    RefArr<Record> records = parse();
+    cout << "Hand off " << RECORD_COUNT << " records from a parser thread to a writer thread" << endl;
+    handOffByArrayBlockingQueue(records);
+    handOffBySpscQueue(records, WaitStrategy::BLOCKING, "SpscQueue<Ref<Record>>, blocking");
+    handOffBySpscQueue(records, WaitStrategy::YIELDING, "SpscQueue<Ref<Record>>, yielding");
+    handOffBySpscQueueInBatch(records);
+    handOffPodBySpscQueueInBatch();
+    return 0;
+}
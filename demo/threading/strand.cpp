@@ -0,0 +1,103 @@
+#include <iostream>
+#include <vector>
+#include <SerialExecutor.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_strand {
+
+    const int ACCOUNT_COUNT = 8;
+    const int TRANSFER_COUNT = 200000;
+
+    // 账户的余额只在自己的strand中被修改, 不需要加锁
+    class Account : extends Object {
+    public:
+        Account(Ref<Executor> executor) : strand(new_<SerialExecutor>(executor)) {}
+
+        void deposit(long amount, AtomicInteger *pending) {
+            Ref<Account> self = this;
+            this->strand->execute(Runnable::of([self, amount, pending] {
+                self->balance += amount;
+                self->operationCount++;
+                pending->fetch_sub(1);
+            }));
+        }
+
+        long getBalance() const {
+            return this->balance;
+        }
+
+        long getOperationCount() const {
+            return this->operationCount;
+        }
+
+    private:
+        Ref<SerialExecutor> strand;
+        long balance = 0;
+        long operationCount = 0;
+    };
+
+    void demoStrand(Ref<ExecutorService> executorService) {
+        vector<Ref<Account>> accounts;
+        for (int i = 0; i < ACCOUNT_COUNT; i++) {
+            accounts.push_back(new_<Account>(executorService));
+        }
+        AtomicInteger pending(TRANSFER_COUNT * 2);
+        int64_t begin = System::currentTimeMillis();
+        vector<thread> producers;
+        for (int p = 0; p < 2; p++) {
+            producers.emplace_back([&accounts, &pending, p] {
+                for (int i = 0; i < TRANSFER_COUNT; i++) {
+                    accounts[(i + p) % ACCOUNT_COUNT]->deposit(i % 10 + 1, &pending);
+                }
+            });
+        }
+        for (thread &producer : producers) {
+            producer.join();
+        }
+        while (pending.load() != 0) {
+            this_thread::yield();
+        }
+        long total = 0;
+        for (Ref<Account> &account : accounts) {
+            total += account->getBalance();
+            cout << "Account balance: " << account->getBalance() << ", operations: " << account->getOperationCount() << endl;
+        }
+        cout << "Total: " << total << ", elapsed: " << System::currentTimeMillis() - begin << " ms" << endl;
+    }
+
+    // Mailbox: 多个线程投递日志行, 由同一个handler按顺序写出
+    void demoMailbox(Ref<ExecutorService> executorService) {
+        AtomicInteger pending(6);
+        Ref<Mailbox<string>> logMailbox = Mailbox<string>::of(
+            Consumer<string>::of([&pending](string line) {
+                cout << "[log] " << line << endl;
+                pending.fetch_sub(1);
+            }),
+            executorService
+        );
+        vector<thread> writers;
+        for (int w = 0; w < 2; w++) {
+            writers.emplace_back([logMailbox, w] {
+                for (int i = 0; i < 3; i++) {
+                    logMailbox->post("writer-" + to_string(w) + " line " + to_string(i));
+                }
+            });
+        }
+        for (thread &writer : writers) {
+            writer.join();
+        }
+        while (pending.load() != 0) {
+            this_thread::yield();
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Ref<ExecutorService> executorService = new_<ExecutorService>(4);
+    demo_strand::demoStrand(executorService);
+    demo_strand::demoMailbox(executorService);
+    executorService->shutdown();
+    return 0;
+}
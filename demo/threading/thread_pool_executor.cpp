@@ -0,0 +1,62 @@
+#include <iostream>
+#include <thread>
+#include <ThreadPoolExecutor.h>
+
+using namespace std;
+using namespace com_lanjing_cpp_common;
+
+namespace demo_thread_pool_executor {
+
+    void printPool(const char *moment, Ref<ThreadPoolExecutor> executor) {
+        cout << moment << ": poolSize=" << executor->getPoolSize()
+             << ", activeCount=" << executor->getActiveCount()
+             << ", queueSize=" << executor->getQueue()->size()
+             << ", completedTaskCount=" << executor->getCompletedTaskCount() << endl;
+    }
+
+    Ref<Runnable> slowTask(atomic<int> *counter) {
+        return Runnable::of([=] {
+            this_thread::sleep_for(chrono::milliseconds(10));
+            (*counter)++;
+        });
+    }
+}
+
+using namespace demo_thread_pool_executor;
+
+int main(int argc, char *argv[]) {
+    // 2个核心线程, 最多8个线程, 空闲超过200毫秒的非核心线程退出, 队列最多容纳16个任务
+    Ref<ThreadPoolExecutor> executor = new_<ThreadPoolExecutor>(2, 8, 200, 16, RejectionPolicy::CALLER_RUNS);
+    cout << "Prestarted " << executor->prestartAllCoreThreads() << " core threads" << endl;
+
+    // 突发的1000个任务: 队列满后线程数增长到8个; 仍然处理不过来时由提交者自己执行任务, 提交者因此而慢下来(背压)
+    atomic<int> counter(0);
+    int64_t start = System::currentTimeMillis();
+    for (int i = 0; i < 1000; i++) {
+        executor->execute(slowTask(&counter));
+    }
+    cout << "Submitting 1000 tasks took " << System::currentTimeMillis() - start << "ms" << endl;
+    printPool("After the burst", executor);
+
+    this_thread::sleep_for(chrono::milliseconds(500));
+    printPool("After keep-alive time", executor);
+
+    // ABORT策略: 无法接受的任务抛出RejectedExecutionException
+    Ref<ThreadPoolExecutor> strictExecutor = new_<ThreadPoolExecutor>(1, 1, 0, 1);
+    atomic<int> strictCounter(0);
+    int rejectedCount = 0;
+    for (int i = 0; i < 10; i++) {
+        try_ {
+            strictExecutor->execute(slowTask(&strictCounter));
+        } catch_(RejectedExecutionException, ex) {
+            rejectedCount++;
+        } end_try
+    }
+    cout << rejectedCount << " of 10 tasks are rejected" << endl;
+
+    executor->shutdown();
+    strictExecutor->shutdown();
+    bool terminated = executor->awaitTermination(5000) && strictExecutor->awaitTermination(5000);
+    cout << "Terminated: " << terminated << ", " << counter << " + " << strictCounter << " tasks are executed" << endl;
+    return 0;
+}
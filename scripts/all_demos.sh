@@ -15,14 +15,29 @@ function help {
     echo "    2.1 Demo about exception chain"
     echo "    2.2 Demo about how to catch and rethrow exception"
     echo "    2.3 Demo about how to use macro 'defer' to make up for the fact that C++ does not support 'finally'"
-    echo "3. Array demo"
+    echo "3. Array demos"
+    echo "    3.1 Demo about array basics"
+    echo "    3.2 Demo about lazy and parallel stream"
     echo "4. Functional interface demos"
     echo "    4.1 Demo about how to combine and split functional interfaces by '+', '-', '+=', '-='"
     echo "    4.2 Demo about how to use functional interface to support java bean event"
+    echo "    4.3 Demo about asynchronous event dispatch"
+    echo "    4.4 Benchmark of combined functional interfaces"
     echo "5. Multiple threads demos"
     echo "    5.1 Demo about blocking queue"
     echo "    5.2 Demo about simple thread pool"
     echo "    5.3 Demo about scheduled thread pool"
+    echo "    5.4 Demo about CompletableFuture"
+    echo "    5.5 Demo about C++20 coroutines"
+    echo "    5.6 Benchmark of lock-based and lock-free blocking queues"
+    echo "    5.7 Demo about single-producer/single-consumer queue"
+    echo "    5.8 Benchmark of work-stealing ForkJoinPool"
+    echo "    5.9 Demo about elastic ThreadPoolExecutor"
+    echo "    5.10 Demo about parallel loops"
+    echo "    5.11 Demo about strands and mailboxes"
+    echo "    5.12 Demo about priority and delay queues"
+    echo "    5.13 Demo about AtomicRef"
+    echo "    5.14 Demo about epoch-based reclamation"
     echo "6. Logging demo"
     echo "7. HTTP demo (Please install curl first because it requires '*.h' and '*.so' of libcurl)"
     echo "8. Database demo (Please install sqlite3 first because it requires '*.h' and '*.so' of libsqlite3)"
@@ -87,13 +102,25 @@ function exception_finally {
 }
 
 function array {
-    demo_header "3. Array demo"
+    array_simple
+    array_stream
+}
+
+function array_simple {
+    demo_header "3.1 Demo about array basics"
     ./array_simple.sh
 }
 
+function array_stream {
+    demo_header "3.2 Demo about lazy and parallel stream"
+    ./array_stream.sh
+}
+
 function functional {
     functional_simple
     functional_event
+    functional_async_event
+    functional_benchmark
 }
 
 function functional_simple {
@@ -106,10 +133,31 @@ function functional_event {
     ./functional_event.sh
 }
 
+function functional_async_event {
+    demo_header "4.3 Demo about asynchronous event dispatch"
+    ./functional_async_event.sh
+}
+
+function functional_benchmark {
+    demo_header "4.4 Benchmark of combined functional interfaces"
+    ./functional_benchmark.sh
+}
+
 function threading {
     threading_queue
     threading_pool
     threading_scheduler
+    threading_future
+    threading_coroutine
+    threading_queue_benchmark
+    threading_spsc
+    threading_fork_join
+    threading_thread_pool_executor
+    threading_parallel
+    threading_strand
+    threading_priority_queue
+    threading_atomic_ref
+    threading_reclamation
 }
 
 function threading_queue {
@@ -127,6 +175,61 @@ function threading_scheduler {
     ./threading_scheduler.sh
 }
 
+function threading_future {
+    demo_header "5.4 Demo about CompletableFuture"
+    ./threading_future.sh
+}
+
+function threading_coroutine {
+    demo_header "5.5 Demo about C++20 coroutines"
+    ./threading_coroutine.sh
+}
+
+function threading_queue_benchmark {
+    demo_header "5.6 Benchmark of lock-based and lock-free blocking queues"
+    ./threading_queue_benchmark.sh
+}
+
+function threading_spsc {
+    demo_header "5.7 Demo about single-producer/single-consumer queue"
+    ./threading_spsc.sh
+}
+
+function threading_fork_join {
+    demo_header "5.8 Benchmark of work-stealing ForkJoinPool"
+    ./threading_fork_join.sh
+}
+
+function threading_thread_pool_executor {
+    demo_header "5.9 Demo about elastic ThreadPoolExecutor"
+    ./threading_thread_pool_executor.sh
+}
+
+function threading_parallel {
+    demo_header "5.10 Demo about parallel loops"
+    ./threading_parallel.sh
+}
+
+function threading_strand {
+    demo_header "5.11 Demo about strands and mailboxes"
+    ./threading_strand.sh
+}
+
+function threading_priority_queue {
+    demo_header "5.12 Demo about priority and delay queues"
+    ./threading_priority_queue.sh
+}
+
+function threading_atomic_ref {
+    demo_header "5.13 Demo about AtomicRef"
+    ./threading_atomic_ref.sh
+}
+
+function threading_reclamation {
+    demo_header "5.14 Demo about epoch-based reclamation"
+    ./threading_reclamation.sh
+}
+
 function logging {
     demo_header "6. Logging"
     ./logging_simple.sh
@@ -181,6 +284,12 @@ while true; do
     3)
         array
         ;;
+    3.1)
+        array_simple
+        ;;
+    3.2)
+        array_stream
+        ;;
     4)
         functional
         ;;
@@ -190,6 +299,12 @@ while true; do
     4.2)
         functional_event
         ;;
+    4.3)
+        functional_async_event
+        ;;
+    4.4)
+        functional_benchmark
+        ;;
     5)
         threading
         ;;
@@ -202,6 +317,39 @@ while true; do
     5.3)
         threading_scheduler
         ;;
+    5.4)
+        threading_future
+        ;;
+    5.5)
+        threading_coroutine
+        ;;
+    5.6)
+        threading_queue_benchmark
+        ;;
+    5.7)
+        threading_spsc
+        ;;
+    5.8)
+        threading_fork_join
+        ;;
+    5.9)
+        threading_thread_pool_executor
+        ;;
+    5.10)
+        threading_parallel
+        ;;
+    5.11)
+        threading_strand
+        ;;
+    5.12)
+        threading_priority_queue
+        ;;
+    5.13)
+        threading_atomic_ref
+        ;;
+    5.14)
+        threading_reclamation
+        ;;
     6)
         logging
         ;;
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/array/stream.*
+mkdir -p ../build/array/
+g++ -c -I ../src -DDEBUG -std=c++11 -o ../build/array/stream.o ../demo/array/stream.cpp
+g++ ../build/array/stream.o -lpthread -o ../build/array/stream.exe 
+../build/array/stream.exe
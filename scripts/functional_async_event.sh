@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/functional/async_event.*
+mkdir -p ../build/functional/
+g++ -c -I ../src -DDEBUG -std=c++11 -o ../build/functional/async_event.o ../demo/functional/async_event.cpp
+g++ ../build/functional/async_event.o -lpthread -o ../build/functional/async_event.exe 
+../build/functional/async_event.exe
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/functional/benchmark.*
+mkdir -p ../build/functional/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/functional/benchmark.o ../demo/functional/benchmark.cpp
+g++ ../build/functional/benchmark.o -lpthread -o ../build/functional/benchmark.exe 
+../build/functional/benchmark.exe
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/atomic_ref.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/atomic_ref.o ../demo/threading/atomic_ref.cpp
+g++ ../build/threading/atomic_ref.o -lpthread -o ../build/threading/atomic_ref.exe 
+../build/threading/atomic_ref.exe
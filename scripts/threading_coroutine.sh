@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/coroutine.*
+mkdir -p ../build/threading/
+g++ -c -I ../src -DDEBUG -std=c++20 -o ../build/threading/coroutine.o ../demo/threading/coroutine.cpp
+g++ ../build/threading/coroutine.o -lpthread -o ../build/threading/coroutine.exe 
+../build/threading/coroutine.exe
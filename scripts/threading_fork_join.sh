@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/fork_join.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/fork_join.o ../demo/threading/fork_join.cpp
+g++ ../build/threading/fork_join.o -lpthread -o ../build/threading/fork_join.exe 
+../build/threading/fork_join.exe
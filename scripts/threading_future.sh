@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/future.*
+mkdir -p ../build/threading/
+g++ -c -I ../src -DDEBUG -std=c++11 -o ../build/threading/future.o ../demo/threading/future.cpp
+g++ ../build/threading/future.o -lpthread -o ../build/threading/future.exe 
+../build/threading/future.exe
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/parallel.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/parallel.o ../demo/threading/parallel.cpp
+g++ ../build/threading/parallel.o -lpthread -o ../build/threading/parallel.exe 
+../build/threading/parallel.exe
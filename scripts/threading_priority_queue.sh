@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/priority_queue.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/priority_queue.o ../demo/threading/priority_queue.cpp
+g++ ../build/threading/priority_queue.o -lpthread -o ../build/threading/priority_queue.exe 
+../build/threading/priority_queue.exe
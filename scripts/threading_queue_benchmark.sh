@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/queue_benchmark.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/queue_benchmark.o ../demo/threading/queue_benchmark.cpp
+g++ ../build/threading/queue_benchmark.o -lpthread -o ../build/threading/queue_benchmark.exe 
+../build/threading/queue_benchmark.exe
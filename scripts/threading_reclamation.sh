@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/reclamation.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/reclamation.o ../demo/threading/reclamation.cpp
+g++ ../build/threading/reclamation.o -lpthread -o ../build/threading/reclamation.exe 
+../build/threading/reclamation.exe
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/spsc.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/spsc.o ../demo/threading/spsc.cpp
+g++ ../build/threading/spsc.o -lpthread -o ../build/threading/spsc.exe 
+../build/threading/spsc.exe
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/strand.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/strand.o ../demo/threading/strand.cpp
+g++ ../build/threading/strand.o -lpthread -o ../build/threading/strand.exe 
+../build/threading/strand.exe
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+rm -f ../build/threading/thread_pool_executor.*
+mkdir -p ../build/threading/
+g++ -c -O2 -I ../src -DDEBUG -std=c++11 -o ../build/threading/thread_pool_executor.o ../demo/threading/thread_pool_executor.cpp
+g++ ../build/threading/thread_pool_executor.o -lpthread -o ../build/threading/thread_pool_executor.exe 
+../build/threading/thread_pool_executor.exe
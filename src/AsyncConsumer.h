@@ -0,0 +1,416 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "ExecutorService.h"
+#include <tuple>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+
+namespace com_lanjing_cpp_common {
+
+    using namespace std;
+
+    // 缓冲区满时accept的行为
+    enum class OverflowPolicy {
+        BLOCK, //阻塞调用者直到有空间(在投递线程中调用时除外, 否则会自己等待自己)
+        DISCARD_OLDEST, //丢弃最早的未投递事件
+        DISCARD_NEWEST //丢弃当前事件
+    };
+
+    // C++11中没有std::index_sequence, 用于把tuple展开为参数列表
+    template <int ...I> struct _IndexSequence {};
+    template <int N, int ...I> struct _MakeIndexSequence : _MakeIndexSequence<N - 1, N - 1, I...> {};
+    template <int ...I> struct _MakeIndexSequence<0, I...> {
+        typedef _IndexSequence<I...> Type;
+    };
+
+    template <typename F, typename T, int ...I>
+    auto _invokeWithTuple(F &function, T &&arguments, _IndexSequence<I...>) -> decltype(function(get<I>(arguments)...)) {
+        return function(get<I>(arguments)...);
+    }
+
+    template <typename F, typename ...Args>
+    auto _invokeWithTuple(F &function, const tuple<Args...> &arguments)
+            -> decltype(_invokeWithTuple(function, arguments, typename _MakeIndexSequence<sizeof...(Args)>::Type())) {
+        return _invokeWithTuple(function, arguments, typename _MakeIndexSequence<sizeof...(Args)>::Type());
+    }
+
+    // 未投递事件的缓冲区
+    template <typename ...Args>
+    struct _EventBuffer {
+        virtual ~_EventBuffer() {}
+        virtual int size() const = 0;
+        virtual void add(tuple<Args...> &&event) = 0;
+        virtual void discardOldest() = 0;
+        virtual void drainTo(vector<tuple<Args...>> &batch, int maxSize) = 0;
+    };
+
+    template <typename ...Args>
+    class _FifoEventBuffer : public _EventBuffer<Args...> {
+    public:
+        virtual int size() const override {
+            return (int)this->events.size();
+        }
+        virtual void add(tuple<Args...> &&event) override {
+            this->events.push_back(move(event));
+        }
+        virtual void discardOldest() override {
+            this->events.pop_front();
+        }
+        virtual void drainTo(vector<tuple<Args...>> &batch, int maxSize) override {
+            while (!this->events.empty() && (int)batch.size() < maxSize) {
+                batch.push_back(move(this->events.front()));
+                this->events.pop_front();
+            }
+        }
+    private:
+        list<tuple<Args...>> events;
+    };
+
+    // 同一个键的未投递事件只保留最新的一个, 但保持该键第一次出现时的位置
+    template <typename K, typename ...Args>
+    class _CoalescingEventBuffer : public _EventBuffer<Args...> {
+    public:
+        _CoalescingEventBuffer(const function<K(const Args&...)> &keyOf) : keyOf(keyOf) {}
+        virtual int size() const override {
+            return (int)this->events.size();
+        }
+        virtual void add(tuple<Args...> &&event) override {
+            K key = _invokeWithTuple(this->keyOf, event);
+            auto itr = this->indexes.find(key);
+            if (itr != this->indexes.end()) {
+                itr->second->second = move(event);
+            } else {
+                this->events.push_back(make_pair(key, move(event)));
+                this->indexes[key] = --this->events.end();
+            }
+        }
+        virtual void discardOldest() override {
+            this->indexes.erase(this->events.front().first);
+            this->events.pop_front();
+        }
+        virtual void drainTo(vector<tuple<Args...>> &batch, int maxSize) override {
+            while (!this->events.empty() && (int)batch.size() < maxSize) {
+                batch.push_back(move(this->events.front().second));
+                this->discardOldest();
+            }
+        }
+    private:
+        function<K(const Args&...)> keyOf;
+        list<pair<K, tuple<Args...>>> events;
+        map<K, typename list<pair<K, tuple<Args...>>>::iterator> indexes;
+    };
+
+    /**
+     * 异步的Consumer包装, 用于Java Bean事件等场景: 修改模型的线程调用accept时只是把事件放入缓冲区,
+     * 真正的监听者在Executor(或专用线程)中被调用, 慢速的监听者不会再拖慢修改模型的线程
+     *
+     * 1. 事件按顺序投递, 且同一时刻最多只有一个投递任务, 所以监听者无需考虑并发
+     * 2. 投递任务一次从缓冲区中取出至多maxBatchSize个事件, 可以逐个投递给Consumer<Args...>,
+     *    也可以一次性投递给批量监听者Consumer<const vector<tuple<Args...>>&>; 每批之后重新提交投递任务, 不会独占共享线程池
+     * 3. coalescing版本对同一个键的未投递事件只保留最新的一个(latest-wins), 例如属性变更事件只关心最终值
+     * 4. capacity大于0时缓冲区有界, 满时按OverflowPolicy阻塞调用者或丢弃事件
+     *
+     *     Ref<AsyncConsumer<Ref<NameChangedEventArgs>>> asyncListener =
+     *         AsyncConsumer<Ref<NameChangedEventArgs>>::of(listener, executorService);
+     *     person->addNameChangedListener(asyncListener);
+     */
+    template <typename ...Args>
+    class AsyncConsumer : extends Object, implements Consumer<Args...> {
+    public:
+        typedef Consumer<const vector<tuple<Args...>>&> BatchConsumer;
+
+        // executor为nullptr时使用专用线程
+        static Ref<AsyncConsumer<Args...>> of(
+                Ref<Consumer<Args...>> target,
+                Ref<Executor> executor = nullptr,
+                int capacity = 0,
+                OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK,
+                int maxBatchSize = 64) {
+            if (target == nullptr) {
+                throw_new(NullPointerException, "target cannot be nullptr");
+            }
+            return new_<AsyncConsumer<Args...>>(
+                    target,
+                    nullptr,
+                    unique_ptr<_EventBuffer<Args...>>(new _FifoEventBuffer<Args...>()),
+                    executor,
+                    capacity,
+                    overflowPolicy,
+                    maxBatchSize
+            );
+        }
+
+        static Ref<AsyncConsumer<Args...>> ofBatch(
+                Ref<BatchConsumer> batchTarget,
+                Ref<Executor> executor = nullptr,
+                int capacity = 0,
+                OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK,
+                int maxBatchSize = 64) {
+            if (batchTarget == nullptr) {
+                throw_new(NullPointerException, "batchTarget cannot be nullptr");
+            }
+            return new_<AsyncConsumer<Args...>>(
+                    nullptr,
+                    batchTarget,
+                    unique_ptr<_EventBuffer<Args...>>(new _FifoEventBuffer<Args...>()),
+                    executor,
+                    capacity,
+                    overflowPolicy,
+                    maxBatchSize
+            );
+        }
+
+        // keyOf(const Args&...)返回合并事件所用的键, 键类型需支持operator <
+        template <typename F>
+        static Ref<AsyncConsumer<Args...>> coalescing(
+                Ref<Consumer<Args...>> target,
+                F keyOf,
+                Ref<Executor> executor = nullptr,
+                int capacity = 0,
+                OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK,
+                int maxBatchSize = 64) {
+            if (target == nullptr) {
+                throw_new(NullPointerException, "target cannot be nullptr");
+            }
+            typedef typename decay<decltype(keyOf(declval<const Args&>()...))>::type K;
+            return new_<AsyncConsumer<Args...>>(
+                    target,
+                    nullptr,
+                    unique_ptr<_EventBuffer<Args...>>(new _CoalescingEventBuffer<K, Args...>(keyOf)),
+                    executor,
+                    capacity,
+                    overflowPolicy,
+                    maxBatchSize
+            );
+        }
+
+        virtual ~AsyncConsumer() {}
+
+        virtual void accept(Args ...args) override {
+            tuple<Args...> event(args...);
+            this->enqueue(&event, 1);
+        }
+
+        // 一次加锁, 至多一次调度地放入一批事件
+        void acceptAll(vector<tuple<Args...>> events) {
+            this->enqueue(events.data(), (int)events.size());
+        }
+
+        // 阻塞直到此前放入的所有事件都已投递完毕
+        void flush() {
+            Mutex::Scope scope(this->mutex);
+            while (this->scheduled) {
+                this->idleCondition->wait();
+            }
+        }
+
+        /*
+         * 投递完已放入的事件后关闭, 之后的accept会抛出IllegalStateException;
+         * 若使用的是专用线程, 还会等待该线程退出
+         */
+        void close() {
+            {
+                Mutex::Scope scope(this->mutex);
+                this->closed = true;
+            }
+            this->flush();
+            if (this->dedicatedExecutor != nullptr) {
+                this->dedicatedExecutor->shutdown();
+            }
+        }
+
+        int getPendingCount() {
+            Mutex::Scope scope(this->mutex);
+            return this->buffer->size();
+        }
+
+        AsyncConsumer(
+                Ref<Consumer<Args...>> target,
+                Ref<BatchConsumer> batchTarget,
+                unique_ptr<_EventBuffer<Args...>> buffer,
+                Ref<Executor> executor,
+                int capacity,
+                OverflowPolicy overflowPolicy,
+                int maxBatchSize) :
+            target(target),
+            batchTarget(batchTarget),
+            buffer(move(buffer)),
+            executor(executor),
+            capacity(capacity),
+            overflowPolicy(overflowPolicy),
+            maxBatchSize(maxBatchSize) {
+            if (maxBatchSize < 1) {
+                throw_new(IllegalArgumentException, "maxBatchSize cannot be less than 1");
+            }
+            if (this->executor == nullptr) {
+                this->executor = this->dedicatedExecutor = new_<ExecutorService>(1);
+            }
+            this->notFullCondition = new_<Condition>(this->mutex);
+            this->idleCondition = new_<Condition>(this->mutex);
+        }
+
+    private:
+        void enqueue(tuple<Args...> *events, int count) {
+            int index = 0;
+            for (;;) {
+                bool schedule = false;
+                {
+                    Mutex::Scope scope(this->mutex);
+                    if (this->closed) {
+                        throw_new(IllegalStateException, "The AsyncConsumer has been closed");
+                    }
+                    for (; index < count; index++) {
+                        if (this->capacity > 0 && this->buffer->size() >= this->capacity) {
+                            if (this->overflowPolicy == OverflowPolicy::DISCARD_NEWEST) {
+                                continue;
+                            }
+                            if (this->overflowPolicy == OverflowPolicy::DISCARD_OLDEST) {
+                                this->buffer->discardOldest();
+                            } else if (!pthread_equal(this->deliveringThread, pthread_self()) || !this->delivering) {
+                                if (!this->scheduled) { //阻塞前必须先调度投递任务, 而调度不能在持有锁时进行
+                                    this->scheduled = schedule = true;
+                                    break;
+                                }
+                                while (this->buffer->size() >= this->capacity && this->scheduled) {
+                                    this->notFullCondition->wait();
+                                }
+                                // 缓冲区非空时scheduled总为true, 除非投递任务被Executor丢弃
+                                if (this->buffer->size() >= this->capacity) {
+                                    throw_new(IllegalStateException, "The delivery task has been dropped by the executor");
+                                }
+                            }
+                        }
+                        this->buffer->add(move(events[index]));
+                    }
+                    if (!this->scheduled && this->buffer->size() != 0) {
+                        this->scheduled = schedule = true;
+                    }
+                }
+                if (schedule) {
+                    this->scheduleDelivery();
+                }
+                if (index == count) {
+                    return;
+                }
+            }
+        }
+
+        /*
+         * 投递任务可能不会被执行: execute抛出异常(例如ThreadPoolExecutor的ABORT策略), 已关闭的ExecutorService
+         * 直接忽略它, 或者关闭时丢弃了队列中的它. 这些情况下任务对象未执行就被销毁, 由析构函数清除scheduled,
+         * 否则flush, close和BLOCK策略下的生产者会永远等待
+         */
+        class DeliveryTask : extends Object, implements Runnable {
+        public:
+            DeliveryTask(Ref<AsyncConsumer<Args...>> owner) : owner(owner) {}
+            virtual ~DeliveryTask() {
+                if (!this->ran) {
+                    this->owner->onDeliveryDropped();
+                }
+            }
+            virtual void run() override {
+                this->ran = true;
+                this->owner->deliver();
+            }
+        private:
+            Ref<AsyncConsumer<Args...>> owner;
+            bool ran = false;
+            interface_refcount()
+        };
+
+        void scheduleDelivery() {
+            int droppedCount;
+            {
+                Mutex::Scope scope(this->mutex);
+                droppedCount = this->droppedDeliveryCount;
+            }
+            // 不保留任务的引用, 被同步丢弃的任务在此语句结束时即被销毁
+            this->executor->execute(new_<DeliveryTask>(this));
+            bool dropped;
+            {
+                Mutex::Scope scope(this->mutex);
+                dropped = this->droppedDeliveryCount != droppedCount;
+            }
+            if (dropped) {
+                throw_new(IllegalStateException, "The delivery task has been dropped by the executor");
+            }
+        }
+
+        void onDeliveryDropped() {
+            Mutex::Scope scope(this->mutex);
+            this->scheduled = false;
+            this->droppedDeliveryCount++;
+            this->idleCondition->notifyAll();
+            this->notFullCondition->notifyAll();
+        }
+
+        void deliver() {
+            vector<tuple<Args...>> batch;
+            {
+                Mutex::Scope scope(this->mutex);
+                this->buffer->drainTo(batch, this->maxBatchSize);
+                this->deliveringThread = pthread_self();
+                this->delivering = true;
+                if (this->capacity > 0) {
+                    this->notFullCondition->notifyAll();
+                }
+            }
+            try_ {
+                if (this->batchTarget != nullptr) {
+                    this->batchTarget->accept(batch);
+                } else {
+                    Consumer<Args...> *target = this->target.get();
+                    auto accept = [target](const Args &...args) {
+                        target->accept(args...);
+                    };
+                    for (const tuple<Args...> &event : batch) {
+                        _invokeWithTuple(accept, event);
+                    }
+                }
+            } catch_(Exception, ex) {
+                ex->printStackTrace();
+            } end_try
+            batch.clear(); //flush返回时事件应当已被释放
+            bool more;
+            {
+                Mutex::Scope scope(this->mutex);
+                this->delivering = false;
+                more = this->buffer->size() != 0;
+                if (!more) {
+                    this->scheduled = false;
+                    this->idleCondition->notifyAll();
+                }
+            }
+            if (more) {
+                this->scheduleDelivery(); //重新排队而不是继续循环, 以便共享线程池中的其他任务得到执行
+            }
+        }
+
+        Ref<Consumer<Args...>> target;
+        Ref<BatchConsumer> batchTarget;
+        unique_ptr<_EventBuffer<Args...>> buffer;
+        Ref<Executor> executor;
+        Ref<ExecutorService> dedicatedExecutor;
+        const int capacity;
+        const OverflowPolicy overflowPolicy;
+        const int maxBatchSize;
+        Mutex mutex;
+        Ref<Condition> notFullCondition;
+        Ref<Condition> idleCondition;
+        bool scheduled = false;
+        bool delivering = false;
+        bool closed = false;
+        int droppedDeliveryCount = 0;
+        pthread_t deliveringThread = pthread_t();
+        interface_refcount()
+    };
+}
@@ -0,0 +1,83 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Reclamation.h"
+
+namespace com_lanjing_cpp_common {
+
+    using namespace std;
+
+    /**
+     * 对应java.util.concurrent.atomic.AtomicReference<V>, T必须为Interface或Object
+     *
+     * 和AtomicInteger一样是值类型, 通常作为其他对象的字段存在.
+     * 读者(get)完全无锁, 被替换下来的旧引用通过危险指针延迟释放(参见Reclamation.h),
+     * 因此不会出现读者刚取得原始指针, 对象就被其他线程release掉的问题
+     */
+    template <typename T>
+    struct AtomicRef {
+    public:
+        AtomicRef(Ref<T> initialValue = nullptr) {
+            T *p = initialValue.get();
+            if (p != nullptr) {
+                p->retain();
+            }
+            this->value.store(p);
+        }
+        ~AtomicRef() {
+            T *p = this->value.load();
+            if (p != nullptr) {
+                p->release();
+            }
+        }
+        Ref<T> get() const {
+            Reclamation::HazardPointer hazardPointer;
+            T *p = hazardPointer.protect(this->value);
+            return p; //危险指针保证AtomicRef自身持有的引用尚未被释放, 此处retain是安全的
+        }
+        void set(Ref<T> newValue) {
+            this->getAndSet(newValue);
+        }
+        Ref<T> getAndSet(Ref<T> newValue) {
+            T *np = newValue.get();
+            if (np != nullptr) {
+                np->retain();
+            }
+            T *op = this->value.exchange(np);
+            Ref<T> oldValue = op;
+            retire(op);
+            return oldValue;
+        }
+        bool compareAndSet(Ref<T> expectedValue, Ref<T> newValue) {
+            T *ep = expectedValue.get();
+            T *np = newValue.get();
+            if (np != nullptr) {
+                np->retain();
+            }
+            if (!this->value.compare_exchange_strong(ep, np)) {
+                if (np != nullptr) {
+                    np->release();
+                }
+                return false;
+            }
+            retire(ep);
+            return true;
+        }
+
+        AtomicRef(const AtomicRef<T> &) = delete;
+        AtomicRef<T> &operator = (const AtomicRef<T> &) = delete;
+    private:
+        static void retire(T *p) {
+            if (p != nullptr) {
+                Reclamation::deferRelease(p);
+            }
+        }
+        atomic<T*> value;
+    };
+}
@@ -17,6 +17,12 @@ namespace com_lanjing_cpp_common {
             gettimeofday(&tv,NULL);
             return (int64_t)tv.tv_sec * 1000 + (int64_t)tv.tv_usec / 1000;
         }
+        // 单调时钟, 不受系统时间调整的影响, 只能用于计算时间间隔
+        static int64_t nanoTime() {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+        }
         template <typename T>
         static void arraycopy(const T *src, T *dst, int length, bool cppElement) {
             if (cppElement) {
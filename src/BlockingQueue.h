@@ -8,7 +8,13 @@
 #pragma once
 
 #include "Common.h"
+#include "CompletableFuture.h"
+#include <algorithm>
+#include <climits>
 #include <list>
+#include <sched.h>
+#include <memory>
+#include <vector>
 
 namespace com_lanjing_cpp_common {
 
@@ -21,6 +27,37 @@ namespace com_lanjing_cpp_common {
         virtual bool offer(Ref<E> element, long timeout) = 0;
         virtual Ref<E> take() = 0;
         virtual Ref<E> poll(long timeout) = 0;
+        /*
+         * take的非阻塞版本: 队列非空时返回已完成的future, 否则在下一个元素入队时由入队线程完成它.
+         * 协程中可以直接co_await queue->takeAsync()(参见Coroutine.h)
+         *
+         * 各实现在锁内把元素交给等待的future, 但一律在释放锁之后才调用complete:
+         * 等待者的后续操作(thenApply等回调或被恢复的协程)会在入队线程中就地执行, 可能再次访问本队列
+         */
+        virtual Ref<CompletableFuture<Ref<E>>> takeAsync() = 0;
+
+        // 批量操作: 整批只获取一次锁, 只发出一次通知
+
+        // 不等待, 取出最多maxElements个元素追加到elements末尾, 返回取出的个数
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements = INT_MAX) = 0;
+        // 最多等待timeout毫秒(小于0表示无限等待)直到队列非空, 然后同drainTo(elements, maxElements); 超时返回0
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements, long timeout) = 0;
+        // 放入所有元素, 队列满时等待
+        virtual void putAll(const vector<Ref<E>> &elements) = 0;
+        // 不等待, 从头开始尽可能多地放入元素, 返回放入的个数
+        virtual int offerAll(const vector<Ref<E>> &elements) = 0;
+        virtual int size() = 0;
+        // 无界队列返回INT_MAX
+        virtual int remainingCapacity() = 0;
+
+    protected:
+        static void checkElements(const vector<Ref<E>> &elements) {
+            for (const Ref<E> &element : elements) {
+                if (element == nullptr) {
+                    throw_new(IllegalArgumentException, "element cannot be null");
+                }
+            }
+        }
     };
 
     template <typename E>
@@ -33,12 +70,21 @@ namespace com_lanjing_cpp_common {
                 throw_new(IllegalArgumentException, "element cannot be null");
             }
 
-            Mutex::Scope scope(this->mutex);
-            while (this->locklesslyIsFull()) {
-                this->inCondition->wait();
+            Ref<CompletableFuture<Ref<E>>> asyncTaker;
+            {
+                Mutex::Scope scope(this->mutex);
+                asyncTaker = this->locklesslyPollAsyncTaker();
+                if (asyncTaker == nullptr) {
+                    while (this->locklesslyIsFull()) {
+                        this->inCondition->wait();
+                    }
+                    this->locklesslyPush(element);
+                    this->outCondition->notify();
+                }
+            }
+            if (asyncTaker != nullptr) {
+                asyncTaker->complete(element);
             }
-            this->locklesslyPush(element);
-            this->outCondition->notify();
         }
 
         virtual bool offer(Ref<E> element, long timeout) override {
@@ -46,14 +92,21 @@ namespace com_lanjing_cpp_common {
                 throw_new(IllegalArgumentException, "element cannot be null");
             }
 
-            Mutex::Scope scope(this->mutex);
-            if (this->locklesslyIsFull() &&
-                    !this->inCondition->wait(timeout) &&
-                    this->locklesslyIsFull()) {
-                return false;
+            Ref<CompletableFuture<Ref<E>>> asyncTaker;
+            {
+                Mutex::Scope scope(this->mutex);
+                asyncTaker = this->locklesslyPollAsyncTaker();
+                if (asyncTaker == nullptr) {
+                    if (!this->locklesslyAwait(this->inCondition, timeout, [this] { return !this->locklesslyIsFull(); })) {
+                        return false;
+                    }
+                    this->locklesslyPush(element);
+                    this->outCondition->notify();
+                }
+            }
+            if (asyncTaker != nullptr) {
+                asyncTaker->complete(element);
             }
-            this->locklesslyPush(element);
-            this->outCondition->notify();
             return true;
         }
 
@@ -69,9 +122,7 @@ namespace com_lanjing_cpp_common {
 
         virtual Ref<E> poll(long timeout) override {
             Mutex::Scope scope(this->mutex);
-            if (this->locklesslyIsEmpty() &&
-                    !this->outCondition->wait(timeout) &&
-                    !this->locklesslyIsEmpty()) {
+            if (!this->locklesslyAwait(this->outCondition, timeout, [this] { return !this->locklesslyIsEmpty(); })) {
                 return nullptr;
             }
             Ref<E> element = this->locklesslyPoll();
@@ -79,6 +130,53 @@ namespace com_lanjing_cpp_common {
             return element;
         }
 
+        virtual Ref<CompletableFuture<Ref<E>>> takeAsync() override {
+            Ref<CompletableFuture<Ref<E>>> future = new_<CompletableFuture<Ref<E>>>();
+            Ref<E> element;
+            {
+                Mutex::Scope scope(this->mutex);
+                if (this->locklesslyIsEmpty()) {
+                    this->asyncTakers.push_back(future);
+                    return future;
+                }
+                element = this->locklesslyPoll();
+                this->inCondition->notify();
+            }
+            future->complete(element);
+            return future;
+        }
+
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements = INT_MAX) override {
+            Mutex::Scope scope(this->mutex);
+            return this->locklesslyDrainTo(elements, maxElements);
+        }
+
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements, long timeout) override {
+            Mutex::Scope scope(this->mutex);
+            if (!this->locklesslyAwait(this->outCondition, timeout, [this] { return !this->locklesslyIsEmpty(); })) {
+                return 0;
+            }
+            return this->locklesslyDrainTo(elements, maxElements);
+        }
+
+        virtual void putAll(const vector<Ref<E>> &elements) override {
+            this->addAll(elements, true);
+        }
+
+        virtual int offerAll(const vector<Ref<E>> &elements) override {
+            return this->addAll(elements, false);
+        }
+
+        virtual int size() override {
+            Mutex::Scope scope(this->mutex);
+            return this->locklesslySize();
+        }
+
+        virtual int remainingCapacity() override {
+            Mutex::Scope scope(this->mutex);
+            return this->locklesslyRemainingCapacity();
+        }
+
     protected:
         AbstractBlockingQueue() {
             this->inCondition = new_<Condition>(this->mutex);
@@ -93,10 +191,100 @@ namespace com_lanjing_cpp_common {
 
         virtual Ref<E> locklesslyPoll() = 0;
 
+        virtual int locklesslySize() = 0;
+
+        virtual int locklesslyRemainingCapacity() = 0;
+
+    private:
+        int addAll(const vector<Ref<E>> &elements, bool wait) {
+            BlockingQueue<E>::checkElements(elements);
+            vector<pair<Ref<CompletableFuture<Ref<E>>>, Ref<E>>> completions;
+            int added = 0;
+            {
+                Mutex::Scope scope(this->mutex);
+                int pushed = 0;
+                for (const Ref<E> &element : elements) {
+                    Ref<CompletableFuture<Ref<E>>> asyncTaker = this->locklesslyPollAsyncTaker();
+                    if (asyncTaker != nullptr) {
+                        completions.push_back(make_pair(asyncTaker, element));
+                        added++;
+                        continue;
+                    }
+                    if (this->locklesslyIsFull()) {
+                        if (!wait) {
+                            break;
+                        }
+                        notify(this->outCondition, pushed); //挂起之前必须先唤醒消费者, 否则双方可能互相等待
+                        pushed = 0;
+                        while (this->locklesslyIsFull()) {
+                            this->inCondition->wait();
+                        }
+                    }
+                    this->locklesslyPush(element);
+                    pushed++;
+                    added++;
+                }
+                notify(this->outCondition, pushed);
+            }
+            for (auto &completion : completions) {
+                completion.first->complete(completion.second);
+            }
+            return added;
+        }
+
+        int locklesslyDrainTo(vector<Ref<E>> &elements, int maxElements) {
+            int count = 0;
+            while (count < maxElements && !this->locklesslyIsEmpty()) {
+                elements.push_back(this->locklesslyPoll());
+                count++;
+            }
+            notify(this->inCondition, count);
+            return count;
+        }
+
+        // 必须持有mutex, timeout小于0表示无限等待; 被唤醒后必须重新检查条件, 因为元素或空位可能已被其他线程抢走
+        template <typename P>
+        bool locklesslyAwait(const Ref<Condition> &condition, long timeout, P ready) {
+            if (timeout < 0) {
+                while (!ready()) {
+                    condition->wait();
+                }
+                return true;
+            }
+            int64_t deadline = System::currentTimeMillis() + timeout;
+            while (!ready()) {
+                int64_t remaining = deadline - System::currentTimeMillis();
+                if (remaining <= 0) {
+                    return false;
+                }
+                condition->wait(remaining);
+            }
+            return true;
+        }
+
+        static void notify(const Ref<Condition> &condition, int count) {
+            if (count == 1) {
+                condition->notify();
+            } else if (count > 1) {
+                condition->notifyAll();
+            }
+        }
+
+        // 只有队列为空时才可能存在异步等待者, 所以新元素总是优先交给它们
+        Ref<CompletableFuture<Ref<E>>> locklesslyPollAsyncTaker() {
+            if (this->asyncTakers.empty()) {
+                return nullptr;
+            }
+            Ref<CompletableFuture<Ref<E>>> asyncTaker = this->asyncTakers.front();
+            this->asyncTakers.pop_front();
+            return asyncTaker;
+        }
+
     private:
         Mutex mutex;
         Ref<Condition> inCondition;
         Ref<Condition> outCondition;
+        list<Ref<CompletableFuture<Ref<E>>>> asyncTakers;
 
         interface_refcount()
     };
@@ -134,38 +322,1406 @@ namespace com_lanjing_cpp_common {
             return element;
         }
 
+        virtual int locklesslySize() override {
+            return (this->in - this->out + this->elements.length()) % this->elements.length();
+        }
+
+        virtual int locklesslyRemainingCapacity() override {
+            return this->elements.length() - 1 - this->locklesslySize();
+        }
+
     private:
         RefArr<E> elements;
         int in = 0;
         int out = 0;
     };
 
+    /**
+     * 有界的无锁多生产者多消费者队列(Dmitry Vyukov的带序号环形缓冲区)
+     *
+     * 每个槽位带有一个序号, 生产者和消费者各自只需对tail或head做一次CAS即可占有槽位, 不加任何锁;
+     * 容量总是2的幂, 下标计算是一次按位与. head和tail被填充到不同的缓存行, 生产者和消费者互不干扰.
+     * 只有在队列满(生产者)或空(消费者)时线程才会通过EventCount挂起, 平时的通知只是一次原子读
+     */
     template <typename E>
-    class LinkedBlockingQueue : public AbstractBlockingQueue<E> {
+    class ConcurrentArrayBlockingQueue : extends Object, implements BlockingQueue<E> {
+    public:
+        ConcurrentArrayBlockingQueue(int capacity) {
+            if (capacity < 2) {
+                throw_new(IllegalArgumentException, "capacity cannot be less than 2");
+            }
+            if (capacity > (1 << 30)) {
+                throw_new(IllegalArgumentException, "capacity cannot be greater than 2^30");
+            }
+            size_t actualCapacity = 2;
+            while (actualCapacity < (size_t)capacity) {
+                actualCapacity <<= 1;
+            }
+            this->mask = actualCapacity - 1;
+            this->cells.reset(new Cell[actualCapacity]);
+            for (size_t i = 0; i < actualCapacity; i++) {
+                this->cells[i].sequence.store(i, memory_order_relaxed);
+            }
+        }
+        virtual ~ConcurrentArrayBlockingQueue() {}
+
+        // 实际容量, 即构造参数向上取整到2的幂
+        int getCapacity() const {
+            return (int)(this->mask + 1);
+        }
+
+        virtual void put(Ref<E> element) override {
+            if (element == nullptr) {
+                throw_new(IllegalArgumentException, "element cannot be null");
+            }
+            if (!this->tryPushOrYield(element)) {
+                while (true) {
+                    unsigned key = this->notFull.prepareWait();
+                    if (this->tryPush(element)) {
+                        this->notFull.cancelWait();
+                        break;
+                    }
+                    this->notFull.wait(key);
+                }
+            }
+            this->afterPush();
+        }
+
+        virtual bool offer(Ref<E> element, long timeout) override {
+            if (element == nullptr) {
+                throw_new(IllegalArgumentException, "element cannot be null");
+            }
+            if (!this->tryPushOrYield(element)) {
+                int64_t deadline = System::currentTimeMillis() + timeout;
+                while (true) {
+                    unsigned key = this->notFull.prepareWait();
+                    if (this->tryPush(element)) {
+                        this->notFull.cancelWait();
+                        break;
+                    }
+                    if (!this->notFull.wait(key, deadline)) {
+                        if (!this->tryPush(element)) {
+                            return false;
+                        }
+                        break;
+                    }
+                }
+            }
+            this->afterPush();
+            return true;
+        }
+
+        virtual Ref<E> take() override {
+            Ref<E> element = this->tryPollOrYield();
+            if (element == nullptr) {
+                while (true) {
+                    unsigned key = this->notEmpty.prepareWait();
+                    element = this->tryPoll();
+                    if (element != nullptr) {
+                        this->notEmpty.cancelWait();
+                        break;
+                    }
+                    this->notEmpty.wait(key);
+                }
+            }
+            this->notFull.notify();
+            return element;
+        }
+
+        virtual Ref<E> poll(long timeout) override {
+            Ref<E> element = this->tryPollOrYield();
+            if (element == nullptr) {
+                int64_t deadline = System::currentTimeMillis() + timeout;
+                while (true) {
+                    unsigned key = this->notEmpty.prepareWait();
+                    element = this->tryPoll();
+                    if (element != nullptr) {
+                        this->notEmpty.cancelWait();
+                        break;
+                    }
+                    if (!this->notEmpty.wait(key, deadline)) {
+                        element = this->tryPoll();
+                        if (element == nullptr) {
+                            return nullptr;
+                        }
+                        break;
+                    }
+                }
+            }
+            this->notFull.notify();
+            return element;
+        }
+
+        /*
+         * 异步等待者登记在一个加锁的列表中, 但只有在确实存在异步等待者时, 生产者才会去触碰这把锁.
+         * 登记之后必须再检查一次队列(与生产者"先入队再检查异步等待者数量"构成Dekker式同步), 否则可能错过刚入队的元素.
+         * 再次检查和注销都在asyncTakerMutex中进行: completeAsyncTakers也在这把锁中取出元素并摘下等待者,
+         * 所以future要么仍在列表中(由这里取出元素并注销), 要么已经被某个生产者摘下并分配了元素(这里不再取出), 不会多取
+         */
+        virtual Ref<CompletableFuture<Ref<E>>> takeAsync() override {
+            Ref<CompletableFuture<Ref<E>>> future = new_<CompletableFuture<Ref<E>>>();
+            Ref<E> element = this->tryPoll();
+            if (element == nullptr) {
+                {
+                    Mutex::Scope scope(this->asyncTakerMutex);
+                    this->asyncTakers.push_back(future);
+                    this->asyncTakerCount.fetch_add(1);
+                }
+                atomic_thread_fence(memory_order_seq_cst);
+                {
+                    Mutex::Scope scope(this->asyncTakerMutex);
+                    auto itr = find(this->asyncTakers.begin(), this->asyncTakers.end(), future);
+                    if (itr == this->asyncTakers.end()) {
+                        return future;
+                    }
+                    element = this->tryPoll();
+                    if (element == nullptr) {
+                        return future;
+                    }
+                    this->asyncTakers.erase(itr);
+                    this->asyncTakerCount.fetch_sub(1);
+                }
+            }
+            this->notFull.notify();
+            future->complete(element);
+            return future;
+        }
+
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements = INT_MAX) override {
+            int count = this->tryPollAll(elements, maxElements);
+            this->afterPoll(count);
+            return count;
+        }
+
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements, long timeout) override {
+            if (maxElements <= 0) {
+                return 0;
+            }
+            int count = this->tryPollAll(elements, maxElements);
+            for (int i = 0; count == 0 && i < YIELD_COUNT; i++) {
+                sched_yield();
+                count = this->tryPollAll(elements, maxElements);
+            }
+            if (count == 0) {
+                int64_t deadline = timeout < 0 ? -1 : System::currentTimeMillis() + timeout;
+                while (true) {
+                    unsigned key = this->notEmpty.prepareWait();
+                    count = this->tryPollAll(elements, maxElements);
+                    if (count != 0) {
+                        this->notEmpty.cancelWait();
+                        break;
+                    }
+                    if (deadline < 0) {
+                        this->notEmpty.wait(key);
+                    } else if (!this->notEmpty.wait(key, deadline)) {
+                        count = this->tryPollAll(elements, maxElements);
+                        break;
+                    }
+                }
+            }
+            this->afterPoll(count);
+            return count;
+        }
+
+        virtual void putAll(const vector<Ref<E>> &elements) override {
+            BlockingQueue<E>::checkElements(elements);
+            size_t pushed = 0;
+            while (pushed < elements.size()) {
+                int count = this->tryPushAll(elements, pushed);
+                for (int i = 0; count == 0 && i < YIELD_COUNT; i++) {
+                    sched_yield();
+                    count = this->tryPushAll(elements, pushed);
+                }
+                if (count == 0) {
+                    unsigned key = this->notFull.prepareWait();
+                    count = this->tryPushAll(elements, pushed);
+                    if (count == 0) {
+                        this->notFull.wait(key);
+                        continue;
+                    }
+                    this->notFull.cancelWait();
+                }
+                pushed += count;
+                this->afterPush(count);
+            }
+        }
 
+        virtual int offerAll(const vector<Ref<E>> &elements) override {
+            BlockingQueue<E>::checkElements(elements);
+            int count = this->tryPushAll(elements, 0);
+            this->afterPush(count);
+            return count;
+        }
+
+        // 包括已被生产者占有但尚未写完的槽位, 所以只是一个近似值
+        virtual int size() override {
+            size_t h = this->head.load();
+            size_t t = this->tail.load();
+            return t > h ? (int)min(t - h, this->mask + 1) : 0;
+        }
+
+        virtual int remainingCapacity() override {
+            return this->getCapacity() - this->size();
+        }
+
+    private:
+        struct Cell {
+            atomic<size_t> sequence;
+            Ref<E> element;
+        };
+
+        bool tryPush(const Ref<E> &element) {
+            size_t pos = this->tail.load(memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &this->cells[pos & this->mask];
+                size_t sequence = cell->sequence.load(memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0) {
+                    if (this->tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = this->tail.load(memory_order_relaxed);
+                }
+            }
+            cell->element = element;
+            cell->sequence.store(pos + 1, memory_order_release);
+            return true;
+        }
+
+        Ref<E> tryPoll() {
+            size_t pos = this->head.load(memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &this->cells[pos & this->mask];
+                size_t sequence = cell->sequence.load(memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+                if (diff == 0) {
+                    if (this->head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return nullptr;
+                } else {
+                    pos = this->head.load(memory_order_relaxed);
+                }
+            }
+            Ref<E> element = cell->element;
+            cell->element = nullptr; //Ref的右值构造只是复制, 必须显式清空, 否则槽位会一直持有已出队的元素
+            cell->sequence.store(pos + this->mask + 1, memory_order_release);
+            return element;
+        }
+
+        /*
+         * 批量版本: 先确认从pos开始的连续k个槽位都可用, 再用一次CAS把tail从pos推进到pos + k.
+         * CAS成功说明期间没有其他生产者占有这些位置, 而可用的槽位只能被占有它的生产者改变, 所以k个槽位都归自己
+         */
+        int tryPushAll(const vector<Ref<E>> &elements, size_t from) {
+            size_t count = elements.size() - from;
+            size_t pos = this->tail.load(memory_order_relaxed);
+            size_t k;
+            while (true) {
+                bool stale = false;
+                for (k = 0; k < count; k++) {
+                    size_t sequence = this->cells[(pos + k) & this->mask].sequence.load(memory_order_acquire);
+                    intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + k);
+                    if (diff != 0) {
+                        stale = diff > 0;
+                        break;
+                    }
+                }
+                if (stale && k == 0) {
+                    pos = this->tail.load(memory_order_relaxed);
+                } else if (k == 0) {
+                    return 0;
+                } else if (this->tail.compare_exchange_weak(pos, pos + k, memory_order_relaxed)) {
+                    break;
+                }
+            }
+            for (size_t i = 0; i < k; i++) {
+                Cell &cell = this->cells[(pos + i) & this->mask];
+                cell.element = elements[from + i];
+                cell.sequence.store(pos + i + 1, memory_order_release);
+            }
+            return (int)k;
+        }
+
+        int tryPollAll(vector<Ref<E>> &elements, int maxElements) {
+            size_t count = maxElements > 0 ? (size_t)maxElements : 0;
+            size_t pos = this->head.load(memory_order_relaxed);
+            size_t k;
+            while (true) {
+                bool stale = false;
+                for (k = 0; k < count; k++) {
+                    size_t sequence = this->cells[(pos + k) & this->mask].sequence.load(memory_order_acquire);
+                    intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + k + 1);
+                    if (diff != 0) {
+                        stale = diff > 0;
+                        break;
+                    }
+                }
+                if (stale && k == 0) {
+                    pos = this->head.load(memory_order_relaxed);
+                } else if (k == 0) {
+                    return 0;
+                } else if (this->head.compare_exchange_weak(pos, pos + k, memory_order_relaxed)) {
+                    break;
+                }
+            }
+            for (size_t i = 0; i < k; i++) {
+                Cell &cell = this->cells[(pos + i) & this->mask];
+                elements.push_back(cell.element);
+                cell.element = nullptr;
+                cell.sequence.store(pos + i + this->mask + 1, memory_order_release);
+            }
+            return (int)k;
+        }
+
+        /*
+         * 队列满或空时先让出CPU重试几次再挂起: 对方线程往往马上就会取走或放入元素,
+         * 这比一次挂起加一次唤醒(两次系统调用和两次上下文切换)便宜得多
+         */
+        bool tryPushOrYield(const Ref<E> &element) {
+            for (int i = 0; i < YIELD_COUNT; i++) {
+                if (this->tryPush(element)) {
+                    return true;
+                }
+                sched_yield();
+            }
+            return this->tryPush(element);
+        }
+
+        Ref<E> tryPollOrYield() {
+            for (int i = 0; i < YIELD_COUNT; i++) {
+                Ref<E> element = this->tryPoll();
+                if (element != nullptr) {
+                    return element;
+                }
+                sched_yield();
+            }
+            return this->tryPoll();
+        }
+
+        void afterPush(int count = 1) {
+            if (count == 0) {
+                return;
+            }
+            if (count == 1) {
+                this->notEmpty.notify();
+            } else {
+                this->notEmpty.notifyAll();
+            }
+            atomic_thread_fence(memory_order_seq_cst);
+            if (this->asyncTakerCount.load(memory_order_relaxed) != 0) {
+                this->completeAsyncTakers();
+            }
+        }
+
+        void afterPoll(int count) {
+            if (count == 1) {
+                this->notFull.notify();
+            } else if (count > 1) {
+                this->notFull.notifyAll();
+            }
+        }
+
+        void completeAsyncTakers() {
+            vector<pair<Ref<CompletableFuture<Ref<E>>>, Ref<E>>> completions;
+            {
+                Mutex::Scope scope(this->asyncTakerMutex);
+                while (!this->asyncTakers.empty()) {
+                    Ref<E> element = this->tryPoll();
+                    if (element == nullptr) {
+                        break;
+                    }
+                    completions.push_back(make_pair(this->asyncTakers.front(), element));
+                    this->asyncTakers.pop_front();
+                    this->asyncTakerCount.fetch_sub(1);
+                }
+            }
+            for (auto &completion : completions) {
+                this->notFull.notify();
+                completion.first->complete(completion.second);
+            }
+        }
+
+    private:
+        static const size_t CACHE_LINE_SIZE = 64;
+        static const int YIELD_COUNT = 16;
+
+        char headPadding[CACHE_LINE_SIZE];
+        atomic<size_t> head { 0 };
+        char tailPadding[CACHE_LINE_SIZE - sizeof(atomic<size_t>)];
+        atomic<size_t> tail { 0 };
+        char cellsPadding[CACHE_LINE_SIZE - sizeof(atomic<size_t>)];
+        size_t mask;
+        unique_ptr<Cell[]> cells;
+        EventCount notEmpty;
+        EventCount notFull;
+        atomic<int> asyncTakerCount { 0 };
+        Mutex asyncTakerMutex;
+        list<Ref<CompletableFuture<Ref<E>>>> asyncTakers;
+
+        interface_refcount()
+    };
+
+    /**
+     * 双锁队列(Michael-Scott two-lock queue), 对应java.util.concurrent.LinkedBlockingQueue, 也是ExecutorService默认的任务队列
+     *
+     * 入队只需putLock, 出队只需takeLock, 生产者和消费者互不阻塞, 元素个数保存在AtomicInteger中;
+     * 出队释放的节点被回收给之后的入队使用, 稳定状态下不再分配内存.
+     * 只有在对方确实有线程等待时, 才会去获取对方的锁并发出通知
+     */
+    template <typename E>
+    class LinkedBlockingQueue : extends Object, implements BlockingQueue<E> {
     public:
-        virtual ~LinkedBlockingQueue() {}
+        LinkedBlockingQueue(int capacity = INT_MAX) : capacity(capacity) {
+            if (capacity < 1) {
+                throw_new(IllegalArgumentException, "capacity cannot be less than 1");
+            }
+            this->head = this->last = new Node();
+            this->notEmptyCondition = new_<Condition>(this->takeLock);
+            this->notFullCondition = new_<Condition>(this->putLock);
+        }
+        virtual ~LinkedBlockingQueue() {
+            deleteNodes(this->head);
+            deleteNodes(this->putSideFreeNodes);
+            deleteNodes(this->takeSideFreeNodes);
+            deleteNodes(this->sharedFreeNodes.load());
+        }
 
-    protected:
+        int getCapacity() const {
+            return this->capacity;
+        }
 
-        virtual bool locklesslyIsEmpty() override {
+        virtual void put(Ref<E> element) override {
+            if (element == nullptr) {
+                throw_new(IllegalArgumentException, "element cannot be null");
+            }
+            {
+                Mutex::Scope scope(this->putLock);
+                this->awaitNotFull(-1);
+                this->enqueue(element);
+            }
+            this->signalNotEmptyIfNecessary();
+        }
+
+        virtual bool offer(Ref<E> element, long timeout) override {
+            if (element == nullptr) {
+                throw_new(IllegalArgumentException, "element cannot be null");
+            }
+            {
+                Mutex::Scope scope(this->putLock);
+                if (!this->awaitNotFull(System::currentTimeMillis() + timeout)) {
+                    return false;
+                }
+                this->enqueue(element);
+            }
+            this->signalNotEmptyIfNecessary();
+            return true;
+        }
+
+        virtual Ref<E> take() override {
+            Ref<E> element;
+            {
+                Mutex::Scope scope(this->takeLock);
+                this->awaitNotEmpty(-1);
+                element = this->dequeue();
+            }
+            this->signalNotFullIfNecessary();
+            return element;
+        }
+
+        virtual Ref<E> poll(long timeout) override {
+            Ref<E> element;
+            {
+                Mutex::Scope scope(this->takeLock);
+                if (!this->awaitNotEmpty(System::currentTimeMillis() + timeout)) {
+                    return nullptr;
+                }
+                element = this->dequeue();
+            }
+            this->signalNotFullIfNecessary();
+            return element;
+        }
+
+        virtual Ref<CompletableFuture<Ref<E>>> takeAsync() override {
+            Ref<CompletableFuture<Ref<E>>> future = new_<CompletableFuture<Ref<E>>>();
+            Ref<E> element;
+            {
+                Mutex::Scope scope(this->takeLock);
+                this->asyncTakerCount.fetch_add(1); //先登记再检查count, 与生产者"先增加count再检查等待者"构成Dekker式同步
+                if (this->count.load() == 0) {
+                    this->asyncTakers.push_back(future);
+                    return future;
+                }
+                this->asyncTakerCount.fetch_sub(1);
+                element = this->dequeue();
+            }
+            this->signalNotFullIfNecessary();
+            future->complete(element);
+            return future;
+        }
+
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements = INT_MAX) override {
+            int count;
+            {
+                Mutex::Scope scope(this->takeLock);
+                count = this->dequeueAll(elements, maxElements);
+            }
+            this->signalNotFullIfNecessary(count);
+            return count;
+        }
+
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements, long timeout) override {
+            int count;
+            {
+                Mutex::Scope scope(this->takeLock);
+                if (!this->awaitNotEmpty(timeout < 0 ? -1 : System::currentTimeMillis() + timeout)) {
+                    return 0;
+                }
+                count = this->dequeueAll(elements, maxElements);
+            }
+            this->signalNotFullIfNecessary(count);
+            return count;
+        }
+
+        virtual void putAll(const vector<Ref<E>> &elements) override {
+            BlockingQueue<E>::checkElements(elements);
+            size_t pushed = 0;
+            while (pushed < elements.size()) {
+                int count;
+                {
+                    Mutex::Scope scope(this->putLock);
+                    this->awaitNotFull(-1);
+                    count = this->enqueueAll(elements, pushed);
+                }
+                pushed += count;
+                this->signalNotEmptyIfNecessary(count);
+            }
+        }
+
+        virtual int offerAll(const vector<Ref<E>> &elements) override {
+            BlockingQueue<E>::checkElements(elements);
+            int count;
+            {
+                Mutex::Scope scope(this->putLock);
+                count = this->enqueueAll(elements, 0);
+            }
+            this->signalNotEmptyIfNecessary(count);
+            return count;
+        }
+
+        virtual int size() override {
+            return this->count.load();
+        }
+
+        virtual int remainingCapacity() override {
+            return this->capacity - this->count.load();
+        }
+
+    private:
+        struct Node {
+            Ref<E> element;
+            Node *next = nullptr;
+        };
+
+        // 必须持有putLock, deadlineMillis小于0表示无限等待; 超时返回false
+        bool awaitNotFull(int64_t deadlineMillis) {
+            for (int i = 0; i < YIELD_COUNT; i++) {
+                if (this->count.load() < this->capacity) {
+                    return true;
+                }
+                sched_yield();
+            }
+            bool notFull = true;
+            this->putWaiters.fetch_add(1);
+            while (this->count.load() >= this->capacity) {
+                if (deadlineMillis < 0) {
+                    this->notFullCondition->wait();
+                } else {
+                    int64_t remaining = deadlineMillis - System::currentTimeMillis();
+                    if (remaining <= 0) {
+                        notFull = false;
+                        break;
+                    }
+                    this->notFullCondition->wait(remaining);
+                }
+            }
+            this->putWaiters.fetch_sub(1);
+            return notFull;
+        }
+
+        // 必须持有takeLock, deadlineMillis小于0表示无限等待; 超时返回false
+        bool awaitNotEmpty(int64_t deadlineMillis) {
+            for (int i = 0; i < YIELD_COUNT; i++) {
+                if (this->count.load() > 0) {
+                    return true;
+                }
+                sched_yield();
+            }
+            bool notEmpty = true;
+            this->takeWaiters.fetch_add(1);
+            while (this->count.load() == 0) {
+                if (deadlineMillis < 0) {
+                    this->notEmptyCondition->wait();
+                } else {
+                    int64_t remaining = deadlineMillis - System::currentTimeMillis();
+                    if (remaining <= 0) {
+                        notEmpty = false;
+                        break;
+                    }
+                    this->notEmptyCondition->wait(remaining);
+                }
+            }
+            this->takeWaiters.fetch_sub(1);
+            return notEmpty;
+        }
+
+        // 必须持有putLock
+        void enqueue(const Ref<E> &element) {
+            Node *node = this->allocateNode();
+            node->element = element;
+            this->last->next = node;
+            this->last = node;
+            this->count.fetch_add(1);
+        }
+
+        // 必须持有putLock, 从from开始放入尽可能多的元素, 整批只更新一次count
+        int enqueueAll(const vector<Ref<E>> &elements, size_t from) {
+            size_t count = min(elements.size() - from, (size_t)(this->capacity - this->count.load()));
+            for (size_t i = 0; i < count; i++) {
+                Node *node = this->allocateNode();
+                node->element = elements[from + i];
+                this->last->next = node;
+                this->last = node;
+            }
+            this->count.fetch_add((int)count);
+            return (int)count;
+        }
+
+        // 必须持有takeLock, 整批只更新一次count
+        int dequeueAll(vector<Ref<E>> &elements, int maxElements) {
+            int count = min(this->count.load(), max(maxElements, 0));
+            for (int i = 0; i < count; i++) {
+                Node *oldHead = this->head;
+                Node *first = oldHead->next;
+                this->head = first;
+                elements.push_back(first->element);
+                first->element = nullptr;
+                this->recycleNode(oldHead);
+            }
+            this->count.fetch_sub(count);
+            return count;
+        }
+
+        // 必须持有takeLock, 且队列非空
+        Ref<E> dequeue() {
+            Node *oldHead = this->head;
+            Node *first = oldHead->next;
+            this->head = first;
+            Ref<E> element = first->element;
+            first->element = nullptr; //first成为新的哨兵节点, 不能继续持有已出队的元素
+            this->count.fetch_sub(1);
+            this->recycleNode(oldHead);
+            return element;
+        }
+
+        void signalNotEmptyIfNecessary(int addedCount = 1) {
+            if (addedCount == 0 || (this->takeWaiters.load() == 0 && this->asyncTakerCount.load() == 0)) {
+                return;
+            }
+            vector<pair<Ref<CompletableFuture<Ref<E>>>, Ref<E>>> completions;
+            {
+                Mutex::Scope scope(this->takeLock);
+                while (!this->asyncTakers.empty() && this->count.load() > 0) {
+                    completions.push_back(make_pair(this->asyncTakers.front(), this->dequeue()));
+                    this->asyncTakers.pop_front();
+                    this->asyncTakerCount.fetch_sub(1);
+                }
+                if (this->takeWaiters.load() > 0 && this->count.load() > 0) {
+                    if (addedCount == 1) {
+                        this->notEmptyCondition->notify();
+                    } else {
+                        this->notEmptyCondition->notifyAll();
+                    }
+                }
+            }
+            for (auto &completion : completions) {
+                this->signalNotFullIfNecessary();
+                completion.first->complete(completion.second);
+            }
+        }
+
+        void signalNotFullIfNecessary(int removedCount = 1) {
+            if (removedCount > 0 && this->putWaiters.load() > 0) {
+                Mutex::Scope scope(this->putLock);
+                if (removedCount == 1) {
+                    this->notFullCondition->notify();
+                } else {
+                    this->notFullCondition->notifyAll();
+                }
+            }
+        }
+
+        /*
+         * 节点回收: 出队一方(持有takeLock)先把释放的节点攒在私有链表中, 攒够一批且共享链表为空时一次CAS整批发布;
+         * 入队一方(持有putLock)在私有链表用完时一次exchange取走整个共享链表. 平均每个节点几乎不涉及原子操作,
+         * 共享链表只会被整体取走(置空)且只在为空时被设置, 所以不存在ABA问题
+         */
+        Node *allocateNode() {
+            if (this->putSideFreeNodes == nullptr && this->sharedFreeNodes.load(memory_order_relaxed) != nullptr) {
+                this->putSideFreeNodes = this->sharedFreeNodes.exchange(nullptr, memory_order_acquire);
+            }
+            Node *node = this->putSideFreeNodes;
+            if (node == nullptr) {
+                return new Node();
+            }
+            this->putSideFreeNodes = node->next;
+            node->next = nullptr;
+            return node;
+        }
+
+        void recycleNode(Node *node) {
+            if (this->takeSideFreeNodeCount >= MAX_FREE_NODE_COUNT) {
+                delete node;
+                return;
+            }
+            node->next = this->takeSideFreeNodes;
+            this->takeSideFreeNodes = node;
+            if (++this->takeSideFreeNodeCount >= FREE_NODE_BATCH_SIZE &&
+                    this->sharedFreeNodes.load(memory_order_relaxed) == nullptr) {
+                Node *expected = nullptr;
+                if (this->sharedFreeNodes.compare_exchange_strong(expected, this->takeSideFreeNodes, memory_order_release)) {
+                    this->takeSideFreeNodes = nullptr;
+                    this->takeSideFreeNodeCount = 0;
+                }
+            }
+        }
+
+        static void deleteNodes(Node *node) {
+            while (node != nullptr) {
+                Node *next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+
+    private:
+        static const int YIELD_COUNT = 16;
+        static const int FREE_NODE_BATCH_SIZE = 32;
+        static const int MAX_FREE_NODE_COUNT = 1024;
+
+        const int capacity;
+        AtomicInteger count;
+        // 入队一方的状态, 由putLock保护
+        Mutex putLock { false };
+        Ref<Condition> notFullCondition;
+        AtomicInteger putWaiters;
+        Node *last;
+        Node *putSideFreeNodes = nullptr;
+        // 出队一方的状态, 由takeLock保护
+        Mutex takeLock { false };
+        Ref<Condition> notEmptyCondition;
+        AtomicInteger takeWaiters;
+        Node *head;
+        Node *takeSideFreeNodes = nullptr;
+        int takeSideFreeNodeCount = 0;
+        AtomicInteger asyncTakerCount;
+        list<Ref<CompletableFuture<Ref<E>>>> asyncTakers;
+        atomic<Node*> sharedFreeNodes { nullptr };
+
+        interface_refcount()
+    };
+
+    /**
+     * 带优先级的元素, PriorityBlockingQueue的默认比较器让优先级高的元素先出队
+     */
+    interface Prioritized : implements Interface {
+        virtual ~Prioritized() {}
+        virtual int getPriority() = 0;
+
+        // 包装runnable, 使它可以作为PriorityBlockingQueue<Runnable>中的任务
+        static Ref<Runnable> of(int priority, Ref<Runnable> runnable) {
+            class Wrapper : extends Object, implements Runnable, implements Prioritized {
+            public:
+                Wrapper(int priority, Ref<Runnable> runnable) : priority(priority), runnable(runnable) {}
+                virtual void run() override {
+                    this->runnable->run();
+                }
+                virtual int getPriority() override {
+                    return this->priority;
+                }
+            private:
+                const int priority;
+                Ref<Runnable> runnable;
+                interface_refcount()
+            };
+            if (runnable == nullptr) {
+                throw_new(NullPointerException, "runnable cannot be nullptr");
+            }
+            return new_<Wrapper>(priority, runnable);
+        }
+    };
+
+    /**
+     * 到期之后才能从DelayQueue中取出的元素, 对应java.util.concurrent.Delayed
+     */
+    interface Delayed : implements Interface {
+        virtual ~Delayed() {}
+        // 距离到期的毫秒数, 小于等于0表示已到期
+        virtual int64_t getDelay() = 0;
+
+        // 包装runnable, 使它可以作为DelayQueue<Runnable>中的任务, 从现在起delay毫秒后到期
+        static Ref<Runnable> of(int64_t delay, Ref<Runnable> runnable) {
+            class Wrapper : extends Object, implements Runnable, implements Delayed {
+            public:
+                Wrapper(int64_t deadline, Ref<Runnable> runnable) : deadline(deadline), runnable(runnable) {}
+                virtual void run() override {
+                    this->runnable->run();
+                }
+                virtual int64_t getDelay() override {
+                    int64_t remaining = this->deadline - System::nanoTime();
+                    return remaining <= 0 ? 0 : (remaining + 999999) / 1000000;
+                }
+            private:
+                const int64_t deadline;
+                Ref<Runnable> runnable;
+                interface_refcount()
+            };
+            if (runnable == nullptr) {
+                throw_new(NullPointerException, "runnable cannot be nullptr");
+            }
+            return new_<Wrapper>(System::nanoTime() + max(delay, (int64_t)0) * 1000000, runnable);
+        }
+    };
+
+    /*
+     * 存放在连续数组中的D叉堆(D = ARITY), 不是线程安全的. before(a, b)返回true表示a应先于b出堆.
+     * 4叉堆的高度只有二叉堆的一半, 下沉时比较的4个子节点通常位于同一缓存行
+     */
+    template <typename T, typename B>
+    class _DaryHeap {
+    public:
+        static const size_t ARITY = 4;
+
+        _DaryHeap(B before) : before(before) {}
+
+        bool isEmpty() const {
             return this->elements.empty();
         }
 
+        int size() const {
+            return (int)this->elements.size();
+        }
+
+        const T &top() const {
+            return this->elements.front();
+        }
+
+        void push(T &&value) {
+            this->elements.push_back(move(value));
+            this->siftUp(this->elements.size() - 1);
+        }
+
+        T pop() {
+            T result = move(this->elements.front());
+            T last = move(this->elements.back());
+            this->elements.pop_back();
+            if (!this->elements.empty()) {
+                this->siftDown(move(last));
+            }
+            return result;
+        }
+
+    private:
+        void siftUp(size_t index) {
+            T value = move(this->elements[index]);
+            while (index > 0) {
+                size_t parent = (index - 1) / ARITY;
+                if (!this->before(value, this->elements[parent])) {
+                    break;
+                }
+                this->elements[index] = move(this->elements[parent]);
+                index = parent;
+            }
+            this->elements[index] = move(value);
+        }
+
+        // 把value放到空出来的堆顶, 然后下沉
+        void siftDown(T &&value) {
+            size_t count = this->elements.size();
+            size_t index = 0;
+            while (true) {
+                size_t first = index * ARITY + 1;
+                if (first >= count) {
+                    break;
+                }
+                size_t best = first;
+                size_t end = min(first + ARITY, count);
+                for (size_t child = first + 1; child < end; child++) {
+                    if (this->before(this->elements[child], this->elements[best])) {
+                        best = child;
+                    }
+                }
+                if (!this->before(this->elements[best], value)) {
+                    break;
+                }
+                this->elements[index] = move(this->elements[best]);
+                index = best;
+            }
+            this->elements[index] = move(value);
+        }
+
+        vector<T> elements;
+        B before;
+    };
+
+    /**
+     * 优先级队列, 对应java.util.concurrent.PriorityBlockingQueue, 元素存放在连续数组中的4叉堆里.
+     *
+     * comparator(a, b)返回负数表示a先于b出队; 未指定comparator时, 实现了Prioritized的元素按优先级从高到低出队,
+     * 其余元素的优先级视为最低(INT_MIN). 先后次序相同的元素按入队顺序(FIFO)出队.
+     *
+     * 作为ExecutorService的任务队列时, 用Prioritized::of(priority, runnable)提交任务即可让紧急的任务先执行.
+     * 注意ExecutorService关闭时会放入一些普通Runnable作为退出标记, 它们应当排在所有任务之后:
+     * 默认比较器正是如此; 自定义comparator必须能够处理不认识的Runnable, 并把它们排在最后
+     */
+    template <typename E>
+    class PriorityBlockingQueue : extends AbstractBlockingQueue<E> {
+    public:
+        typedef function<int(const Ref<E>&, const Ref<E>&)> Comparator;
+
+        // capacity默认为INT_MAX, 即无界
+        PriorityBlockingQueue(Comparator comparator = nullptr, int capacity = INT_MAX) :
+            comparator(comparator),
+            capacity(capacity),
+            heap(Before { &this->comparator }) {
+            if (capacity < 1) {
+                throw_new(IllegalArgumentException, "capacity cannot be less than 1");
+            }
+        }
+        virtual ~PriorityBlockingQueue() {}
+
+        int getCapacity() const {
+            return this->capacity;
+        }
+
+    protected:
+        virtual bool locklesslyIsEmpty() override {
+            return this->heap.isEmpty();
+        }
+
         virtual bool locklesslyIsFull() override {
-            return false;
+            return this->heap.size() >= this->capacity;
         }
 
         virtual void locklesslyPush(Ref<E> element) override {
-            this->elements.push_back(element);
+            // 使用默认比较器时, 入队时就取出优先级, 之后的比较不再需要dynamic_cast和虚函数调用
+            int priority = this->comparator == nullptr ? priorityOf(element) : 0;
+            this->heap.push(Entry { element, priority, this->sequence++ });
         }
 
         virtual Ref<E> locklesslyPoll() override {
-            Ref<E> front = this->elements.front();
-            this->elements.pop_front();
-            return front;
+            return this->heap.pop().element;
+        }
+
+        virtual int locklesslySize() override {
+            return this->heap.size();
+        }
+
+        virtual int locklesslyRemainingCapacity() override {
+            return this->capacity == INT_MAX ? INT_MAX : this->capacity - this->heap.size();
+        }
+
+    private:
+        struct Entry {
+            Ref<E> element;
+            int priority;
+            uint64_t sequence;
+        };
+
+        struct Before {
+            const Comparator *comparator;
+            bool operator()(const Entry &a, const Entry &b) const {
+                if (*this->comparator != nullptr) {
+                    int result = (*this->comparator)(a.element, b.element);
+                    if (result != 0) {
+                        return result < 0;
+                    }
+                } else if (a.priority != b.priority) {
+                    return a.priority > b.priority;
+                }
+                return a.sequence < b.sequence;
+            }
+        };
+
+        static int priorityOf(const Ref<E> &element) {
+            Prioritized *prioritized = dynamic_cast<Prioritized*>(element.get());
+            return prioritized != nullptr ? prioritized->getPriority() : INT_MIN;
+        }
+
+        const Comparator comparator;
+        const int capacity;
+        _DaryHeap<Entry, Before> heap;
+        uint64_t sequence = 0;
+    };
+
+    // DelayQueue的实现部分, 被DelayQueue和按需启动的派发线程共同引用
+    template <typename E>
+    class _DelayQueueCore : extends Object {
+    public:
+        _DelayQueueCore() : heap(Before()) {
+            this->availableCondition = new_<Condition>(this->mutex);
+            this->asyncCondition = new_<Condition>(this->mutex);
+        }
+        virtual ~_DelayQueueCore() {}
+
+        // 由DelayQueue的析构函数调用: 停止派发线程, 未完成的异步等待者随本对象一起被释放
+        void close() {
+            pthread_t thread;
+            bool joinable;
+            {
+                Mutex::Scope scope(this->mutex);
+                this->closed = true;
+                this->asyncCondition->notifyAll();
+                thread = this->dispatcherThread;
+                joinable = this->dispatcherJoinable;
+                this->dispatcherJoinable = false;
+            }
+            if (joinable) {
+                // 异步等待者的后续操作可能在派发线程中释放DelayQueue的最后一个引用, 此时不能等待自己
+                if (pthread_equal(thread, pthread_self())) {
+                    pthread_detach(thread);
+                } else {
+                    pthread_join(thread, nullptr);
+                }
+            }
+        }
+
+        void put(Ref<E> element) {
+            if (element == nullptr) {
+                throw_new(IllegalArgumentException, "element cannot be null");
+            }
+            int64_t deadline = deadlineOf(element);
+            Mutex::Scope scope(this->mutex);
+            if (this->locklesslyPush(element, deadline)) {
+                this->signalNewHead(false);
+            }
+        }
+
+        bool offer(Ref<E> element, long) {
+            this->put(element);
+            return true;
+        }
+
+        Ref<E> take() {
+            Mutex::Scope scope(this->mutex);
+            this->locklesslyAwaitExpired(-1);
+            return this->locklesslyPoll();
+        }
+
+        Ref<E> poll(long timeout) {
+            Mutex::Scope scope(this->mutex);
+            if (!this->locklesslyAwaitExpired(timeout)) {
+                return nullptr;
+            }
+            return this->locklesslyPoll();
+        }
+
+        Ref<CompletableFuture<Ref<E>>> takeAsync() {
+            Ref<CompletableFuture<Ref<E>>> future = new_<CompletableFuture<Ref<E>>>();
+            Ref<E> element;
+            {
+                Mutex::Scope scope(this->mutex);
+                if (!this->locklesslyHasExpired() || !this->asyncTakers.empty()) {
+                    this->asyncTakers.push_back(future);
+                    if (!this->asyncDispatcherRunning) {
+                        this->startAsyncDispatcher();
+                    }
+                    return future;
+                }
+                element = this->locklesslyPoll();
+            }
+            future->complete(element);
+            return future;
+        }
+
+        int drainTo(vector<Ref<E>> &elements, int maxElements = INT_MAX) {
+            Mutex::Scope scope(this->mutex);
+            return this->locklesslyDrainTo(elements, maxElements);
+        }
+
+        int drainTo(vector<Ref<E>> &elements, int maxElements, long timeout) {
+            Mutex::Scope scope(this->mutex);
+            if (!this->locklesslyAwaitExpired(timeout)) {
+                return 0;
+            }
+            return this->locklesslyDrainTo(elements, maxElements);
+        }
+
+        void putAll(const vector<Ref<E>> &elements) {
+            this->offerAll(elements);
+        }
+
+        int offerAll(const vector<Ref<E>> &elements) {
+            vector<int64_t> deadlines;
+            deadlines.reserve(elements.size());
+            for (const Ref<E> &element : elements) {
+                deadlines.push_back(deadlineOf(element));
+            }
+            Mutex::Scope scope(this->mutex);
+            bool newHead = false;
+            for (size_t i = 0; i < elements.size(); i++) {
+                newHead |= this->locklesslyPush(elements[i], deadlines[i]);
+            }
+            if (newHead) {
+                this->signalNewHead(elements.size() > 1);
+            }
+            return (int)elements.size();
         }
+
+        int size() {
+            Mutex::Scope scope(this->mutex);
+            return this->heap.size();
+        }
+
     private:
-        list<Ref<E>> elements;
+        struct Entry {
+            int64_t deadline; //System::nanoTime()上的到期时间
+            uint64_t sequence;
+            Ref<E> element;
+        };
+
+        struct Before {
+            bool operator()(const Entry &a, const Entry &b) const {
+                if (a.deadline != b.deadline) {
+                    return a.deadline < b.deadline;
+                }
+                return a.sequence < b.sequence;
+            }
+        };
+
+        static int64_t deadlineOf(const Ref<E> &element) {
+            Delayed *delayed = dynamic_cast<Delayed*>(element.get());
+            int64_t now = System::nanoTime();
+            if (delayed == nullptr) {
+                return now;
+            }
+            int64_t delay = delayed->getDelay();
+            if (delay <= 0) {
+                return now;
+            }
+            return delay >= (INT64_MAX - now) / 1000000 ? INT64_MAX : now + delay * 1000000;
+        }
+
+        // 返回新元素是否成为了堆顶
+        bool locklesslyPush(const Ref<E> &element, int64_t deadline) {
+            uint64_t sequence = this->sequence++;
+            this->heap.push(Entry { deadline, sequence, element });
+            return this->heap.top().sequence == sequence;
+        }
+
+        void signalNewHead(bool all) {
+            if (all) {
+                this->availableCondition->notifyAll();
+            } else {
+                this->availableCondition->notify();
+            }
+            if (!this->asyncTakers.empty()) {
+                this->asyncCondition->notify();
+            }
+        }
+
+        bool locklesslyHasExpired() {
+            return !this->heap.isEmpty() && this->heap.top().deadline <= System::nanoTime();
+        }
+
+        // 必须持有mutex且堆顶已到期; 取出之后如果还有元素, 唤醒下一个等待者去等待新的堆顶
+        Ref<E> locklesslyPoll() {
+            Ref<E> element = this->heap.pop().element;
+            if (!this->heap.isEmpty()) {
+                this->availableCondition->notify();
+            }
+            return element;
+        }
+
+        int locklesslyDrainTo(vector<Ref<E>> &elements, int maxElements) {
+            int count = 0;
+            while (count < maxElements && this->locklesslyHasExpired()) {
+                elements.push_back(this->heap.pop().element);
+                count++;
+            }
+            if (count != 0 && !this->heap.isEmpty()) {
+                this->availableCondition->notify();
+            }
+            return count;
+        }
+
+        // 必须持有mutex, timeout小于0表示无限等待; 等待直到堆顶到期或超时
+        bool locklesslyAwaitExpired(long timeout) {
+            return this->locklesslyAwaitExpired(this->availableCondition, timeout);
+        }
+
+        // 关闭后返回false
+        bool locklesslyAwaitExpired(const Ref<Condition> &condition, long timeout) {
+            int64_t timeoutDeadline = timeout < 0 ? INT64_MAX : System::nanoTime() + (int64_t)timeout * 1000000;
+            while (true) {
+                if (this->closed) {
+                    return false;
+                }
+                int64_t now = System::nanoTime();
+                int64_t wakeUp = this->heap.isEmpty() ? INT64_MAX : this->heap.top().deadline;
+                if (wakeUp <= now) {
+                    return true;
+                }
+                wakeUp = min(wakeUp, timeoutDeadline);
+                if (wakeUp <= now) {
+                    return false;
+                }
+                if (wakeUp == INT64_MAX) {
+                    condition->wait();
+                } else {
+                    condition->wait((time_t)((wakeUp - now + 999999) / 1000000));
+                }
+            }
+        }
+
+        // 必须持有mutex
+        void startAsyncDispatcher() {
+            if (this->dispatcherJoinable) {
+                // 上一个派发线程已在释放锁之后退出(或即将退出), 回收它
+                pthread_join(this->dispatcherThread, nullptr);
+                this->dispatcherJoinable = false;
+            }
+            this->asyncDispatcherRunning = true;
+            this->retain(); //由派发线程释放
+            int error = pthread_create(&this->dispatcherThread, nullptr, asyncDispatcherProc, this);
+            if (error != 0) {
+                this->asyncDispatcherRunning = false;
+                this->asyncTakers.pop_back();
+                this->release();
+                LinuxErrors::handle(error);
+            }
+            this->dispatcherJoinable = true;
+        }
+
+        static void *asyncDispatcherProc(void *data) {
+            _DelayQueueCore<E> *queue = reinterpret_cast<_DelayQueueCore<E>*>(data);
+            defer([queue]() {
+                queue->release();
+            });
+            queue->dispatchAsyncTakers();
+            return nullptr;
+        }
+
+        void dispatchAsyncTakers() {
+            while (true) {
+                Ref<CompletableFuture<Ref<E>>> asyncTaker;
+                Ref<E> element;
+                {
+                    Mutex::Scope scope(this->mutex);
+                    if (this->asyncTakers.empty() || !this->locklesslyAwaitExpired(this->asyncCondition, -1)) {
+                        this->asyncDispatcherRunning = false;
+                        return;
+                    }
+                    asyncTaker = this->asyncTakers.front();
+                    this->asyncTakers.pop_front();
+                    element = this->locklesslyPoll();
+                }
+                asyncTaker->complete(element);
+            }
+        }
+
+        Mutex mutex;
+        Ref<Condition> availableCondition;
+        Ref<Condition> asyncCondition;
+        _DaryHeap<Entry, Before> heap;
+        uint64_t sequence = 0;
+        list<Ref<CompletableFuture<Ref<E>>>> asyncTakers;
+        bool asyncDispatcherRunning = false;
+        bool dispatcherJoinable = false;
+        pthread_t dispatcherThread = pthread_t();
+        bool closed = false;
+    };
+
+    /**
+     * 延迟队列, 对应java.util.concurrent.DelayQueue: 元素只有到期(Delayed::getDelay() <= 0)之后才能被取出,
+     * 到期时间早的先出队. 没有实现Delayed的元素视为已到期. 队列是无界的, put和offer从不阻塞.
+     *
+     * 元素的到期时间在入队时由getDelay()换算为单调时钟上的绝对时间并保存在堆中,
+     * 之后的比较和等待都不再调用getDelay(); 因此元素的到期时间在入队后不应再改变.
+     * take和poll只等待到堆顶元素到期为止, 新的堆顶入队时才唤醒等待者重新计算.
+     * size()包括尚未到期的元素, drainTo只取出已到期的元素.
+     *
+     * 作为ExecutorService的任务队列时, 用Delayed::of(delay, runnable)提交任务即可实现简单的截止时间调度;
+     * ExecutorService关闭时放入的退出标记是立即到期的, 所以尚未到期的任务会被放弃
+     */
+    template <typename E>
+    class DelayQueue : extends Object, implements BlockingQueue<E> {
+    public:
+        DelayQueue() : core(new_<_DelayQueueCore<E>>()) {}
+        virtual ~DelayQueue() {
+            this->core->close();
+        }
+
+        virtual void put(Ref<E> element) override {
+            this->core->put(element);
+        }
+
+        virtual bool offer(Ref<E> element, long timeout) override {
+            return this->core->offer(element, timeout);
+        }
+
+        virtual Ref<E> take() override {
+            return this->core->take();
+        }
+
+        virtual Ref<E> poll(long timeout) override {
+            return this->core->poll(timeout);
+        }
+
+        /*
+         * 有已到期的元素时返回已完成的future; 否则由一个按需启动的派发线程在元素到期时完成它.
+         * 派发线程只引用内部的_DelayQueueCore, 在没有异步等待者或DelayQueue被析构时退出,
+         * 所以被丢弃的future不会使队列和线程泄漏
+         */
+        virtual Ref<CompletableFuture<Ref<E>>> takeAsync() override {
+            return this->core->takeAsync();
+        }
+
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements = INT_MAX) override {
+            return this->core->drainTo(elements, maxElements);
+        }
+
+        virtual int drainTo(vector<Ref<E>> &elements, int maxElements, long timeout) override {
+            return this->core->drainTo(elements, maxElements, timeout);
+        }
+
+        virtual void putAll(const vector<Ref<E>> &elements) override {
+            BlockingQueue<E>::checkElements(elements);
+            this->core->putAll(elements);
+        }
+
+        virtual int offerAll(const vector<Ref<E>> &elements) override {
+            BlockingQueue<E>::checkElements(elements);
+            return this->core->offerAll(elements);
+        }
+
+        virtual int size() override {
+            return this->core->size();
+        }
+
+        virtual int remainingCapacity() override {
+            return INT_MAX;
+        }
+
+    private:
+        Ref<_DelayQueueCore<E>> core;
+
+        interface_refcount()
     };
 }
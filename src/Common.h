@@ -197,6 +197,7 @@ namespace com_lanjing_cpp_common {
     using namespace std;
 
     template <typename T> struct Ref;
+    struct Reclamation;
     template <typename T, typename ...Args> Ref<T> newObject(Args &&...args);
     template <typename T> Ref<T> newInternalObject(function<void(void*)> constructor);
     template <typename E, typename ...Args> __noreturn void throwNewException(Args &&...);
@@ -239,6 +240,159 @@ namespace com_lanjing_cpp_common {
         }
     };
 
+    /**
+     * LongAdder和LongAccumulator的公共部分, 对应JDK中的java.util.concurrent.atomic.Striped64
+     *
+     * 无竞争时只操作base; 一旦对base的CAS失败(出现竞争), 就惰性地创建一组按缓存行隔离的cell,
+     * 此后各线程根据自己的探针值分散到不同的cell上, 避免所有线程争抢同一个缓存行
+     */
+    struct Striped64 {
+    public:
+        ~Striped64() {
+            delete[] this->cells.load();
+        }
+        Striped64(const Striped64 &) = delete;
+        Striped64 &operator = (const Striped64 &) = delete;
+    protected:
+        struct Cell {
+            atomic<int64_t> value;
+            char padding[128 - sizeof(atomic<int64_t>)]; //两个相邻cell的value至少相隔128字节, 不会落在同一缓存行(及其预取伙伴)中
+        };
+        Striped64(int64_t initialValue) : base(initialValue), cells(nullptr), mask(0) {}
+        Cell *inflate(int64_t identity) {
+            Cell *cs = this->cells.load(memory_order_acquire);
+            if (cs == nullptr) {
+                long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+                int size = 2;
+                while (size < cpuCount) {
+                    size <<= 1;
+                }
+                Cell *newCells = new Cell[size];
+                for (int i = 0; i < size; i++) {
+                    newCells[i].value.store(identity, memory_order_relaxed);
+                }
+                if (this->cells.compare_exchange_strong(cs, newCells)) {
+                    this->mask.store(size - 1, memory_order_release);
+                    cs = newCells;
+                } else {
+                    delete[] newCells;
+                }
+            }
+            return cs;
+        }
+        Cell &cellOf(Cell *cs) {
+            int m = this->mask.load(memory_order_acquire);
+            return cs[probe() & m]; //mask尚未发布时为0, 退化为使用第一个cell
+        }
+        static unsigned probe() {
+            static atomic<unsigned> seed(0);
+            static thread_local unsigned value = seed.fetch_add(0x9E3779B9u, memory_order_relaxed) * 0x85EBCA6Bu;
+            return value ^ (value >> 16);
+        }
+        atomic<int64_t> base;
+        atomic<Cell*> cells;
+        atomic<int> mask;
+    };
+
+    // java.util.concurrent.atomic.LongAdder, 适合被大量线程频繁累加但很少读取的统计计数器
+    struct LongAdder : private Striped64 {
+    public:
+        LongAdder() : Striped64(0) {}
+        void add(int64_t x) {
+            Cell *cs = this->cells.load(memory_order_acquire);
+            if (cs == nullptr) {
+                int64_t b = this->base.load(memory_order_relaxed);
+                if (this->base.compare_exchange_weak(b, b + x, memory_order_relaxed)) {
+                    return;
+                }
+                cs = this->inflate(0);
+            }
+            this->cellOf(cs).value.fetch_add(x, memory_order_relaxed);
+        }
+        void increment() {
+            this->add(1);
+        }
+        void decrement() {
+            this->add(-1);
+        }
+        // 并发累加时返回的并非原子快照, 这一点和Java相同
+        int64_t sum() const {
+            int64_t sum = this->base.load(memory_order_relaxed);
+            Cell *cs = this->cells.load(memory_order_acquire);
+            if (cs != nullptr) {
+                for (int i = this->mask.load(memory_order_acquire); i >= 0; --i) {
+                    sum += cs[i].value.load(memory_order_relaxed);
+                }
+            }
+            return sum;
+        }
+        void reset() {
+            this->sumThenReset();
+        }
+        int64_t sumThenReset() {
+            int64_t sum = this->base.exchange(0, memory_order_relaxed);
+            Cell *cs = this->cells.load(memory_order_acquire);
+            if (cs != nullptr) {
+                for (int i = this->mask.load(memory_order_acquire); i >= 0; --i) {
+                    sum += cs[i].value.exchange(0, memory_order_relaxed);
+                }
+            }
+            return sum;
+        }
+    };
+
+    // java.util.concurrent.atomic.LongAccumulator, accumulator必须满足交换律和结合律(如max, min)
+    struct LongAccumulator : private Striped64 {
+    public:
+        LongAccumulator(function<int64_t(int64_t, int64_t)> accumulator, int64_t identity) :
+            Striped64(identity), accumulator(accumulator), identity(identity) {}
+        void accumulate(int64_t x) {
+            Cell *cs = this->cells.load(memory_order_acquire);
+            if (cs == nullptr) {
+                int64_t b = this->base.load(memory_order_relaxed);
+                int64_t r = this->accumulator(b, x);
+                if (r == b || this->base.compare_exchange_weak(b, r, memory_order_relaxed)) {
+                    return;
+                }
+                cs = this->inflate(this->identity);
+            }
+            atomic<int64_t> &value = this->cellOf(cs).value;
+            int64_t v = value.load(memory_order_relaxed);
+            while (true) {
+                int64_t r = this->accumulator(v, x);
+                if (r == v || value.compare_exchange_weak(v, r, memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+        int64_t get() const {
+            int64_t result = this->base.load(memory_order_relaxed);
+            Cell *cs = this->cells.load(memory_order_acquire);
+            if (cs != nullptr) {
+                for (int i = this->mask.load(memory_order_acquire); i >= 0; --i) {
+                    result = this->accumulator(result, cs[i].value.load(memory_order_relaxed));
+                }
+            }
+            return result;
+        }
+        void reset() {
+            this->getThenReset();
+        }
+        int64_t getThenReset() {
+            int64_t result = this->base.exchange(this->identity, memory_order_relaxed);
+            Cell *cs = this->cells.load(memory_order_acquire);
+            if (cs != nullptr) {
+                for (int i = this->mask.load(memory_order_acquire); i >= 0; --i) {
+                    result = this->accumulator(result, cs[i].value.exchange(this->identity, memory_order_relaxed));
+                }
+            }
+            return result;
+        }
+    private:
+        function<int64_t(int64_t, int64_t)> accumulator;
+        int64_t identity;
+    };
+
     // java.util.concurrent.lock.Lock
     struct Mutex {
     public:
@@ -374,10 +528,93 @@ namespace com_lanjing_cpp_common {
         pthread_rwlock_t rwl;
         bool reentrant;
         PThreadId writingThreadId;
-        volatile int writingRecursiveDepth = 0;
+        int writingRecursiveDepth = 0;
         friend struct WritingScope;
     };
 
+    /**
+     * 事件计数器(eventcount), 为无锁算法提供"仅在条件不满足时才挂起"的能力
+     *
+     * 等待方的用法:
+     *     auto key = eventCount.prepareWait();
+     *     if (条件已满足) { eventCount.cancelWait(); } else { eventCount.wait(key); }
+     * 通知方在改变条件之后调用notify/notifyAll, 没有等待者时只需一次原子读, 不触碰任何锁
+     */
+    struct EventCount {
+    public:
+        EventCount() : epoch(0), waiters(0) {
+            LinuxErrors::handle(pthread_mutex_init(&this->mtx, nullptr), "Cannot initialize EventCount");
+            LinuxErrors::handle(pthread_cond_init(&this->cond, nullptr), "Cannot initialize EventCount");
+        }
+        ~EventCount() {
+            pthread_cond_destroy(&this->cond);
+            pthread_mutex_destroy(&this->mtx);
+        }
+        unsigned prepareWait() {
+            this->waiters.fetch_add(1); //seq_cst, 和通知方对waiters的读取构成Dekker式同步
+            return this->epoch.load();
+        }
+        void cancelWait() {
+            this->waiters.fetch_sub(1);
+        }
+        void wait(unsigned key) {
+            pthread_mutex_lock(&this->mtx);
+            while (this->epoch.load(memory_order_relaxed) == key) {
+                pthread_cond_wait(&this->cond, &this->mtx);
+            }
+            pthread_mutex_unlock(&this->mtx);
+            this->waiters.fetch_sub(1);
+        }
+        // deadlineMillis为gettimeofday时间轴上的绝对毫秒数, 超时返回false
+        bool wait(unsigned key, int64_t deadlineMillis) {
+            struct timespec ts;
+            ts.tv_sec = deadlineMillis / 1000;
+            ts.tv_nsec = (deadlineMillis % 1000) * 1000 * 1000;
+            bool signaled = true;
+            pthread_mutex_lock(&this->mtx);
+            while (this->epoch.load(memory_order_relaxed) == key) {
+                if (pthread_cond_timedwait(&this->cond, &this->mtx, &ts) == ETIMEDOUT) {
+                    signaled = this->epoch.load(memory_order_relaxed) != key;
+                    break;
+                }
+            }
+            pthread_mutex_unlock(&this->mtx);
+            this->waiters.fetch_sub(1);
+            return signaled;
+        }
+        bool hasWaiters() const {
+            return this->waiters.load() != 0;
+        }
+        void notify() {
+            this->notify(false);
+        }
+        void notifyAll() {
+            this->notify(true);
+        }
+
+        EventCount(const EventCount &) = delete;
+        EventCount &operator = (const EventCount &) = delete;
+    private:
+        void notify(bool all) {
+            atomic_thread_fence(memory_order_seq_cst);
+            if (this->waiters.load() == 0) {
+                return;
+            }
+            pthread_mutex_lock(&this->mtx);
+            this->epoch.fetch_add(1, memory_order_relaxed);
+            if (all) {
+                pthread_cond_broadcast(&this->cond);
+            } else {
+                pthread_cond_signal(&this->cond);
+            }
+            pthread_mutex_unlock(&this->mtx);
+        }
+        atomic<unsigned> epoch;
+        atomic<int> waiters;
+        pthread_mutex_t mtx;
+        pthread_cond_t cond;
+    };
+
     // 资源释放器，不被直接使用
     // (无视异常，在析构时执行一个任意复杂的Lambda表达式，弥补标准C++不支持try/finally的遗憾)
     struct Finalizer {
@@ -410,10 +647,10 @@ namespace com_lanjing_cpp_common {
     public:
 #ifdef DEBUG
         Object() : refCount(1) {
-            memoryLeakMonitor().globalObjCount++;
+            memoryLeakMonitor().globalObjCount.increment();
         }
         virtual ~Object() {
-            --memoryLeakMonitor().globalObjCount;
+            memoryLeakMonitor().globalObjCount.decrement();
         }
 
 #else
@@ -426,6 +663,19 @@ namespace com_lanjing_cpp_common {
             assert(greaterThanOne > 1);
         }
         virtual void release();
+        /*
+         * 仅当引用计数尚未耗尽且对象不在finalize之中时才增加引用计数并返回true,
+         * 供无锁数据结构的读者在拿到原始指针后使用(参见Reclamation.h), 普通代码请使用Ref<T>
+         */
+        bool tryRetain() {
+            int count = this->refCount.load();
+            while (count > 0 && count < FINALIZING_REF_COUNT) {
+                if (this->refCount.compareAndExchange(count, count + 1)) {
+                    return true;
+                }
+            }
+            return false;
+        }
         virtual string toString() const {
             ostringstream builder;
             builder << className(this) << "@" << this;
@@ -516,8 +766,18 @@ namespace com_lanjing_cpp_common {
          * 这是和Java相比很大的一个区别
          */
         virtual void finalize() {}
+        /*
+         * 引用计数耗尽时被调用, 默认立即执行finalize并析构.
+         * 无锁数据结构中可能仍被其他线程以原始指针访问的对象可以重写此方法,
+         * 将这一过程推迟到所有读者都离开之后(参见Reclamation.h中的Reclaimable)
+         */
+        virtual void reclaim() {
+            this->finalizeAndDelete();
+        }
 
     private:
+        void finalizeAndDelete();
+
         struct GlobalContext {
             Mutex weakRefMutex;
             map<const type_info*, string> classNameMap;
@@ -610,7 +870,7 @@ namespace com_lanjing_cpp_common {
         struct MemoryLeakMonitor {
         public:
             ~MemoryLeakMonitor() {
-                int goc = this->globalObjCount;
+                int64_t goc = this->globalObjCount.sum();
                 if (goc == 0) {
                     cerr << "All the objects are deleted" << endl;
                 } else {
@@ -628,7 +888,7 @@ namespace com_lanjing_cpp_common {
                             << endl;
                 }
             }
-            AtomicInteger globalObjCount;
+            LongAdder globalObjCount;
             void retainAtFirst(const string &className) {
                 Mutex::Scope scope(this->mutex);
                 auto itr = this->retainedObjCountMap.find(className);
@@ -657,11 +917,18 @@ namespace com_lanjing_cpp_common {
 #endif //DEBUG
 
     private:
+        /*
+         * finalize期间引用计数被整体抬高这么多, 使得finalize中的retain/release仍然正常配对,
+         * 而tryRetain(以及基于它的WeakRef::get)能够识别出濒死对象并拒绝将其复活
+         */
+        static const int FINALIZING_REF_COUNT = 1 << 30;
+
         AtomicInteger refCount;
         _IWR invalidWeakRef; //Object自身内置一个非法的弱引用，同其他合法的弱引用构成双向环链
         Mutex iwrMutex;
 
         friend struct Object::_WR;
+        friend struct Reclamation;
         template <typename T> friend struct WeakRef;
         template <typename E, typename A> friend class _Array;
         template <typename T, typename ...Args> friend Ref<T> newObject(Args &&...);
@@ -1073,11 +1340,15 @@ namespace com_lanjing_cpp_common {
         int error;
     };
 
+    /**
+     * 计数信号量
+     *
+     * 许可数量保存在原子变量中, 许可充足时acquire/signal仅需一次CAS或原子加, 不加任何锁;
+     * 只有在许可不足时才通过EventCount挂起, 且signal仅在确有等待者时才会触碰锁
+     */
     class Semaphore : extends Object {
     public:
-        Semaphore(int permits = 0) : permits(permits) {
-            this->condition = new_<Condition>(this->mutex);
-        }
+        Semaphore(int permits = 0) : permits(permits) {}
         virtual ~Semaphore() {}
         void acquire(int permits = 1) {
             if (permits == 0) {
@@ -1086,11 +1357,24 @@ namespace com_lanjing_cpp_common {
             if (permits < 0) {
                 throw_new(IllegalArgumentException, "argument cannot be negative number")
             }
-            Mutex::Scope scope(this->mutex);
-            while (this->permits < permits) {
-                this->condition->wait();
+            if (this->tryAcquireLocklessly(permits)) {
+                return;
+            }
+            while (true) {
+                unsigned key = this->eventCount.prepareWait();
+                if (this->tryAcquireLocklessly(permits)) {
+                    this->eventCount.cancelWait();
+                    break;
+                }
+                this->eventCount.wait(key);
+            }
+            this->propagate();
+        }
+        bool tryAcquire(int permits = 1) {
+            if (permits < 0) {
+                throw_new(IllegalArgumentException, "argument cannot be negative number")
             }
-            this->permits -= permits;
+            return permits == 0 || this->tryAcquireLocklessly(permits);
         }
         bool tryAcquire(int permits, time_t timeout) {
             if (timeout < 0) {
@@ -1103,26 +1387,27 @@ namespace com_lanjing_cpp_common {
             if (permits < 0) {
                 throw_new(IllegalArgumentException, "argument cannot be negative number")
             }
+            if (this->tryAcquireLocklessly(permits)) {
+                return true;
+            }
             struct timeval tv;
             gettimeofday(&tv,NULL);
-            time_t time =  tv.tv_sec * 1000 + tv.tv_usec / 1000;
-            time_t endTime = time + timeout;
-            Mutex::Scope scope(this->mutex);
-            if (this->permits < permits) {
-                while (true) {
-                    this->condition->wait(endTime - time);
-                    if (this->permits >= permits) {
-                        break;
-                    }
-                    gettimeofday(&tv,NULL);
-                    time_t time =  tv.tv_sec * 1000 + tv.tv_usec / 1000;
-                    if (time >= endTime) {
-                        return false;
-                    }
+            int64_t endTime = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 + timeout;
+            bool acquired = false;
+            while (true) {
+                unsigned key = this->eventCount.prepareWait();
+                if (this->tryAcquireLocklessly(permits)) {
+                    this->eventCount.cancelWait();
+                    acquired = true;
+                    break;
+                }
+                if (!this->eventCount.wait(key, endTime)) {
+                    acquired = this->tryAcquireLocklessly(permits);
+                    break;
                 }
             }
-            this->permits -= permits;
-            return true;
+            this->propagate();
+            return acquired;
         }
         void signal(int permits = 1) {
             if (permits == 0) {
@@ -1131,18 +1416,40 @@ namespace com_lanjing_cpp_common {
             if (permits < 0) {
                 throw_new(IllegalArgumentException, "argument cannot be negative number")
             }
-            Mutex::Scope scope(this->mutex);
-            this->permits += permits;
+            this->permits.fetch_add(permits);
             if (permits > 1) {
-                this->condition->notifyAll();
+                this->eventCount.notifyAll();
             } else {
-                this->condition->notify();
+                this->eventCount.notify();
             }
         }
+        int availablePermits() const {
+            return this->permits.load();
+        }
+        // 获取并返回当前所有可用许可
+        int drainPermits() {
+            int current = this->permits.load();
+            while (current > 0 && !this->permits.compareAndExchange(current, 0));
+            return current > 0 ? current : 0;
+        }
     private:
-        Mutex mutex;
-        int permits;
-        Ref<Condition> condition;
+        bool tryAcquireLocklessly(int permits) {
+            int current = this->permits.load(memory_order_relaxed);
+            while (current >= permits) {
+                if (this->permits.compareAndExchange(current, current - permits)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        // 单个notify唤醒的线程可能并未用完许可(或已超时), 将剩余许可的唤醒机会传递给其他等待者
+        void propagate() {
+            if (this->permits.load() > 0 && this->eventCount.hasWaiters()) {
+                this->eventCount.notify();
+            }
+        }
+        AtomicInteger permits;
+        EventCount eventCount;
     };
 
     // 引用计数数组，内存管理部分和实际数据部分共享一段内存，对象长度未知。
@@ -1155,7 +1462,7 @@ namespace com_lanjing_cpp_common {
                 allocator<E> elementAllocator;
                 E *p = this->unsafe();
                 for (int i = this->size - 1; i >= 0; --i) {
-                    elementAllocator.destroy(p + i);
+                    allocator_traits<allocator<E>>::destroy(elementAllocator, p + i);
                 }
             }
         }
@@ -1222,11 +1529,11 @@ namespace com_lanjing_cpp_common {
                     allocator<E> elementAllocator;
                     if (src) {
                         for (int i = 0; i < size; i++) {
-                            elementAllocator.construct(p + i, src[i]);
+                            allocator_traits<allocator<E>>::construct(elementAllocator, p + i, src[i]);
                         }
                     } else {
                         for (int i = 0; i < size; i++) {
-                            elementAllocator.construct(p + i);
+                            allocator_traits<allocator<E>>::construct(elementAllocator, p + i);
                         }
                     }
                 }
@@ -1490,26 +1797,30 @@ namespace com_lanjing_cpp_common {
 
     inline void Object::release() {
         if (--this->refCount == 0) { //引用计数耗尽, 尝试释放对象
-            ++this->refCount; //暂时提升引用计数, 防止后续finalize中触发对象的二次释放导致崩溃, 也为对象复活做准备
-            defer([=]{
-                if (--this->refCount == 0) { //如果在finalize执行后, 引用计数仍然为0, 真正释放对象, 不复活
-                    defer([=]{
-                        delete this;
-                    });
+            this->reclaim();
+        }
+    }
+
+    inline void Object::finalizeAndDelete() {
+        this->refCount += FINALIZING_REF_COUNT + 1; //暂时提升引用计数, 防止后续finalize中触发对象的二次释放导致崩溃, 也为对象复活做准备
+        defer([this]{
+            if ((this->refCount -= FINALIZING_REF_COUNT + 1) == 0) { //如果在finalize执行后, 引用计数仍然为0, 真正释放对象, 不复活
+                defer([this]{
+                    delete this;
+                });
 #ifdef DEBUG
-                    defer([=]{
-                        string className = Object::className(this);
-                        memoryLeakMonitor().releaseAtLast(className);
-                    });
+                defer([this]{
+                    string className = Object::className(this);
+                    memoryLeakMonitor().releaseAtLast(className);
+                });
 #endif //DEBUG
-                    this->clearWeakReferences(); //清除弱引用
-                } else {
-                    this->resurrect();
-                }
-            });
+                this->clearWeakReferences(); //清除弱引用
+            } else {
+                this->resurrect();
+            }
+        });
 
-            this->finalize(); //调用用户的finalize, 如果其中对引用计数的增加操作多于减少操作, 会导致对象复活
-        }
+        this->finalize(); //调用用户的finalize, 如果其中对引用计数的增加操作多于减少操作, 会导致对象复活
     }
 
     inline Object::_WR::_WR(Object *target) : _IWR(0), target(target) {
@@ -1548,7 +1859,12 @@ namespace com_lanjing_cpp_common {
 
     template <typename T> Ref<T> WeakRef<T>::get(bool validate) const {
         Mutex::Scope scope(Object::globalContext().weakRefMutex);
-        Ref<T> ref = dynamic_cast<T*>(this->target);
+        Ref<T> ref;
+        Object *target = this->target;
+        if (target != nullptr && target->tryRetain()) { //目标的引用计数可能已经耗尽, 只是尚未被回收
+            ref = dynamic_cast<T*>(target);
+            target->release();
+        }
         if (validate && ref == nullptr) {
             ostringstream builder;
             builder
@@ -1592,7 +1908,7 @@ namespace com_lanjing_cpp_common {
     template <typename T, typename ...Args> Ref<T> newObject(Args &&...args) {
         Ref<T> ref;
         T *p = ref.allocate(sizeof(T));
-        new(p) T(args...);
+        new(p) T(forward<Args>(args)...);
         static_cast<Object*>(p)->willBeExported();
         return ref;
     }
@@ -0,0 +1,691 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Executor.h"
+#include "Auxiliary.h"
+#include <vector>
+#include <type_traits>
+
+namespace com_lanjing_cpp_common {
+
+    using namespace std;
+
+    class ExecutionException : extends Exception {
+    public:
+        ExecutionException(exception_param_prefix, const string &message, Ref<Exception> cause = nullptr) :
+            Exception(exception_arg_prefix, message, cause) {}
+    };
+
+    class TimeoutException : extends Exception {
+    public:
+        TimeoutException(exception_param_prefix, const string &message, Ref<Exception> cause = nullptr) :
+            Exception(exception_arg_prefix, message, cause) {}
+    };
+
+    template <typename T> class CompletableFuture;
+
+    // 返回void的回调被视为返回true, 从而CompletableFuture<T>总能被实例化(对应Java中的CompletableFuture<Void>)
+    template <typename R>
+    struct _FutureValue {
+        typedef R Type;
+        template <typename F, typename ...Args>
+        static R invoke(F &fn, Args &...args) {
+            return fn(args...);
+        }
+    };
+    template <>
+    struct _FutureValue<void> {
+        typedef bool Type;
+        template <typename F, typename ...Args>
+        static bool invoke(F &fn, Args &...args) {
+            fn(args...);
+            return true;
+        }
+    };
+    template <typename F, typename ...Args>
+    using _FutureCall = _FutureValue<typename decay<decltype(declval<F&>()(declval<Args&>()...))>::type>;
+    template <typename F, typename ...Args>
+    using _FutureValueOf = typename _FutureCall<F, Args...>::Type;
+
+    template <typename R> struct _ComposedFutureValue; //未定义, thenCompose的回调必须返回Ref<CompletableFuture<U>>
+    template <typename U> struct _ComposedFutureValue<Ref<CompletableFuture<U>>> {
+        typedef U Type;
+    };
+
+    /**
+     * CompletableFuture<T>中与T无关的部分: 状态字、后续操作栈和阻塞等待
+     *
+     * 状态字要么指向尚未触发的后续操作栈(Treiber栈), 要么指向打上COMPLETED标记的结果对象;
+     * 完成操作仅需一次成功的CAS就同时完成了"抢占完成权", "发布结果"和"摘下整个后续操作栈"三件事,
+     * 之后按注册顺序触发所有后续操作, 全程无锁. 注册后续操作时若发现已经完成, 则立即触发
+     */
+    abstract class AbstractCompletableFuture : extends Object {
+    public:
+        virtual ~AbstractCompletableFuture() {
+            void *state = this->state.load(memory_order_acquire);
+            if (isResult(state)) {
+                delete toResult(state);
+            } else {
+                for (Completion *completion = static_cast<Completion*>(state); completion != nullptr; ) {
+                    Completion *next = completion->next;
+                    completion->owner()->release();
+                    completion = next;
+                }
+            }
+        }
+        bool isDone() const {
+            return isResult(this->state.load(memory_order_acquire));
+        }
+        bool isCompletedExceptionally() const {
+            Result *result = this->result();
+            return result != nullptr && result->exception != nullptr;
+        }
+        // 尚未完成或者正常完成时返回nullptr
+        Ref<Exception> getException() const {
+            Result *result = this->result();
+            return result != nullptr ? result->exception : nullptr;
+        }
+        bool completeExceptionally(Ref<Exception> exception) {
+            if (exception == nullptr) {
+                throw_new(NullPointerException, "exception cannot be nullptr");
+            }
+            return this->completeWith(new Result(exception));
+        }
+
+        // 所有future都完成后以true完成; 任何一个异常完成, 返回的future也立即以该异常完成
+        static Ref<CompletableFuture<bool>> allOf(const vector<Ref<AbstractCompletableFuture>> &futures);
+
+    protected:
+        struct Result {
+            Result(Ref<Exception> exception) : exception(exception) {}
+            virtual ~Result() {}
+            Ref<Exception> exception;
+        };
+
+        // 后续操作栈的节点, 压栈时retain其owner, 触发或被丢弃后release
+        struct Completion {
+            Completion() : next(nullptr) {}
+            virtual ~Completion() {}
+            virtual Object *owner() = 0;
+            // source完成后被调用, 且只被调用一次
+            virtual void fire(AbstractCompletableFuture *source) = 0;
+            // 已被放弃(例如超时的等待者)的节点不必再触发, 可以被cleanStack移除
+            virtual bool isAbandoned() {
+                return false;
+            }
+            Completion *next;
+        };
+
+        // 把触发转发给subscriber, 使一个对象可以同时挂在多个future的后续操作栈上
+        template <typename S>
+        struct Subscription : Completion {
+            Subscription() : subscriber(nullptr), index(0) {}
+            virtual Object *owner() override {
+                return this->subscriber;
+            }
+            virtual void fire(AbstractCompletableFuture *source) override {
+                this->subscriber->onComplete(source, this->index);
+            }
+            S *subscriber;
+            int index;
+        };
+
+        AbstractCompletableFuture() : state(nullptr) {}
+
+        // 尚未完成时返回nullptr
+        Result *result() const {
+            void *state = this->state.load(memory_order_acquire);
+            return isResult(state) ? toResult(state) : nullptr;
+        }
+
+        bool completeWith(Result *result) {
+            void *state = this->state.load(memory_order_acquire);
+            do {
+                if (isResult(state)) {
+                    delete result;
+                    return false;
+                }
+            } while (!this->state.compare_exchange_weak(state, toState(result), memory_order_acq_rel, memory_order_acquire));
+            Completion *completions = nullptr;
+            for (Completion *completion = static_cast<Completion*>(state); completion != nullptr; ) { //后进先出改为注册顺序
+                Completion *next = completion->next;
+                completion->next = completions;
+                completions = completion;
+                completion = next;
+            }
+            // 后续操作可能释放掉当前future的最后一个外部引用
+            Ref<AbstractCompletableFuture> keepAlive = this;
+            while (completions != nullptr) {
+                Completion *next = completions->next;
+                this->fire(completions);
+                completions = next;
+            }
+            return true;
+        }
+
+        void push(Completion *completion) {
+            completion->owner()->retain();
+            void *state = this->state.load(memory_order_acquire);
+            do {
+                if (isResult(state)) {
+                    this->fire(completion);
+                    return;
+                }
+                completion->next = static_cast<Completion*>(state);
+            } while (!this->state.compare_exchange_weak(state, completion, memory_order_release, memory_order_acquire));
+        }
+
+        // 等待完成, deadlineMillis为System::currentTimeMillis时间轴上的绝对时间, 小于0表示无限等待; 超时返回false
+        bool await(int64_t deadlineMillis) {
+            if (this->isDone()) {
+                return true;
+            }
+            Ref<Signaller> signaller = new_<Signaller>();
+            this->push(signaller.get());
+            while (!this->isDone()) {
+                unsigned key = signaller->eventCount.prepareWait();
+                if (this->isDone()) {
+                    signaller->eventCount.cancelWait();
+                    break;
+                }
+                if (deadlineMillis < 0) {
+                    signaller->eventCount.wait(key);
+                } else if (!signaller->eventCount.wait(key, deadlineMillis)) {
+                    if (this->isDone()) {
+                        return true;
+                    }
+                    // 否则反复调用get(timeout)会使后续操作栈无限增长
+                    signaller->abandoned.store(true, memory_order_release);
+                    this->cleanStack();
+                    return this->isDone();
+                }
+            }
+            return true;
+        }
+
+    private:
+        static const uintptr_t COMPLETED = 1;
+
+        static bool isResult(void *state) {
+            return (reinterpret_cast<uintptr_t>(state) & COMPLETED) != 0;
+        }
+        static Result *toResult(void *state) {
+            return reinterpret_cast<Result*>(reinterpret_cast<uintptr_t>(state) & ~COMPLETED);
+        }
+        static void *toState(Result *result) {
+            return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(result) | COMPLETED);
+        }
+
+        /*
+         * 移除已被放弃的节点(对应Java的cleanStack). 其他线程可能同时压栈或完成, 所以不能修改栈中间的节点:
+         * 先用一次CAS摘下整个栈, 过滤后再整体放回; 若期间有新的节点压栈, 则逐个放回(此时它们排在新节点之后触发),
+         * 若期间已经完成, 则就地触发它们. 每个节点仍然恰好被触发一次
+         */
+        void cleanStack() {
+            void *state = this->state.load(memory_order_acquire);
+            do {
+                if (state == nullptr || isResult(state)) {
+                    return;
+                }
+            } while (!this->state.compare_exchange_weak(state, nullptr, memory_order_acq_rel, memory_order_acquire));
+            Completion *head = nullptr;
+            Completion *last = nullptr;
+            for (Completion *completion = static_cast<Completion*>(state); completion != nullptr; ) {
+                Completion *next = completion->next;
+                if (completion->isAbandoned()) {
+                    completion->owner()->release();
+                } else {
+                    completion->next = nullptr;
+                    if (last == nullptr) {
+                        head = completion;
+                    } else {
+                        last->next = completion;
+                    }
+                    last = completion;
+                }
+                completion = next;
+            }
+            if (head == nullptr) {
+                return;
+            }
+            void *expected = nullptr;
+            if (this->state.compare_exchange_strong(expected, head, memory_order_release, memory_order_acquire)) {
+                return;
+            }
+            Completion *completions = nullptr;
+            for (Completion *completion = head; completion != nullptr; ) { //后进先出改为注册顺序
+                Completion *next = completion->next;
+                completion->next = completions;
+                completions = completion;
+                completion = next;
+            }
+            Ref<AbstractCompletableFuture> keepAlive = this;
+            while (completions != nullptr) {
+                Completion *next = completions->next;
+                this->relink(completions);
+                completions = next;
+            }
+        }
+
+        // 同push, 但节点的owner已经被retain过
+        void relink(Completion *completion) {
+            void *state = this->state.load(memory_order_acquire);
+            do {
+                if (isResult(state)) {
+                    this->fire(completion);
+                    return;
+                }
+                completion->next = static_cast<Completion*>(state);
+            } while (!this->state.compare_exchange_weak(state, completion, memory_order_release, memory_order_acquire));
+        }
+
+        void fire(Completion *completion) {
+            Object *owner = completion->owner();
+            defer([=] {
+                owner->release();
+            });
+            completion->fire(this);
+        }
+
+        class Signaller : extends Object, public Completion {
+        public:
+            virtual Object *owner() override {
+                return this;
+            }
+            virtual void fire(AbstractCompletableFuture *) override {
+                this->eventCount.notifyAll();
+            }
+            virtual bool isAbandoned() override {
+                return this->abandoned.load(memory_order_acquire);
+            }
+            EventCount eventCount;
+            atomic<bool> abandoned { false };
+        };
+
+        atomic<void*> state;
+
+        template <typename> friend struct _FutureAwaiter;
+    };
+
+    /**
+     * 对应java.util.concurrent.CompletableFuture<T>
+     *
+     * 所有后续操作(thenApply, thenCompose, thenCombine, exceptionally)的最后一个参数executor决定回调在哪里执行:
+     * 为nullptr时在完成当前future的线程中就地执行(若注册时已经完成, 则在注册线程中执行), 否则提交给executor.
+     * 回调可以是lambda表达式, 也可以是Ref<Function<...>>; 回调返回void时, 得到的future以true完成
+     *
+     *     Ref<CompletableFuture<int>> future = executorService->submit(Supplier<int>::of([] { return 6; }));
+     *     int value = future->thenApply([](int v) { return v * 7; })->get(); //42
+     */
+    template <typename T>
+    class CompletableFuture : extends AbstractCompletableFuture {
+    public:
+        CompletableFuture() {}
+        virtual ~CompletableFuture() {}
+
+        static Ref<CompletableFuture<T>> completedFuture(const T &value) {
+            Ref<CompletableFuture<T>> future = new_<CompletableFuture<T>>();
+            future->complete(value);
+            return future;
+        }
+
+        static Ref<CompletableFuture<T>> failedFuture(Ref<Exception> exception) {
+            Ref<CompletableFuture<T>> future = new_<CompletableFuture<T>>();
+            future->completeExceptionally(exception);
+            return future;
+        }
+
+        // 在executor中执行supplier, 并以其返回值完成返回的future
+        template <typename F>
+        static Ref<CompletableFuture<T>> supplyAsync(F supplier, Ref<Executor> executor) {
+            if (executor == nullptr) {
+                throw_new(NullPointerException, "executor cannot be nullptr");
+            }
+            class AsyncSupply : extends Object, implements Runnable {
+            public:
+                AsyncSupply(Ref<CompletableFuture<T>> dependent, const F &supplier) :
+                    dependent(dependent), supplier(supplier) {}
+                virtual void run() override {
+                    try_ {
+                        this->dependent->complete(_FutureCall<F>::invoke(this->supplier));
+                    } catch_(Exception, ex) {
+                        this->dependent->completeExceptionally(ex);
+                    } end_try
+                }
+            private:
+                Ref<CompletableFuture<T>> dependent;
+                F supplier;
+                interface_refcount()
+            };
+            Ref<CompletableFuture<T>> dependent = new_<CompletableFuture<T>>();
+            executor->execute(new_<AsyncSupply>(dependent, supplier));
+            return dependent;
+        }
+
+        bool complete(const T &value) {
+            return this->completeWith(new ValueResult(value));
+        }
+
+        // 阻塞直到完成; 异常完成时抛出以原始异常为cause的ExecutionException
+        T get() {
+            this->await(-1);
+            return this->report();
+        }
+
+        // 超时则抛出TimeoutException
+        T get(time_t timeoutMillis) {
+            if (!this->await(System::currentTimeMillis() + timeoutMillis)) {
+                throw_new(TimeoutException, "The future is not completed within the timeout");
+            }
+            return this->report();
+        }
+
+        T getNow(const T &valueIfAbsent) {
+            if (!this->isDone()) {
+                return valueIfAbsent;
+            }
+            return this->report();
+        }
+
+        template <typename F>
+        Ref<CompletableFuture<_FutureValueOf<F, T>>> thenApply(F fn, Ref<Executor> executor = nullptr) {
+            typedef _FutureValueOf<F, T> U;
+            class Apply : extends UniCompletion<U> {
+            public:
+                Apply(Ref<CompletableFuture<U>> dependent, Ref<Executor> executor, const F &fn) :
+                    UniCompletion<U>(dependent, executor), fn(fn) {}
+            protected:
+                virtual void apply(Result *result) override {
+                    if (result->exception != nullptr) {
+                        this->dependent->completeExceptionally(result->exception);
+                    } else {
+                        this->dependent->complete(
+                                _FutureCall<F, T>::invoke(this->fn, static_cast<ValueResult*>(result)->value)
+                        );
+                    }
+                }
+            private:
+                F fn;
+            };
+            Ref<CompletableFuture<U>> dependent = new_<CompletableFuture<U>>();
+            this->push(new_<Apply>(dependent, executor, fn).get());
+            return dependent;
+        }
+
+        // fn返回另外一个Ref<CompletableFuture<U>>, 返回的future跟随它完成
+        template <typename F>
+        Ref<CompletableFuture<typename _ComposedFutureValue<typename decay<decltype(declval<F&>()(declval<T&>()))>::type>::Type>>
+        thenCompose(F fn, Ref<Executor> executor = nullptr) {
+            typedef typename _ComposedFutureValue<typename decay<decltype(declval<F&>()(declval<T&>()))>::type>::Type U;
+            class Compose : extends UniCompletion<U> {
+            public:
+                Compose(Ref<CompletableFuture<U>> dependent, Ref<Executor> executor, const F &fn) :
+                    UniCompletion<U>(dependent, executor), fn(fn) {}
+            protected:
+                virtual void apply(Result *result) override {
+                    if (result->exception != nullptr) {
+                        this->dependent->completeExceptionally(result->exception);
+                        return;
+                    }
+                    Ref<CompletableFuture<U>> next = this->fn(static_cast<ValueResult*>(result)->value);
+                    if (next == nullptr) {
+                        throw_new(NullPointerException, "thenCompose function returned nullptr");
+                    }
+                    next->relayTo(this->dependent);
+                }
+            private:
+                F fn;
+            };
+            Ref<CompletableFuture<U>> dependent = new_<CompletableFuture<U>>();
+            this->push(new_<Compose>(dependent, executor, fn).get());
+            return dependent;
+        }
+
+        // 两者都完成后执行fn(当前结果, other的结果); 任何一方异常完成, 返回的future立即以该异常完成
+        template <typename U, typename F>
+        Ref<CompletableFuture<_FutureValueOf<F, T, U>>> thenCombine(
+                Ref<CompletableFuture<U>> other,
+                F fn,
+                Ref<Executor> executor = nullptr) {
+            typedef _FutureValueOf<F, T, U> V;
+            if (other == nullptr) {
+                throw_new(NullPointerException, "other cannot be nullptr");
+            }
+            class Combine : extends Object, implements Runnable {
+            public:
+                Combine(Ref<CompletableFuture<V>> dependent, Ref<Executor> executor, const F &fn) :
+                    dependent(dependent), executor(executor), fn(fn), pending(2) {
+                    for (int i = 0; i < 2; i++) {
+                        this->subscriptions[i].subscriber = this;
+                        this->subscriptions[i].index = i;
+                    }
+                }
+                void onComplete(AbstractCompletableFuture *source, int index) {
+                    Ref<Exception> exception = nullptr;
+                    if (index == 0) {
+                        this->first = static_cast<CompletableFuture<T>*>(source);
+                        exception = this->first->getException();
+                    } else {
+                        this->second = static_cast<CompletableFuture<U>*>(source);
+                        exception = this->second->getException();
+                    }
+                    if (exception != nullptr) {
+                        this->dependent->completeExceptionally(exception);
+                    }
+                    if (--this->pending == 0 && !this->dependent->isDone()) {
+                        Ref<Executor> executor = this->executor;
+                        this->executor = nullptr;
+                        if (executor != nullptr) {
+                            try_ {
+                                executor->execute(this);
+                            } catch_(Exception, ex) {
+                                this->dependent->completeExceptionally(ex);
+                            } end_try
+                        } else {
+                            this->run();
+                        }
+                    }
+                }
+                virtual void run() override {
+                    try_ {
+                        this->dependent->complete(
+                                _FutureCall<F, T, U>::invoke(
+                                        this->fn,
+                                        static_cast<ValueResult*>(this->first->result())->value,
+                                        static_cast<typename CompletableFuture<U>::ValueResult*>(this->second->result())->value
+                                )
+                        );
+                    } catch_(Exception, ex) {
+                        this->dependent->completeExceptionally(ex);
+                    } end_try
+                }
+                Subscription<Combine> subscriptions[2];
+            private:
+                Ref<CompletableFuture<V>> dependent;
+                Ref<Executor> executor;
+                F fn;
+                AtomicInteger pending;
+                Ref<CompletableFuture<T>> first;
+                Ref<CompletableFuture<U>> second;
+                interface_refcount()
+            };
+            Ref<CompletableFuture<V>> dependent = new_<CompletableFuture<V>>();
+            Ref<Combine> combine = new_<Combine>(dependent, executor, fn);
+            this->push(&combine->subscriptions[0]);
+            other->push(&combine->subscriptions[1]);
+            return dependent;
+        }
+
+        // 异常完成时以fn(异常)的返回值完成返回的future, 否则原样传递结果
+        template <typename F>
+        Ref<CompletableFuture<T>> exceptionally(F fn, Ref<Executor> executor = nullptr) {
+            class Recover : extends UniCompletion<T> {
+            public:
+                Recover(Ref<CompletableFuture<T>> dependent, Ref<Executor> executor, const F &fn) :
+                    UniCompletion<T>(dependent, executor), fn(fn) {}
+            protected:
+                virtual void apply(Result *result) override {
+                    if (result->exception != nullptr) {
+                        Ref<Exception> exception = result->exception;
+                        this->dependent->complete(this->fn(exception));
+                    } else {
+                        this->dependent->complete(static_cast<ValueResult*>(result)->value);
+                    }
+                }
+            private:
+                F fn;
+            };
+            Ref<CompletableFuture<T>> dependent = new_<CompletableFuture<T>>();
+            this->push(new_<Recover>(dependent, executor, fn).get());
+            return dependent;
+        }
+
+        // 以最先完成的那个future的结果(包括异常)完成返回的future
+        static Ref<CompletableFuture<T>> anyOf(const vector<Ref<CompletableFuture<T>>> &futures) {
+            class AnyOf : extends Object {
+            public:
+                AnyOf(Ref<CompletableFuture<T>> dependent, int count) :
+                    dependent(dependent), subscriptions(count) {
+                    for (int i = 0; i < count; i++) {
+                        this->subscriptions[i].subscriber = this;
+                    }
+                }
+                void onComplete(AbstractCompletableFuture *source, int) {
+                    static_cast<CompletableFuture<T>*>(source)->relayTo(this->dependent, false);
+                }
+                Ref<CompletableFuture<T>> dependent;
+                vector<Subscription<AnyOf>> subscriptions;
+            };
+            Ref<CompletableFuture<T>> dependent = new_<CompletableFuture<T>>();
+            Ref<AnyOf> anyOf = new_<AnyOf>(dependent, (int)futures.size());
+            for (size_t i = 0; i < futures.size(); i++) {
+                futures[i]->push(&anyOf->subscriptions[i]);
+            }
+            return dependent;
+        }
+
+    private:
+        struct ValueResult : Result {
+            ValueResult(const T &value) : Result(nullptr), value(value) {}
+            T value;
+        };
+
+        /*
+         * 依赖单个future的后续操作, 自身就是Runnable, 因此提交给executor时无需额外分配
+         */
+        template <typename U>
+        abstract class UniCompletion : extends Object, implements Runnable, public Completion {
+        public:
+            UniCompletion(Ref<CompletableFuture<U>> dependent, Ref<Executor> executor) :
+                dependent(dependent), executor(executor) {}
+            virtual Object *owner() override {
+                return this;
+            }
+            virtual void fire(AbstractCompletableFuture *source) override {
+                this->source = static_cast<CompletableFuture<T>*>(source);
+                Ref<Executor> executor = this->executor;
+                this->executor = nullptr;
+                if (executor != nullptr) {
+                    // executor拒绝任务时以该异常完成dependent, 不能让异常中断completeWith中其余后续操作的触发
+                    try_ {
+                        executor->execute(this);
+                    } catch_(Exception, ex) {
+                        this->dependent->completeExceptionally(ex);
+                    } end_try
+                } else {
+                    this->run();
+                }
+            }
+            virtual void run() override {
+                try_ {
+                    this->apply(this->source->result());
+                } catch_(Exception, ex) {
+                    this->dependent->completeExceptionally(ex);
+                } end_try
+            }
+        protected:
+            virtual void apply(Result *result) = 0;
+            Ref<CompletableFuture<T>> source;
+            Ref<CompletableFuture<U>> dependent;
+            Ref<Executor> executor;
+            interface_refcount()
+        };
+
+        // 当前future完成后, 把结果原样传递给dependent
+        void relayTo(Ref<CompletableFuture<T>> dependent, bool subscribe = true) {
+            class Relay : extends Object, public Completion {
+            public:
+                Relay(Ref<CompletableFuture<T>> dependent) : dependent(dependent) {}
+                virtual Object *owner() override {
+                    return this;
+                }
+                virtual void fire(AbstractCompletableFuture *source) override {
+                    static_cast<CompletableFuture<T>*>(source)->relayTo(this->dependent, false);
+                }
+            private:
+                Ref<CompletableFuture<T>> dependent;
+            };
+            if (subscribe) {
+                this->push(new_<Relay>(dependent).get());
+                return;
+            }
+            Result *result = this->result();
+            if (result->exception != nullptr) {
+                dependent->completeExceptionally(result->exception);
+            } else {
+                dependent->complete(static_cast<ValueResult*>(result)->value);
+            }
+        }
+
+        T report() {
+            Result *result = this->result();
+            if (result->exception != nullptr) {
+                throw_new(ExecutionException, result->exception->getMessage(), result->exception);
+            }
+            return static_cast<ValueResult*>(result)->value;
+        }
+
+        template <typename> friend class CompletableFuture;
+        friend class AbstractCompletableFuture;
+    };
+
+    inline Ref<CompletableFuture<bool>> AbstractCompletableFuture::allOf(const vector<Ref<AbstractCompletableFuture>> &futures) {
+        class AllOf : extends Object {
+        public:
+            AllOf(Ref<CompletableFuture<bool>> dependent, int count) :
+                dependent(dependent), subscriptions(count), pending(count) {
+                for (int i = 0; i < count; i++) {
+                    this->subscriptions[i].subscriber = this;
+                }
+            }
+            void onComplete(AbstractCompletableFuture *source, int) {
+                Ref<Exception> exception = source->getException();
+                if (exception != nullptr) {
+                    this->dependent->completeExceptionally(exception);
+                } else if (--this->pending == 0) {
+                    this->dependent->complete(true);
+                }
+            }
+            Ref<CompletableFuture<bool>> dependent;
+            vector<Subscription<AllOf>> subscriptions;
+        private:
+            AtomicInteger pending;
+        };
+        Ref<CompletableFuture<bool>> dependent = new_<CompletableFuture<bool>>();
+        if (futures.empty()) {
+            dependent->complete(true);
+            return dependent;
+        }
+        Ref<AllOf> allOf = new_<AllOf>(dependent, (int)futures.size());
+        for (size_t i = 0; i < futures.size(); i++) {
+            futures[i]->push(&allOf->subscriptions[i]);
+        }
+        return dependent;
+    }
+}
@@ -0,0 +1,252 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+/**
+ * C++20协程支持, 本框架的其余部分仍然只要求C++11
+ *
+ * 1、Task<T>: 惰性启动的协程, 可以在另一个协程中co_await它, 也可以用start()启动它并得到CompletableFuture
+ * 2、co_await Ref<CompletableFuture<T>>: 挂起当前协程直到future完成, 异常完成时与get()一样抛出ExecutionException;
+ *    而co_await另一个Task时, 被调协程抛出的异常会原样(保持原始类型)抛给调用者
+ * 3、co_await executorService->schedule(): 切换到线程池中继续执行
+ * 4、co_await scheduledExecutorService->delay(millis): 挂起指定时间, 期间不占用任何线程
+ * 5、co_await queue->takeAsync(), co_await call->executeAsync(), co_await statement->executeQueryAsync(executor)
+ *
+ * 协程在挂起期间不占用线程, 所以成千上万个进行中的操作只需少数几个线程即可驱动
+ *
+ *     Task<int> answer(Ref<ExecutorService> executorService) {
+ *         co_await executorService->schedule();
+ *         int value = co_await executorService->submit(Supplier<int>::of([] { return 6; }));
+ *         co_return value * 7;
+ *     }
+ *     int value = answer(executorService).start()->get();
+ *
+ * @author 陈涛
+ */
+
+#if !defined(__cpp_impl_coroutine)
+#error "Coroutine.h requires C++20 coroutine support, please compile with -std=c++20"
+#endif
+
+#include "CompletableFuture.h"
+#include <coroutine>
+#include <optional>
+#include <exception>
+
+namespace com_lanjing_cpp_common {
+
+    using namespace std;
+
+    template <typename T = void> class Task;
+
+    // promise中与结果类型无关的部分
+    struct _TaskPromiseBase {
+        struct FinalAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+            // 对称转移到等待者, 避免恢复链过长时栈溢出
+            template <typename P>
+            coroutine_handle<> await_suspend(coroutine_handle<P> handle) noexcept {
+                coroutine_handle<> continuation = handle.promise().continuation;
+                return continuation ? continuation : noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        FinalAwaiter final_suspend() noexcept {
+            return {};
+        }
+        /*
+         * 保存exception_ptr以便原样重新抛出(保持原始类型); 若抛出的是框架异常, 还需持有它的引用,
+         * 因为每次被catch_捕获都会释放一次引用, 所以每次重新抛出前都要先retain
+         */
+        void unhandled_exception() {
+            this->exceptionPtr = current_exception();
+            // 判断当前异常类型只能使用原生的throw
+            try {
+                throw;
+            } catch (Exception *ex) {
+                this->exception = ex;
+                ex->release();
+            } catch (...) {
+            }
+        }
+        void rethrowIfNecessary() {
+            if (this->exceptionPtr) {
+                if (this->exception != nullptr) {
+                    this->exception->retain();
+                }
+                rethrow_exception(this->exceptionPtr);
+            }
+        }
+        coroutine_handle<> continuation;
+        Ref<Exception> exception;
+        exception_ptr exceptionPtr;
+    };
+
+    template <typename T>
+    struct _TaskPromise : _TaskPromiseBase {
+        Task<T> get_return_object();
+        template <typename V>
+        void return_value(V &&value) {
+            this->value.emplace(forward<V>(value));
+        }
+        T result() {
+            this->rethrowIfNecessary();
+            return move(*this->value);
+        }
+        optional<T> value;
+    };
+
+    template <>
+    struct _TaskPromise<void> : _TaskPromiseBase {
+        Task<void> get_return_object();
+        void return_void() {}
+        void result() {
+            this->rethrowIfNecessary();
+        }
+    };
+
+    // 启动后不再被任何人等待的协程, 结束时自动销毁
+    struct _DetachedCoroutine {
+        struct promise_type {
+            _DetachedCoroutine get_return_object() noexcept {
+                return {};
+            }
+            suspend_never initial_suspend() noexcept {
+                return {};
+            }
+            suspend_never final_suspend() noexcept {
+                return {};
+            }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept {
+                terminate();
+            }
+        };
+    };
+
+    /**
+     * 协程的返回类型, 值类型, 只能移动
+     *
+     * 协程体在第一次被co_await(或start)时才开始执行; 结束时直接恢复等待它的协程
+     */
+    template <typename T>
+    class Task {
+    public:
+        typedef _TaskPromise<T> promise_type;
+
+        Task(Task<T> &&right) noexcept : handle(right.handle) {
+            right.handle = nullptr;
+        }
+        Task<T> &operator = (Task<T> &&right) noexcept {
+            if (this != &right) {
+                if (this->handle) {
+                    this->handle.destroy();
+                }
+                this->handle = right.handle;
+                right.handle = nullptr;
+            }
+            return *this;
+        }
+        ~Task() {
+            if (this->handle) {
+                this->handle.destroy();
+            }
+        }
+        Task(const Task<T> &) = delete;
+        Task<T> &operator = (const Task<T> &) = delete;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+        coroutine_handle<> await_suspend(coroutine_handle<> awaiting) noexcept {
+            this->handle.promise().continuation = awaiting;
+            return this->handle;
+        }
+        T await_resume() {
+            return this->handle.promise().result();
+        }
+
+        /*
+         * 启动任务并返回在任务结束时完成的future, 供非协程代码使用. 调用后当前Task对象不再可用;
+         * Task<void>对应CompletableFuture<bool>
+         */
+        Ref<CompletableFuture<typename _FutureValue<T>::Type>> start() {
+            Ref<CompletableFuture<typename _FutureValue<T>::Type>> future =
+                    new_<CompletableFuture<typename _FutureValue<T>::Type>>();
+            drive(move(*this), future);
+            return future;
+        }
+
+    private:
+        explicit Task(coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        static _DetachedCoroutine drive(Task<T> task, Ref<CompletableFuture<typename _FutureValue<T>::Type>> future) {
+            try_ {
+                if constexpr (is_void<T>::value) {
+                    co_await task;
+                    future->complete(true);
+                } else {
+                    future->complete(co_await task);
+                }
+            } catch_(Exception, ex) {
+                future->completeExceptionally(ex);
+            } end_try
+        }
+
+        coroutine_handle<promise_type> handle;
+
+        friend struct _TaskPromise<T>;
+    };
+
+    template <typename T>
+    inline Task<T> _TaskPromise<T>::get_return_object() {
+        return Task<T>(coroutine_handle<_TaskPromise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> _TaskPromise<void>::get_return_object() {
+        return Task<void>(coroutine_handle<_TaskPromise<void>>::from_promise(*this));
+    }
+
+    template <typename T>
+    struct _FutureAwaiter {
+        Ref<CompletableFuture<T>> future;
+        bool await_ready() const {
+            return this->future->isDone();
+        }
+        void await_suspend(coroutine_handle<> handle) {
+            class Resumer : extends Object, public AbstractCompletableFuture::Completion {
+            public:
+                Resumer(coroutine_handle<> handle) : handle(handle) {}
+                virtual Object *owner() override {
+                    return this;
+                }
+                virtual void fire(AbstractCompletableFuture *) override {
+                    this->handle.resume();
+                }
+            private:
+                coroutine_handle<> handle;
+            };
+            Ref<CompletableFuture<T>> future = this->future; //若已完成, push会就地恢复协程并可能销毁本对象
+            future->push(new_<Resumer>(handle).get());
+        }
+        T await_resume() {
+            return this->future->get();
+        }
+    };
+
+    // 协程在完成future的线程中恢复(对于后续操作而言即"就地执行")
+    template <typename T>
+    _FutureAwaiter<T> operator co_await(Ref<CompletableFuture<T>> future) {
+        return _FutureAwaiter<T> { future };
+    }
+}
@@ -0,0 +1,22 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Functional.h"
+
+namespace com_lanjing_cpp_common {
+
+    /**
+     * 对应java.util.concurrent.Executor, 任何能够执行Runnable的对象(线程池, 串行执行器等)都应实现此接口
+     */
+    interface Executor : implements Interface {
+    public:
+        virtual void execute(Ref<Runnable> runnable) = 0;
+        virtual ~Executor() {}
+    };
+}
@@ -10,29 +10,209 @@
 #include "Functional.h"
 #include "BlockingQueue.h"
 #include "Auxiliary.h"
+#include "CompletableFuture.h"
+#include "ThreadPlacement.h"
+#include "ExecutorStats.h"
+#include "TimingWheel.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sched.h>
 
 namespace com_lanjing_cpp_common {
 
-    class ExecutorService : extends Object {
+    // 工作线程获取任务的方式
+    enum class ExecutorMode {
+        SHARED_QUEUE, //所有工作线程共享一个阻塞队列(默认)
+        WORK_STEALING //每个工作线程拥有自己的队列, 空闲的线程从其他线程的队列中窃取任务, 支持按affinityKey串行化任务
+    };
+
+    interface ScheduledFuture : implements Interface {
+        virtual void cancel() = 0;
+    };
+
+    /*
+     * 所有构造函数的最后一个参数threadPlacement都是可选的, 用于设置工作线程的名称和CPU亲和性(参见ThreadPlacement.h),
+     * 每个工作线程在开始执行任务之前调用threadPlacement->applyToCurrentThread(线程序号)
+     */
+    class ExecutorService : extends Object, implements Executor {
     public:
-        ExecutorService(int threadCount = 1, bool giveupPendingTasksAfterShutdown = true) {
+        ExecutorService(
+                int threadCount = 1,
+                bool giveupPendingTasksAfterShutdown = true,
+                Ref<ThreadPlacement> threadPlacement = nullptr) {
+            if (threadCount < 1) {
+                throw_new(IllegalArgumentException, "threadCount cannot be less than 1");
+            }
+            this->sharedService = new_<SharedService>(
+                threadCount,
+                nullptr,
+                giveupPendingTasksAfterShutdown,
+                ExecutorMode::SHARED_QUEUE,
+                threadPlacement
+            );
+        }
+        /*
+         * mode为WORK_STEALING时, 每个工作线程拥有自己的任务队列: 工作线程提交的任务进入它自己的队列,
+         * 其他线程提交的任务轮流分配给各个工作线程, 空闲的工作线程从其他线程的队列中窃取任务
+         */
+        ExecutorService(
+                int threadCount,
+                ExecutorMode mode,
+                bool giveupPendingTasksAfterShutdown = true,
+                Ref<ThreadPlacement> threadPlacement = nullptr) {
+            if (threadCount < 1) {
+                throw_new(IllegalArgumentException, "threadCount cannot be less than 1");
+            }
+            this->sharedService = new_<SharedService>(
+                threadCount,
+                nullptr,
+                giveupPendingTasksAfterShutdown,
+                mode,
+                threadPlacement
+            );
+        }
+        // 使用指定的阻塞队列(例如ConcurrentArrayBlockingQueue<Runnable>)作为任务队列, Q必须实现BlockingQueue<Runnable>
+        template <typename Q>
+        ExecutorService(
+                int threadCount,
+                Ref<Q> runnableQueue,
+                bool giveupPendingTasksAfterShutdown = true,
+                Ref<ThreadPlacement> threadPlacement = nullptr) {
             if (threadCount < 1) {
                 throw_new(IllegalArgumentException, "threadCount cannot be less than 1");
             }
-            this->sharedService = new_<SharedService>(threadCount, giveupPendingTasksAfterShutdown);
+            if (runnableQueue == nullptr) {
+                throw_new(IllegalArgumentException, "runnableQueue cannot be null");
+            }
+            this->sharedService = new_<SharedService>(
+                threadCount,
+                runnableQueue,
+                giveupPendingTasksAfterShutdown,
+                ExecutorMode::SHARED_QUEUE,
+                threadPlacement
+            );
         }
         virtual ~ExecutorService() {
+            {
+                Mutex::Scope scope(this->statsDumpMutex);
+                for (Ref<ScheduledFuture> &statsDump : this->statsDumps) {
+                    statsDump->cancel();
+                }
+            }
             this->sharedService->shutdown();
         }
         bool isShutdown() const {
             return this->sharedService->isShutdown();
         }
-        void shutdown() {
+        virtual void shutdown() {
             this->sharedService->shutdown();
         }
-        void execute(Ref<Runnable> runnable) {
+        int getPoolSize() const {
+            return this->sharedService->getPoolSize();
+        }
+        /*
+         * 工作线程每次从任务队列中最多取出taskBatchSize个任务(默认为1), 然后依次执行.
+         * 大量短小任务时, 批量出队能把队列的加锁和唤醒分摊到整批任务上; 但同一批中靠后的任务必须等待前面的任务执行完毕,
+         * 即使其他工作线程空闲也不会被其窃取, 故任务耗时较长或差异较大时请保持默认值1
+         */
+        void setTaskBatchSize(int taskBatchSize) {
+            if (taskBatchSize < 1) {
+                throw_new(IllegalArgumentException, "taskBatchSize cannot be less than 1");
+            }
+            this->sharedService->setTaskBatchSize(taskBatchSize);
+        }
+        int getTaskBatchSize() const {
+            return this->sharedService->getTaskBatchSize();
+        }
+        virtual void execute(Ref<Runnable> runnable) override {
             this->sharedService->execute(runnable);
         }
+        /*
+         * affinityKey相同的任务总是由同一个工作线程按提交顺序执行, 且不会被其他线程窃取,
+         * 所以它们彼此串行, 无需加锁就可以访问同一份数据(例如同一个连接或会话), 并且这些数据在该线程的缓存中是热的.
+         * 仅WORK_STEALING模式支持
+         */
+        template <typename K>
+        void execute(Ref<Runnable> runnable, const K &affinityKey) {
+            this->sharedService->execute(runnable, hash<K>()(affinityKey));
+        }
+        ExecutorMode getMode() const {
+            return this->sharedService->getMode();
+        }
+        // 提交, 完成和失败的任务数, 队列长度, 活动线程数以及排队时间和执行时间的直方图
+        Ref<ExecutorStats> getStats() const {
+            return this->sharedService->getStats();
+        }
+        /*
+         * 排队时间和执行时间的采样间隔: 0表示不采样(默认), n表示每个提交线程每提交n个任务采样一个.
+         * 采样的任务需要额外分配一个包装对象并读取两次时钟, 计数器则总是开启
+         */
+        void setSamplingInterval(int samplingInterval) {
+            this->sharedService->getMetrics()->setSamplingInterval(samplingInterval);
+        }
+        int getSamplingInterval() const {
+            return this->sharedService->getMetrics()->getSamplingInterval();
+        }
+        // 任务抛出的异常总会被计数并记录为lastFailure, 然后交给handler处理; 未设置handler时打印异常栈
+        void setUncaughtExceptionHandler(Ref<RefConsumer<Exception>> handler) {
+            this->sharedService->getMetrics()->setUncaughtExceptionHandler(handler);
+        }
+        /*
+         * 每隔periodMillis把getStats()的结果交给consumer(例如写入日志或监控系统).
+         * consumer在一个内部的调度线程中执行, 不占用本线程池; 返回值可用于取消, ExecutorService析构时自动取消
+         */
+        Ref<ScheduledFuture> dumpStatsAtFixedRate(Ref<RefConsumer<ExecutorStats>> consumer, time_t periodMillis);
+        // 关闭之后提交的任务会被丢弃, 此时返回的future以IllegalStateException完成, 而不是永远不完成
+        template <typename T>
+        Ref<CompletableFuture<T>> submit(Ref<Supplier<T>> supplier) {
+            Ref<CompletableFuture<T>> future = new_<CompletableFuture<T>>();
+            bool accepted = this->sharedService->execute(Runnable::of([future, supplier] {
+                try_ {
+                    future->complete(supplier());
+                } catch_(Exception, ex) {
+                    future->completeExceptionally(ex);
+                } end_try
+            }));
+            if (!accepted) {
+                future->completeExceptionally(new_<IllegalStateException>(__FILE__, __LINE__, "The ExecutorService has been shut down"));
+            }
+            return future;
+        }
+
+        /*
+         * 供C++20协程使用: co_await executorService->schedule()把当前协程切换到线程池中继续执行(参见Coroutine.h).
+         * await_suspend是模板, 所以本头文件仍然可以按C++11编译.
+         * 线程池已关闭时恢复任务会被丢弃, 所以此时不挂起, 而是由co_await抛出IllegalStateException
+         */
+        struct ScheduleAwaiter {
+            ScheduleAwaiter(Ref<ExecutorService> executorService) : executorService(executorService), rejected(false) {}
+            bool await_ready() const {
+                return false;
+            }
+            template <typename H>
+            bool await_suspend(H handle) {
+                Ref<ExecutorService> executorService = this->executorService; //协程可能在execute返回之前就已在其他线程中恢复并销毁本对象
+                if (!executorService->sharedService->execute(Runnable::of([handle] {
+                    handle.resume();
+                }))) {
+                    this->rejected = true; //任务未被接受, 协程不会在其他线程中恢复, 本对象仍然有效
+                    return false;
+                }
+                return true;
+            }
+            void await_resume() const {
+                if (this->rejected) {
+                    throw_new(IllegalStateException, "The ExecutorService has been shut down");
+                }
+            }
+        private:
+            Ref<ExecutorService> executorService;
+            bool rejected;
+        };
+        ScheduleAwaiter schedule() {
+            return ScheduleAwaiter(this);
+        }
 #ifdef DEBUG
         static int threadCount();
 #endif //DEBUG
@@ -43,11 +223,64 @@ namespace com_lanjing_cpp_common {
          * 但是,外部的ExecutorService包装类却不同, 它被不被线程池线程所共享，用户线程的release操作很容易引起析构被执行,
          * 从而间接导致SharedService的shutdown被执行。这种内外两层设计非常重要！
          */
+        class SharedService;
+
+        struct Worker {
+            Worker(SharedService *service, int index, ExecutorMode mode) : service(service), index(index) {
+                if (mode == ExecutorMode::WORK_STEALING) {
+                    this->localQueue = new_<LinkedBlockingQueue<Runnable>>();
+                    this->pinnedQueue = new_<LinkedBlockingQueue<Runnable>>();
+                }
+                this->seed = 0x9E3779B9u ^ (unsigned)(uintptr_t)this;
+            }
+            // 不等待地取出一个任务, 队列为空时返回nullptr
+            Ref<Runnable> pollNow(const Ref<LinkedBlockingQueue<Runnable>> &queue) {
+                if (queue->size() == 0 || queue->drainTo(this->buffer, 1) == 0) {
+                    return nullptr;
+                }
+                Ref<Runnable> runnable = this->buffer[0];
+                this->buffer.clear();
+                return runnable;
+            }
+            // xorshift, 用于随机选择窃取对象
+            unsigned nextRandom() {
+                this->seed ^= this->seed << 13;
+                this->seed ^= this->seed >> 17;
+                this->seed ^= this->seed << 5;
+                return this->seed;
+            }
+            SharedService *service;
+            int index;
+            Ref<LinkedBlockingQueue<Runnable>> localQueue; //可被其他线程窃取
+            Ref<LinkedBlockingQueue<Runnable>> pinnedQueue; //按affinityKey分配的任务, 只由本线程执行
+            EventCount signal;
+            // 以下统计只由本线程写入, 不需要原子的读-改-写
+            atomic<bool> active { false };
+            atomic<int64_t> completedTaskCount { 0 };
+            atomic<int64_t> failedTaskCount { 0 };
+            vector<Ref<Runnable>> buffer;
+            unsigned seed;
+        };
+
         class SharedService : extends Object {
         public:
-            SharedService(int threadCount, bool giveupPendingTasksAfterShutdown) {
+            SharedService(
+                    int threadCount,
+                    Ref<BlockingQueue<Runnable>> runnableQueue,
+                    bool giveupPendingTasksAfterShutdown,
+                    ExecutorMode mode,
+                    Ref<ThreadPlacement> threadPlacement) : mode(mode), threadPlacement(threadPlacement) {
                 this->giveupPendingTasksAfterShutdown = giveupPendingTasksAfterShutdown;
-                this->runnableQueue = new_<LinkedBlockingQueue<Runnable>>();
+                this->metrics = new_<ExecutorMetrics>();
+                if (mode == ExecutorMode::SHARED_QUEUE) {
+                    this->runnableQueue = runnableQueue;
+                    if (this->runnableQueue == nullptr) {
+                        this->runnableQueue = new_<LinkedBlockingQueue<Runnable>>();
+                    }
+                }
+                for (int i = 0; i < threadCount; i++) {
+                    this->workers.emplace_back(new Worker(this, i, mode));
+                }
                 this->semaphore = new_<Semaphore>();
                 this->threads = Array<pthread_t>::newInstance(
                         threadCount,
@@ -59,7 +292,7 @@ namespace com_lanjing_cpp_common {
                             &this->threads[i],
                             nullptr,
                             threadProc,
-                            this
+                            this->workers[i].get()
                     );
                     if (error != 0) {
                         this->release();
@@ -73,23 +306,92 @@ namespace com_lanjing_cpp_common {
 
             virtual ~SharedService() {}
 
-            void execute(Ref<Runnable> runnable) {
-                if (!this->closed) {
+            // 关闭之后丢弃任务并返回false
+            bool execute(Ref<Runnable> runnable) {
+                if (this->closed) {
+                    return false;
+                }
+                runnable = this->metrics->onSubmit(runnable);
+                if (this->mode == ExecutorMode::SHARED_QUEUE) {
                     this->runnableQueue->put(runnable);
+                    return true;
+                }
+                Worker *worker = currentWorker();
+                if (worker == nullptr || worker->service != this) {
+                    worker = this->workers[this->nextWorkerIndex.fetch_add(1, memory_order_relaxed) % this->workers.size()].get();
                 }
+                worker->localQueue->put(runnable);
+                this->signalWork(worker);
+                return true;
+            }
+
+            void execute(Ref<Runnable> runnable, size_t affinityHash) {
+                if (this->mode != ExecutorMode::WORK_STEALING) {
+                    throw_new(UnsupportedOperationException, "affinityKey requires ExecutorMode::WORK_STEALING");
+                }
+                if (this->closed) {
+                    return;
+                }
+                runnable = this->metrics->onSubmit(runnable);
+                Worker *worker = this->workers[affinityHash % this->workers.size()].get();
+                worker->pinnedQueue->put(runnable);
+                worker->signal.notify();
+            }
+
+            ExecutorMode getMode() const {
+                return this->mode;
             }
 
             bool isShutdown() const {
                 return this->closed;
             }
 
+            int getPoolSize() const {
+                return this->threads.length();
+            }
+
+            void setTaskBatchSize(int taskBatchSize) {
+                this->taskBatchSize.store(taskBatchSize);
+            }
+
+            int getTaskBatchSize() const {
+                return this->taskBatchSize.load();
+            }
+
             void shutdown() {
                 this->shutdown(this->threads.length());
             }
 
+            const Ref<ExecutorMetrics> &getMetrics() const {
+                return this->metrics;
+            }
+
+            Ref<ExecutorStats> getStats() const {
+                int activeCount = 0;
+                int64_t queueSize = 0, completedTaskCount = 0, failedTaskCount = 0;
+                for (const unique_ptr<Worker> &worker : this->workers) {
+                    activeCount += worker->active.load(memory_order_relaxed) ? 1 : 0;
+                    completedTaskCount += worker->completedTaskCount.load(memory_order_relaxed);
+                    failedTaskCount += worker->failedTaskCount.load(memory_order_relaxed);
+                    if (this->mode == ExecutorMode::WORK_STEALING) {
+                        queueSize += worker->localQueue->size() + worker->pinnedQueue->size();
+                    }
+                }
+                if (this->mode == ExecutorMode::SHARED_QUEUE) {
+                    queueSize = this->runnableQueue->size();
+                }
+                return this->metrics->snapshot(
+                    this->threads.length(),
+                    activeCount,
+                    queueSize,
+                    completedTaskCount,
+                    failedTaskCount
+                );
+            }
+
 #ifdef DEBUG
-            static AtomicInteger &threadCount() {
-                static AtomicInteger instance;
+            static LongAdder &threadCount() {
+                static LongAdder instance;
                 return instance;
             }
 #endif //DEBUG
@@ -97,53 +399,237 @@ namespace com_lanjing_cpp_common {
         private:
             void shutdown(int count) {
                 if (this->closed.compareAndSet(false, true)) {
-                    for (int i = count; i > 0; --i) {
-                        this->runnableQueue->put(nilRunnable());
+                    // 任务(例如CompletableFuture的后续操作)可能在线程池线程中释放掉ExecutorService的最后一个引用,
+                    // 此时当前线程只能在任务结束后才退出, 不能等待自己
+                    pthread_t self = pthread_self();
+                    int selfIndex = -1;
+                    for (int i = 0; i < count; i++) {
+                        if (pthread_equal(this->threads[i], self)) {
+                            selfIndex = i;
+                            break;
+                        }
+                    }
+                    int pendingThreadCount = selfIndex == -1 ? count : count - 1;
+                    if (this->mode == ExecutorMode::SHARED_QUEUE) {
+                        pendingThreadCount = this->postExitMarkers(count, pendingThreadCount);
+                    } else {
+                        for (int i = 0; i < count; i++) {
+                            this->workers[i]->signal.notifyAll();
+                        }
+                    }
+                    this->semaphore->acquire(pendingThreadCount);
+                    // 信号量只说明任务已结束, 等线程真正退出(释放完对SharedService的引用)后再返回
+                    for (int i = 0; i < count; i++) {
+                        if (i == selfIndex) {
+                            pthread_detach(self);
+                        } else {
+                            pthread_join(this->threads[i], nullptr);
+                        }
+                    }
+                }
+            }
+
+            /*
+             * 为每个工作线程放入一个退出标记. 有界队列可能已满, 而关闭后的工作线程不一定还会出队,
+             * 所以不能用阻塞的put: 放弃未执行的任务时先清空队列, 否则等待工作线程腾出空间或退出.
+             * 返回仍需通过信号量等待的线程数
+             */
+            int postExitMarkers(int markerCount, int pendingThreadCount) {
+                vector<Ref<Runnable>> discarded;
+                while (pendingThreadCount > 0) {
+                    if (this->giveupPendingTasksAfterShutdown) {
+                        this->runnableQueue->drainTo(discarded);
+                        discarded.clear();
+                    }
+                    while (markerCount > 0 && this->runnableQueue->offer(nilRunnable(), 0)) {
+                        markerCount--;
+                    }
+                    if (markerCount == 0) {
+                        break;
+                    }
+                    if (this->semaphore->tryAcquire(1, EXIT_MARKER_RETRY_MILLIS)) {
+                        pendingThreadCount--;
                     }
-                    this->semaphore->acquire(count);
                 }
+                return pendingThreadCount;
             }
 
             static void *threadProc(void *data) {
 #ifdef DEBUG
-                ++threadCount();
+                threadCount().increment();
 #endif //DEBUG
-                SharedService *service =
-                        reinterpret_cast<SharedService*>(data);
+                Worker *worker = reinterpret_cast<Worker*>(data);
+                SharedService *service = worker->service;
                 defer([=]() {
+                    currentWorker() = nullptr;
                     service->semaphore->signal();
                     service->release();
 #ifdef DEBUG
-                    --threadCount();
+                    threadCount().decrement();
 #endif //DEBUG
                 });
-                service->threadRun();
+                currentWorker() = worker;
+                if (service->threadPlacement != nullptr) {
+                    service->threadPlacement->applyToCurrentThread(worker->index);
+                }
+                if (service->mode == ExecutorMode::SHARED_QUEUE) {
+                    service->threadRun();
+                } else {
+                    service->threadRun(worker);
+                }
                 return nullptr;
             }
 
             void threadRun() {
+                Worker *worker = currentWorker();
+                vector<Ref<Runnable>> batch;
                 while (!this->closed || !this->giveupPendingTasksAfterShutdown) {
-                    try_ {
-                        Ref<Runnable> runnable = this->runnableQueue->take();
-                        if (runnable == nilRunnable()) {
+                    int batchSize = this->taskBatchSize.load(memory_order_relaxed);
+                    if (batchSize > 1) {
+                        if (!this->runBatch(worker, batch, batchSize)) {
                             return;
                         }
-                        runnable();
-                    } catch_(Exception, ex) {
-                        ex->printStackTrace();
-                    } end_try
+                        continue;
+                    }
+                    Ref<Runnable> runnable = this->runnableQueue->take();
+                    if (runnable == nilRunnable()) {
+                        return;
+                    }
+                    this->runTask(worker, runnable);
+                }
+            }
+
+            // 取出并执行一批任务, 遇到退出标记时返回false
+            bool runBatch(Worker *worker, vector<Ref<Runnable>> &batch, int batchSize) {
+                batch.clear();
+                this->runnableQueue->drainTo(batch, batchSize, -1);
+                for (size_t i = 0; i < batch.size(); i++) {
+                    if (batch[i] == nilRunnable() || (this->closed && this->giveupPendingTasksAfterShutdown)) {
+                        // 同一批中可能还有其他线程的退出标记, 必须把剩余部分放回队列
+                        size_t from = batch[i] == nilRunnable() ? i + 1 : i;
+                        vector<Ref<Runnable>> rest(batch.begin() + from, batch.end());
+                        batch.clear();
+                        this->runnableQueue->putAll(rest);
+                        return false;
+                    }
+                    this->runTask(worker, batch[i]);
+                    batch[i] = nullptr;
+                }
+                batch.clear();
+                return true;
+            }
+
+            // WORK_STEALING模式的工作线程
+            void threadRun(Worker *worker) {
+                unsigned idleCount = 0;
+                while (!this->closed || !this->giveupPendingTasksAfterShutdown) {
+                    Ref<Runnable> runnable = this->nextRunnable(worker);
+                    if (runnable == nullptr) {
+                        if (++idleCount < YIELD_COUNT) {
+                            sched_yield();
+                            continue;
+                        }
+                        // 先登记为空闲再重新检查, 与"先放入任务再检查空闲线程"的提交方构成Dekker式同步
+                        unsigned key = worker->signal.prepareWait();
+                        this->idleWorkerCount.fetch_add(1);
+                        bool closed = this->closed;
+                        runnable = this->nextRunnable(worker);
+                        if (runnable == nullptr && !closed) {
+                            worker->signal.wait(key);
+                            this->idleWorkerCount.fetch_sub(1);
+                            continue;
+                        }
+                        this->idleWorkerCount.fetch_sub(1);
+                        worker->signal.cancelWait();
+                        if (runnable == nullptr) {
+                            return; //已关闭且已无任务可做
+                        }
+                    }
+                    idleCount = 0;
+                    this->runTask(worker, runnable);
                 }
             }
 
+            // 执行一个任务并更新本线程的统计, 任务抛出的异常交给metrics记录
+            void runTask(Worker *worker, const Ref<Runnable> &runnable) {
+                worker->active.store(true, memory_order_relaxed);
+                try_ {
+                    runnable();
+                    worker->completedTaskCount.store(
+                        worker->completedTaskCount.load(memory_order_relaxed) + 1,
+                        memory_order_relaxed
+                    );
+                } catch_(Exception, ex) {
+                    worker->failedTaskCount.store(
+                        worker->failedTaskCount.load(memory_order_relaxed) + 1,
+                        memory_order_relaxed
+                    );
+                    this->metrics->onFailure(ex);
+                } end_try
+                worker->active.store(false, memory_order_relaxed);
+            }
+
+            // 依次检查本线程的亲和队列和本地队列, 然后从随机选择的线程开始窃取
+            Ref<Runnable> nextRunnable(Worker *worker) {
+                Ref<Runnable> runnable = worker->pollNow(worker->pinnedQueue);
+                if (runnable == nullptr) {
+                    runnable = worker->pollNow(worker->localQueue);
+                }
+                if (runnable == nullptr) {
+                    size_t count = this->workers.size();
+                    size_t start = worker->nextRandom() % count;
+                    for (size_t i = 0; i < count && runnable == nullptr; i++) {
+                        Worker *victim = this->workers[(start + i) % count].get();
+                        if (victim != worker) {
+                            runnable = worker->pollNow(victim->localQueue);
+                        }
+                    }
+                }
+                return runnable;
+            }
+
+            // 任务已放入target的本地队列: target空闲时唤醒它, 否则唤醒任意一个空闲线程来窃取
+            void signalWork(Worker *target) {
+                atomic_thread_fence(memory_order_seq_cst);
+                if (target->signal.hasWaiters()) {
+                    target->signal.notify();
+                } else if (this->idleWorkerCount.load() > 0) {
+                    for (unique_ptr<Worker> &worker : this->workers) {
+                        if (worker->signal.hasWaiters()) {
+                            worker->signal.notify();
+                            break;
+                        }
+                    }
+                }
+            }
+
+            static Worker *&currentWorker() {
+                static thread_local Worker *worker = nullptr;
+                return worker;
+            }
+
         private:
+            static const unsigned YIELD_COUNT = 16;
+            static const time_t EXIT_MARKER_RETRY_MILLIS = 10;
+
+            const ExecutorMode mode;
+            Ref<ThreadPlacement> threadPlacement;
+            Ref<ExecutorMetrics> metrics;
             bool giveupPendingTasksAfterShutdown;
             AtomicBoolean closed;
+            atomic<int> taskBatchSize { 1 };
             Ref<Semaphore> semaphore;
             Arr<pthread_t> threads;
-            Ref<BlockingQueue<Runnable>> runnableQueue;
+            Ref<BlockingQueue<Runnable>> runnableQueue; //仅用于SHARED_QUEUE模式
+            vector<unique_ptr<Worker>> workers;
+            atomic<unsigned> nextWorkerIndex { 0 };
+            atomic<int> idleWorkerCount { 0 };
         };
     private:
         Ref<SharedService> sharedService;
+        Mutex statsDumpMutex;
+        vector<Ref<ScheduledFuture>> statsDumps;
+        interface_refcount()
 
         // 在iOS系统中,pthread_cancel只能保证pthread_cleanup的执行, 无法保证线程栈上C++对象的析构的执行
         // 故,不使用pthread_cancel退出线程,而使用此特殊任务保证执行线程退出
@@ -155,216 +641,481 @@ namespace com_lanjing_cpp_common {
 
 #ifdef DEBUG
     inline int ExecutorService::threadCount() {
-        return SharedService::threadCount();
+        return (int)SharedService::threadCount().sum();
     }
 #endif //DEBUG
 
-    interface ScheduledFuture : implements Interface {
-        virtual void cancel() = 0;
+    // 固定频率的任务因执行过慢或线程池繁忙而错过了若干个周期时的处理方式
+    enum class CatchUpPolicy {
+        BURST, //连续执行以补上错过的周期(和Java相同)
+        SKIP //放弃错过的周期, 在原有的时间网格上等待下一个周期
     };
 
+    /*
+     * 每个ScheduledExecutorService拥有自己的定时线程和分层时间轮(参见TimingWheel.h), 定时线程只负责在任务到期时
+     * 把它交给本线程池执行. 任务的挂入和取消都是O(1)的, 取消的任务立即从时间轮中摘下.
+     * 时间取自单调时钟(System::nanoTime), 不受系统时间调整的影响.
+     * tickDuration是时间轮的精度, 任务最多晚一个tick执行; 需要亚毫秒精度时可以传入更小的值(例如chrono::microseconds(50))
+     */
     class ScheduledExecutorService : extends ExecutorService {
     public:
-        ScheduledExecutorService(int threadCount = 1, bool giveupPendingTasksAfterShutdown = true) :
-            ExecutorService(threadCount, giveupPendingTasksAfterShutdown) {}
-        virtual ~ScheduledExecutorService() {}
+        ScheduledExecutorService(
+                int threadCount = 1,
+                bool giveupPendingTasksAfterShutdown = true,
+                Ref<ThreadPlacement> threadPlacement = nullptr,
+                chrono::nanoseconds tickDuration = chrono::milliseconds(1)) :
+            ExecutorService(threadCount, giveupPendingTasksAfterShutdown, threadPlacement) {
+            if (tickDuration.count() <= 0) {
+                throw_new(IllegalArgumentException, "tickDuration must be positive");
+            }
+            this->timer = new_<Timer>(this, tickDuration.count());
+        }
+        virtual ~ScheduledExecutorService() {
+            this->timer->shutdown(); //定时线程退出后才能析构线程池
+        }
+
+        // 先关闭定时器, 否则定时线程仍会不断醒来, 把到期的任务交给已关闭(会丢弃任务)的线程池
+        virtual void shutdown() override {
+            this->timer->shutdown();
+            ExecutorService::shutdown();
+        }
 
     public:
 
+        using ExecutorService::schedule;
+
         Ref<ScheduledFuture> schedule(Ref<Runnable> runnable, time_t delayMillis) {
-            Ref<SimpleRunnableWrapper> wrapper = new_<SimpleRunnableWrapper>(runnable);
-            scheduledController().addTask(
-                    new_<Task>(this, wrapper, System::currentTimeMillis() + delayMillis)
-            );
-            return wrapper;
+            return this->schedule(runnable, chrono::milliseconds(delayMillis));
+        }
+
+        Ref<ScheduledFuture> schedule(Ref<Runnable> runnable, chrono::nanoseconds delay) {
+            return this->timer->schedule(runnable, delay.count(), 0, CatchUpPolicy::BURST);
         }
 
-        Ref<ScheduledFuture> scheduleAtFixedRate(Ref<Runnable> runnable, time_t initialDelayMillis, time_t peroidMillis) {
-            Ref<FixedRateRunnableWrapper> wrapper =
-                    new_<FixedRateRunnableWrapper>(this, runnable, peroidMillis);
-            scheduledController().addTask(
-                    new_<Task>(this, wrapper, System::currentTimeMillis() + initialDelayMillis)
+        Ref<ScheduledFuture> scheduleAtFixedRate(
+                Ref<Runnable> runnable,
+                time_t initialDelayMillis,
+                time_t peroidMillis,
+                CatchUpPolicy catchUpPolicy = CatchUpPolicy::BURST) {
+            return this->scheduleAtFixedRate(
+                runnable,
+                chrono::milliseconds(initialDelayMillis),
+                chrono::milliseconds(peroidMillis),
+                catchUpPolicy
             );
-            return wrapper;
+        }
+
+        /*
+         * 第n次执行的计划时刻总是"首次计划时刻 + n * period", 不会因定时精度或任务耗时而累积漂移.
+         * 同一个任务不会并发执行: 上一次执行结束后才安排下一次, 已经错过的周期按catchUpPolicy处理
+         */
+        Ref<ScheduledFuture> scheduleAtFixedRate(
+                Ref<Runnable> runnable,
+                chrono::nanoseconds initialDelay,
+                chrono::nanoseconds period,
+                CatchUpPolicy catchUpPolicy = CatchUpPolicy::BURST) {
+            if (period.count() <= 0) {
+                throw_new(IllegalArgumentException, "period must be positive");
+            }
+            return this->timer->schedule(runnable, initialDelay.count(), period.count(), catchUpPolicy);
         }
 
         Ref<ScheduledFuture> scheduleWithFixedDelay(Ref<Runnable> runnable, time_t initialDelayMillis, time_t delayMillis) {
-            Ref<FixedDelayRunnableWrapper> wrapper =
-                    new_<FixedDelayRunnableWrapper>(this, runnable, delayMillis);
-            scheduledController().addTask(
-                    new_<Task>(this, wrapper, System::currentTimeMillis() + initialDelayMillis)
+            return this->scheduleWithFixedDelay(
+                runnable,
+                chrono::milliseconds(initialDelayMillis),
+                chrono::milliseconds(delayMillis)
             );
-            return wrapper;
         }
 
-    private:
-        class Task : extends Object {
-        public:
-            Task(
-                    Ref<ScheduledExecutorService> owner,
-                    Ref<Runnable> runnable,
-                    time_t time) :
-                        owner(owner),
-                        runnable(runnable),
-                        time(time) {}
-            WeakRef<ScheduledExecutorService> owner;
-            Ref<Runnable> runnable;
-            time_t time;
-        };
-        class SimpleRunnableWrapper : extends Object, implements Runnable, implements ScheduledFuture {
-        public:
-            SimpleRunnableWrapper(Ref<Runnable> target) : target(target) {}
-            virtual ~SimpleRunnableWrapper() {}
-            virtual void run() override {
-                if (!this->cancelled) {
-                    this->target();
+        Ref<ScheduledFuture> scheduleWithFixedDelay(
+                Ref<Runnable> runnable,
+                chrono::nanoseconds initialDelay,
+                chrono::nanoseconds delay) {
+            if (delay.count() <= 0) {
+                throw_new(IllegalArgumentException, "delay must be positive");
+            }
+            return this->timer->schedule(runnable, initialDelay.count(), -delay.count(), CatchUpPolicy::BURST);
+        }
+
+        chrono::nanoseconds getTickDuration() const {
+            return chrono::nanoseconds(this->timer->getTickNanos());
+        }
+
+        /*
+         * 定时线程每次醒来的时刻可以推迟timerSlack(默认为0), 使到期时间相近的任务在同一次醒来中一起被分发,
+         * 以少量的延迟换取更少的唤醒次数, 适合大量对精度不敏感的超时任务
+         */
+        void setTimerSlack(chrono::nanoseconds timerSlack) {
+            if (timerSlack.count() < 0) {
+                throw_new(IllegalArgumentException, "timerSlack cannot be negative");
+            }
+            this->timer->setSlackNanos(timerSlack.count());
+        }
+
+        chrono::nanoseconds getTimerSlack() const {
+            return chrono::nanoseconds(this->timer->getSlackNanos());
+        }
+
+        /*
+         * 供C++20协程使用: co_await scheduledExecutorService->delay(millis)挂起当前协程而不占用线程, 到期后在线程池中恢复.
+         * 和schedule()一样, 线程池已关闭时不挂起, 而是由co_await抛出IllegalStateException
+         */
+        struct DelayAwaiter {
+            DelayAwaiter(Ref<ScheduledExecutorService> scheduler, time_t delayMillis) :
+                scheduler(scheduler), delayMillis(delayMillis), rejected(false) {}
+            bool await_ready() const {
+                return this->delayMillis <= 0;
+            }
+            template <typename H>
+            bool await_suspend(H handle) {
+                Ref<ScheduledExecutorService> scheduler = this->scheduler;
+                if (scheduler->isShutdown()) {
+                    this->rejected = true;
+                    return false;
                 }
+                scheduler->schedule(
+                        Runnable::of([handle] {
+                            handle.resume();
+                        }),
+                        this->delayMillis
+                );
+                return true;
             }
-            virtual void cancel() override {
-                this->cancelled.compareAndSet(false, true);
+            void await_resume() const {
+                if (this->rejected) {
+                    throw_new(IllegalStateException, "The ScheduledExecutorService has been shut down");
+                }
             }
         private:
-            Ref<Runnable> target;
-            AtomicBoolean cancelled;
-            interface_refcount()
+            Ref<ScheduledExecutorService> scheduler;
+            time_t delayMillis;
+            bool rejected;
         };
-        class AbstractFixedValueRunnableWrapper : extends Object, implements Runnable, implements ScheduledFuture {
+        DelayAwaiter delay(time_t delayMillis) {
+            return DelayAwaiter(this, delayMillis);
+        }
+
+    private:
+        class Timer;
+
+        /*
+         * 到期后交给线程池执行的任务, 同时也是时间轮的节点, 所以每次调度只分配这一个对象.
+         * periodNanos为0表示只执行一次, 为正表示固定频率, 为负表示固定延迟
+         */
+        class ScheduledTask : extends Object, implements Runnable, implements ScheduledFuture, public TimerNode {
         public:
-            AbstractFixedValueRunnableWrapper(
-                    Ref<ScheduledExecutorService> owner,
-                    Ref<Runnable> target,
-                    time_t fixedValue) :
-                        owner(owner),
-                        target(target),
-                        fixedValue(fixedValue) {}
-            virtual ~AbstractFixedValueRunnableWrapper() {}
-            virtual void cancel() override {
-                this->cancelled.compareAndSet(false, true);
-            }
-        protected:
-            WeakRef<ScheduledExecutorService> owner;
+            ScheduledTask(Ref<Timer> timer, Ref<Runnable> target, int64_t periodNanos, CatchUpPolicy catchUpPolicy) :
+                timer(timer), target(target), periodNanos(periodNanos), catchUpPolicy(catchUpPolicy), deadlineNanos(0) {}
+            virtual ~ScheduledTask() {}
+            virtual void run() override;
+            virtual void cancel() override;
+        private:
+            Ref<Timer> timer;
             Ref<Runnable> target;
-            time_t fixedValue;
+            const int64_t periodNanos;
+            const CatchUpPolicy catchUpPolicy;
+            int64_t deadlineNanos; //本次执行的计划时刻, 由arm在加锁时写入
             AtomicBoolean cancelled;
             interface_refcount()
+            friend class Timer;
         };
-        class FixedRateRunnableWrapper : extends AbstractFixedValueRunnableWrapper {
+
+        /*
+         * 定时线程和时间轮. 时间轮持有每个已挂入任务的一个引用, 摘下时转交给摘下者.
+         * 定时线程在锁外把到期的任务交给线程池, 也不持有ScheduledExecutorService的引用,
+         * ScheduledExecutorService析构时先关闭定时器, 所以executor在定时线程运行期间总是有效的
+         */
+        class Timer : extends Object {
         public:
-            FixedRateRunnableWrapper(Ref<ScheduledExecutorService> owner, Ref<Runnable> target, time_t fixedRate) :
-                AbstractFixedValueRunnableWrapper(owner, target, fixedRate) {}
-            virtual ~FixedRateRunnableWrapper() {}
-            virtual void run() override {
-                if (!this->cancelled) {
-                    Ref<ScheduledExecutorService> owner = this->owner.get();
-                    if (owner) {
-                        owner->schedule(this, this->fixedValue);
+            Timer(ExecutorService *executor, int64_t tickNanos) :
+                executor(executor), startNanos(System::nanoTime()), tickNanos(tickNanos) {
+                LinuxErrors::handle(pthread_mutex_init(&this->mutex, nullptr), "Cannot initialize Timer");
+                pthread_condattr_t attr;
+                pthread_condattr_init(&attr);
+#ifdef __linux__
+                pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); //与System::nanoTime使用同一个时钟
+#endif //__linux__
+                LinuxErrors::handle(pthread_cond_init(&this->cond, &attr), "Cannot initialize Timer");
+                pthread_condattr_destroy(&attr);
+                this->retain();
+                int error = pthread_create(&this->thread, nullptr, threadProc, this);
+                if (error != 0) {
+                    this->release();
+                    throw_new(OSException, error, "Cannot create scheduler thread");
+                }
+            }
+            virtual ~Timer() {
+                pthread_cond_destroy(&this->cond);
+                pthread_mutex_destroy(&this->mutex);
+            }
+
+            Ref<ScheduledFuture> schedule(
+                    Ref<Runnable> runnable,
+                    int64_t delayNanos,
+                    int64_t periodNanos,
+                    CatchUpPolicy catchUpPolicy) {
+                Ref<ScheduledTask> task = new_<ScheduledTask>(this, runnable, periodNanos, catchUpPolicy);
+                this->arm(task.get(), System::nanoTime() + max(delayNanos, (int64_t)0));
+                return task;
+            }
+
+            // 把任务挂入时间轮, 任务已取消或定时器已关闭时忽略
+            void arm(ScheduledTask *task, int64_t deadlineNanos) {
+                int64_t expiryTick = (max(deadlineNanos - this->startNanos, (int64_t)0) + this->tickNanos - 1) / this->tickNanos;
+                pthread_mutex_lock(&this->mutex);
+                if (!this->closed && !task->cancelled && !task->isLinked()) {
+                    task->deadlineNanos = deadlineNanos;
+                    task->retain();
+                    this->wheel.add(task, expiryTick);
+                    if (expiryTick < this->wakeUpTick) {
+                        pthread_cond_signal(&this->cond);
                     }
-                    this->target();
                 }
+                pthread_mutex_unlock(&this->mutex);
             }
-        };
-        class FixedDelayRunnableWrapper : extends AbstractFixedValueRunnableWrapper {
-        public:
-            FixedDelayRunnableWrapper(
-                    Ref<ScheduledExecutorService> owner,
-                    Ref<Runnable> target,
-                    time_t fixedRate) :
-                AbstractFixedValueRunnableWrapper(owner, target, fixedRate) {}
-            virtual ~FixedDelayRunnableWrapper() {}
-            virtual void run() override {
-                if (!this->cancelled) {
-                    defer([=]{
-                        Ref<ScheduledExecutorService> owner = this->owner.get();
-                        if (owner != nullptr) {
-                            owner->schedule(this, this->fixedValue);
-                        }
-                    });
-                    this->target();
+
+            void cancel(ScheduledTask *task) {
+                pthread_mutex_lock(&this->mutex);
+                bool linked = task->isLinked();
+                this->wheel.remove(task);
+                pthread_mutex_unlock(&this->mutex);
+                if (linked) {
+                    task->release(); //调用者持有ScheduledFuture, 这里不会析构
                 }
             }
-        };
-        struct ScheduledController {
-        public:
-            ScheduledController() {
-                this->condition = new_<Condition>(this->mutex);
-                this->nilTask = new_<Task>(nullptr, nullptr, 0);
-                pthread_create(
-                        &this->thread,
-                        nullptr,
-                        threadProc,
-                        this
-                );
+
+            int64_t getTickNanos() const {
+                return this->tickNanos;
             }
-            ~ScheduledController() {
-                if (this->closed.compareAndSet(false, true)) {
-                    this->addTask(this->nilTask);
-                    pthread_join(this->thread, nullptr);
-                }
+
+            void setSlackNanos(int64_t slackNanos) {
+                this->slackNanos.store(slackNanos, memory_order_relaxed);
             }
-            void addTask(Ref<Task> task) {
-                Mutex::Scope scope(this->mutex);
-                auto iterator = this->taskMap.find(task->time);
-                if (iterator == this->taskMap.end()) {
-                    list<Ref<Task>> list;
-                    list.push_back(task);
-                    this->taskMap[task->time] = list;
+
+            int64_t getSlackNanos() const {
+                return this->slackNanos.load(memory_order_relaxed);
+            }
+
+            void shutdown() {
+                vector<TimerNode*> removed;
+                pthread_mutex_lock(&this->mutex);
+                if (this->closed) {
+                    pthread_mutex_unlock(&this->mutex);
+                    return;
+                }
+                this->closed.store(true);
+                this->wheel.clear(removed);
+                pthread_cond_signal(&this->cond);
+                pthread_mutex_unlock(&this->mutex);
+                for (TimerNode *node : removed) {
+                    static_cast<ScheduledTask*>(node)->release();
+                }
+                // 到期任务释放的引用可能是ScheduledExecutorService的最后一个引用, 此时析构发生在定时线程中, 不能等待自己
+                if (pthread_equal(this->thread, pthread_self())) {
+                    pthread_detach(this->thread);
                 } else {
-                    iterator->second.push_back(task);
+                    pthread_join(this->thread, nullptr);
                 }
-                this->condition->notify();
             }
+
         private:
             static void *threadProc(void *data) {
-                static_cast<ScheduledController*>(data)->threadProc();
+                Timer *timer = static_cast<Timer*>(data);
+                ThreadPlacement::named("scheduler")->applyToCurrentThread(0);
+                timer->threadRun();
+                timer->release();
                 return nullptr;
             }
-            void threadProc() {
+
+            void threadRun() {
+                vector<TimerNode*> expired;
+                pthread_mutex_lock(&this->mutex);
                 while (!this->closed) {
-                    Ref<Task> task = this->fetchTask();
-                    if (task == nullptr) {
-                        break;
+                    this->wheel.advanceTo((System::nanoTime() - this->startNanos) / this->tickNanos, expired);
+                    if (!expired.empty()) {
+                        pthread_mutex_unlock(&this->mutex);
+                        this->dispatch(expired);
+                        pthread_mutex_lock(&this->mutex);
+                        continue;
                     }
-                    Ref<ScheduledExecutorService> owner = task->owner.get();
-                    if (owner) {
-                        owner->execute(task->runnable);
+                    // 只有比wakeUpTick更早到期的新任务才需要唤醒定时线程
+                    this->wakeUpTick = this->wheel.nextEventTick();
+                    if (this->wakeUpTick == INT64_MAX) {
+                        pthread_cond_wait(&this->cond, &this->mutex);
+                    } else {
+                        this->awaitUntil(
+                            this->startNanos + this->wakeUpTick * this->tickNanos + this->slackNanos.load(memory_order_relaxed)
+                        );
                     }
+                    this->wakeUpTick = INT64_MIN;
                 }
+                pthread_mutex_unlock(&this->mutex);
             }
-            Ref<Task> fetchTask() {
-                while (!this->closed) {
-                    Mutex::Scope scope(this->mutex);
-                    while (this->taskMap.empty()) {
-                        this->condition->wait();
-                    }
-                    list<Ref<Task>> &taskList = this->taskMap.begin()->second;
-                    Ref<Task> task = taskList.front();
-                    if (task == this->nilTask) {
-                        return nullptr;
-                    }
-                    time_t sleepMillis = task->time - System::currentTimeMillis();
-                    if (sleepMillis > 0) {
-                        this->condition->wait(sleepMillis);
-                    } else {
-                        taskList.pop_front();
-                        if (taskList.empty()) {
-                            this->taskMap.erase(this->taskMap.begin());
-                        }
-                        return task;
+
+            // 在锁外把到期的任务交给线程池
+            void dispatch(vector<TimerNode*> &expired) {
+                for (TimerNode *node : expired) {
+                    Ref<ScheduledTask> task = static_cast<ScheduledTask*>(node);
+                    task->release(); //接管时间轮持有的引用
+                    if (!this->closed && !task->cancelled) {
+                        this->executor->execute(task);
                     }
                 }
-                return nullptr;
+                expired.clear();
             }
-        private:
-            AtomicBoolean closed;
+
+            void awaitUntil(int64_t deadlineNanos) {
+#ifdef __linux__
+                int64_t absoluteNanos = deadlineNanos;
+#else
+                struct timeval tv;
+                gettimeofday(&tv, nullptr);
+                int64_t absoluteNanos = (int64_t)tv.tv_sec * 1000000000 + (int64_t)tv.tv_usec * 1000 +
+                        (deadlineNanos - System::nanoTime());
+#endif //__linux__
+                struct timespec ts;
+                ts.tv_sec = absoluteNanos / 1000000000;
+                ts.tv_nsec = absoluteNanos % 1000000000;
+                pthread_cond_timedwait(&this->cond, &this->mutex, &ts);
+            }
+
+            ExecutorService *executor;
+            const int64_t startNanos;
+            const int64_t tickNanos;
+            atomic<int64_t> slackNanos { 0 };
             pthread_t thread;
-            map<time_t, list<Ref<Task>>> taskMap;
-            Mutex mutex;
-            Ref<Condition> condition;
-            Ref<Task> nilTask;
+            pthread_mutex_t mutex;
+            pthread_cond_t cond;
+            TimingWheel wheel;
+            AtomicBoolean closed;
+            int64_t wakeUpTick = INT64_MIN;
+            friend class ScheduledTask;
         };
-        static ScheduledController &scheduledController() {
-            static ScheduledController instance;
-            return instance;
+
+        Ref<Timer> timer;
+    };
+
+    inline void ScheduledExecutorService::ScheduledTask::run() {
+        if (this->cancelled) {
+            return;
         }
+        // 执行结束后才安排下一次, 所以同一个任务不会并发执行
+        defer([this]() {
+            if (this->periodNanos == 0) {
+                return;
+            }
+            int64_t now = System::nanoTime();
+            int64_t next;
+            if (this->periodNanos < 0) {
+                next = now - this->periodNanos;
+            } else {
+                next = this->deadlineNanos + this->periodNanos; //以计划时刻而不是实际执行时刻为基准, 不会漂移
+                if (next <= now && this->catchUpPolicy == CatchUpPolicy::SKIP) {
+                    next += ((now - next) / this->periodNanos + 1) * this->periodNanos;
+                }
+            }
+            this->timer->arm(this, next);
+        });
+        this->target();
+    }
+
+    inline void ScheduledExecutorService::ScheduledTask::cancel() {
+        if (this->cancelled.compareAndSet(false, true)) {
+            this->timer->cancel(this);
+        }
+    }
+
+    inline Ref<ScheduledFuture> ExecutorService::dumpStatsAtFixedRate(
+            Ref<RefConsumer<ExecutorStats>> consumer,
+            time_t periodMillis) {
+        if (consumer == nullptr) {
+            throw_new(IllegalArgumentException, "consumer cannot be null");
+        }
+        if (periodMillis <= 0) {
+            throw_new(IllegalArgumentException, "periodMillis must be positive");
+        }
+        WeakRef<ExecutorService> weakThis = this;
+        // 所有线程池共享一个调度线程, 导出统计的任务不会因被观察的线程池繁忙而延迟.
+        // 静态对象按构造的逆序析构, 关闭statsScheduler时要用到的弱引用全局上下文和nilRunnable必须先于它构造
+        nilRunnable();
+        static Ref<ScheduledExecutorService> statsScheduler =
+                new_<ScheduledExecutorService>(1, true, ThreadPlacement::named("stats"));
+        Ref<ScheduledFuture> statsDump = statsScheduler->scheduleAtFixedRate(
+            Runnable::of([weakThis, consumer] {
+                Ref<ExecutorService> executorService = weakThis.get();
+                if (executorService != nullptr) {
+                    consumer(executorService->getStats());
+                }
+            }),
+            periodMillis,
+            periodMillis
+        );
+        Mutex::Scope scope(this->statsDumpMutex);
+        this->statsDumps.push_back(statsDump);
+        return statsDump;
+    }
+
+    /**
+     * 每个NUMA节点一个ExecutorService, 其工作线程只运行在本节点的CPU上.
+     *
+     * execute(runnable)把任务交给调用者当前所在节点的线程池, 任务对象, 队列节点以及任务访问的数据
+     * (按first-touch策略分配在本节点的内存中)都不会跨越节点; execute(runnable, node)显式地指定节点.
+     * 只有一个节点的机器上等价于一个普通的ExecutorService
+     */
+    class NumaExecutorService : extends Object, implements Executor {
+    public:
+        // threadsPerNode为0时每个节点的线程数等于该节点的CPU数
+        NumaExecutorService(
+                int threadsPerNode = 0,
+                ExecutorMode mode = ExecutorMode::SHARED_QUEUE,
+                const string &namePrefix = "numa") {
+            if (threadsPerNode < 0) {
+                throw_new(IllegalArgumentException, "threadsPerNode cannot be negative");
+            }
+            for (int node = 0; node < NumaTopology::nodeCount(); node++) {
+                int threadCount = threadsPerNode != 0 ? threadsPerNode : (int)NumaTopology::cpusOfNode(node).size();
+                ostringstream prefix;
+                prefix << namePrefix << node;
+                this->executors.push_back(
+                    new_<ExecutorService>(
+                        threadCount,
+                        mode,
+                        true,
+                        ThreadPlacement::onNumaNode(prefix.str(), node)
+                    )
+                );
+            }
+        }
+        virtual ~NumaExecutorService() {}
+
+        virtual void execute(Ref<Runnable> runnable) override {
+            this->executors[NumaTopology::currentNode()]->execute(runnable);
+        }
+
+        void execute(Ref<Runnable> runnable, int node) {
+            this->getExecutor(node)->execute(runnable);
+        }
+
+        int getNodeCount() const {
+            return (int)this->executors.size();
+        }
+
+        Ref<ExecutorService> getExecutor(int node) const {
+            if (node < 0 || node >= (int)this->executors.size()) {
+                throw_new(IllegalArgumentException, "Illegal NUMA node");
+            }
+            return this->executors[node];
+        }
+
+        void shutdown() {
+            for (const Ref<ExecutorService> &executor : this->executors) {
+                executor->shutdown();
+            }
+        }
+
+    private:
+        vector<Ref<ExecutorService>> executors;
+        interface_refcount()
     };
 }
@@ -0,0 +1,381 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Functional.h"
+#include "Auxiliary.h"
+#include "BlockingQueue.h"
+#include <cmath>
+#include <vector>
+
+namespace com_lanjing_cpp_common {
+
+    class HistogramSnapshot;
+
+    /**
+     * HdrHistogram风格的对数-线性直方图: 每个2的幂区间再等分为16个子区间, 相对误差不超过1/16,
+     * 用固定数量的计数器覆盖int64_t的全部取值范围, 不需要预先知道数值的范围.
+     * record是无锁的, 可以被多个线程并发调用
+     */
+    class LatencyHistogram {
+    public:
+        static const int SUB_BUCKET_BITS = 4;
+        static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+        static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+        LatencyHistogram() {
+            for (int i = 0; i < BUCKET_COUNT; i++) {
+                this->counts[i].store(0, memory_order_relaxed);
+            }
+        }
+        LatencyHistogram(const LatencyHistogram &) = delete;
+        LatencyHistogram &operator = (const LatencyHistogram &) = delete;
+
+        void record(int64_t value) {
+            if (value < 0) {
+                value = 0; //防御时钟误差
+            }
+            this->counts[bucketIndex(value)].fetch_add(1, memory_order_relaxed);
+            this->totalValue.fetch_add(value, memory_order_relaxed);
+            int64_t max = this->maxValue.load(memory_order_relaxed);
+            while (value > max && !this->maxValue.compare_exchange_weak(max, value, memory_order_relaxed));
+        }
+
+        // 并发记录时得到的并非原子快照, 但每个计数器本身是准确的
+        HistogramSnapshot snapshot() const;
+
+        static int bucketIndex(int64_t value) {
+            if (value < SUB_BUCKET_COUNT) {
+                return (int)value;
+            }
+            int exponent = 63 - __builtin_clzll((unsigned long long)value);
+            int shift = exponent - SUB_BUCKET_BITS;
+            return (shift + 1) * SUB_BUCKET_COUNT + (int)((value >> shift) - SUB_BUCKET_COUNT);
+        }
+
+        // 与该桶中的任何数值都被视为相等的最大值
+        static int64_t highestEquivalentValue(int index) {
+            if (index < SUB_BUCKET_COUNT) {
+                return index;
+            }
+            int shift = index / SUB_BUCKET_COUNT - 1;
+            uint64_t mantissa = SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT;
+            uint64_t value = ((mantissa + 1) << shift) - 1;
+            return value > (uint64_t)INT64_MAX ? INT64_MAX : (int64_t)value;
+        }
+
+    private:
+        atomic<int64_t> counts[BUCKET_COUNT];
+        atomic<int64_t> totalValue { 0 };
+        atomic<int64_t> maxValue { 0 };
+    };
+
+    // LatencyHistogram的只读副本
+    class HistogramSnapshot {
+    public:
+        HistogramSnapshot() : counts(LatencyHistogram::BUCKET_COUNT), totalCount(0), totalValue(0), maxValue(0) {}
+
+        int64_t getCount() const {
+            return this->totalCount;
+        }
+
+        double getMean() const {
+            return this->totalCount == 0 ? 0 : (double)this->totalValue / this->totalCount;
+        }
+
+        int64_t getMax() const {
+            return this->maxValue;
+        }
+
+        // percentile的取值范围是[0, 100], 例如99.9
+        int64_t getValueAtPercentile(double percentile) const {
+            if (this->totalCount == 0) {
+                return 0;
+            }
+            int64_t target = (int64_t)ceil(min(max(percentile, 0.0), 100.0) / 100 * this->totalCount);
+            if (target < 1) {
+                target = 1;
+            }
+            int64_t cumulative = 0;
+            for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; i++) {
+                cumulative += this->counts[i];
+                if (cumulative >= target) {
+                    return min(LatencyHistogram::highestEquivalentValue(i), this->maxValue);
+                }
+            }
+            return this->maxValue;
+        }
+
+    private:
+        vector<int64_t> counts;
+        int64_t totalCount;
+        int64_t totalValue;
+        int64_t maxValue;
+        friend class LatencyHistogram;
+    };
+
+    inline HistogramSnapshot LatencyHistogram::snapshot() const {
+        HistogramSnapshot snapshot;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            snapshot.counts[i] = this->counts[i].load(memory_order_relaxed);
+            snapshot.totalCount += snapshot.counts[i];
+        }
+        snapshot.totalValue = this->totalValue.load(memory_order_relaxed);
+        snapshot.maxValue = this->maxValue.load(memory_order_relaxed);
+        return snapshot;
+    }
+
+    /**
+     * 线程池在某一时刻的统计快照, 由ExecutorService::getStats()返回.
+     * 时间的单位都是纳秒, 只有被采样的任务才会计入两个直方图
+     */
+    class ExecutorStats : extends Object {
+    public:
+        ExecutorStats(
+                int poolSize,
+                int activeCount,
+                int64_t queueSize,
+                int64_t submittedTaskCount,
+                int64_t completedTaskCount,
+                int64_t failedTaskCount,
+                int samplingInterval,
+                const HistogramSnapshot &queueWaitTime,
+                const HistogramSnapshot &executionTime,
+                Ref<Exception> lastFailure) :
+                    poolSize(poolSize),
+                    activeCount(activeCount),
+                    queueSize(queueSize),
+                    submittedTaskCount(submittedTaskCount),
+                    completedTaskCount(completedTaskCount),
+                    failedTaskCount(failedTaskCount),
+                    samplingInterval(samplingInterval),
+                    queueWaitTime(queueWaitTime),
+                    executionTime(executionTime),
+                    lastFailure(lastFailure) {}
+        virtual ~ExecutorStats() {}
+
+        int getPoolSize() const {
+            return this->poolSize;
+        }
+
+        // 正在执行任务的工作线程数
+        int getActiveCount() const {
+            return this->activeCount;
+        }
+
+        // 已提交但尚未开始执行的任务数
+        int64_t getQueueSize() const {
+            return this->queueSize;
+        }
+
+        int64_t getSubmittedTaskCount() const {
+            return this->submittedTaskCount;
+        }
+
+        // 正常结束的任务数, 不包括抛出异常的任务
+        int64_t getCompletedTaskCount() const {
+            return this->completedTaskCount;
+        }
+
+        // 抛出异常的任务数
+        int64_t getFailedTaskCount() const {
+            return this->failedTaskCount;
+        }
+
+        int getSamplingInterval() const {
+            return this->samplingInterval;
+        }
+
+        // 从提交到开始执行的时间
+        const HistogramSnapshot &getQueueWaitTime() const {
+            return this->queueWaitTime;
+        }
+
+        const HistogramSnapshot &getExecutionTime() const {
+            return this->executionTime;
+        }
+
+        // 最近一个任务抛出的异常, 没有时为nullptr
+        Ref<Exception> getLastFailure() const {
+            return this->lastFailure;
+        }
+
+        virtual string toString() const override {
+            ostringstream builder;
+            builder << "poolSize=" << this->poolSize
+                    << ", active=" << this->activeCount
+                    << ", queued=" << this->queueSize
+                    << ", submitted=" << this->submittedTaskCount
+                    << ", completed=" << this->completedTaskCount
+                    << ", failed=" << this->failedTaskCount;
+            if (this->samplingInterval != 0) {
+                builder << ", queueWait" << histogramToString(this->queueWaitTime)
+                        << ", execution" << histogramToString(this->executionTime);
+            }
+            return builder.str();
+        }
+
+    private:
+        static string histogramToString(const HistogramSnapshot &histogram) {
+            ostringstream builder;
+            builder << "(us): {count=" << histogram.getCount()
+                    << ", mean=" << (int64_t)histogram.getMean() / 1000
+                    << ", p50=" << histogram.getValueAtPercentile(50) / 1000
+                    << ", p99=" << histogram.getValueAtPercentile(99) / 1000
+                    << ", p99.9=" << histogram.getValueAtPercentile(99.9) / 1000
+                    << ", max=" << histogram.getMax() / 1000
+                    << '}';
+            return builder.str();
+        }
+
+        int poolSize;
+        int activeCount;
+        int64_t queueSize;
+        int64_t submittedTaskCount;
+        int64_t completedTaskCount;
+        int64_t failedTaskCount;
+        int samplingInterval;
+        HistogramSnapshot queueWaitTime;
+        HistogramSnapshot executionTime;
+        Ref<Exception> lastFailure;
+    };
+
+    /**
+     * 线程池内部使用的统计记录器.
+     *
+     * 提交计数使用LongAdder, 直方图只记录被采样的任务: samplingInterval为0时不采样(默认),
+     * 为n时每个提交线程每提交n个任务采样一个. 被采样的任务被包装为一个记录提交时刻的Runnable,
+     * 它在执行时记录排队时间和执行时间, 未被采样的任务不会产生任何额外的对象和时钟调用.
+     * 包装对象转发原任务的Prioritized和Delayed, 因此采样不会改变任务在PriorityBlockingQueue和DelayQueue中的顺序
+     */
+    class ExecutorMetrics : extends Object {
+    public:
+        ExecutorMetrics() {}
+        virtual ~ExecutorMetrics() {}
+
+        void setSamplingInterval(int samplingInterval) {
+            if (samplingInterval < 0) {
+                throw_new(IllegalArgumentException, "samplingInterval cannot be negative");
+            }
+            this->samplingInterval.store(samplingInterval, memory_order_relaxed);
+        }
+
+        int getSamplingInterval() const {
+            return this->samplingInterval.load(memory_order_relaxed);
+        }
+
+        // 提交任务时调用, 返回真正放入队列的任务
+        Ref<Runnable> onSubmit(Ref<Runnable> runnable) {
+            this->submittedTaskCount.increment();
+            int interval = this->samplingInterval.load(memory_order_relaxed);
+            if (interval == 0 || ++sampleCounter() % (unsigned)interval != 0) {
+                return runnable;
+            }
+            return new_<SampledRunnable>(this, runnable);
+        }
+
+        /*
+         * 任务抛出异常时由工作线程调用: 记录为lastFailure, 然后交给uncaughtExceptionHandler处理,
+         * 没有设置handler时打印异常栈
+         */
+        void onFailure(Exception *ex) {
+            Ref<RefConsumer<Exception>> handler;
+            {
+                Mutex::Scope scope(this->mutex);
+                this->lastFailure = ex;
+                handler = this->uncaughtExceptionHandler;
+            }
+            if (handler == nullptr) {
+                ex->printStackTrace();
+                return;
+            }
+            try_ {
+                handler(ex);
+            } catch_(Exception, handlerException) {
+                handlerException->printStackTrace(); //handler本身的异常不能导致工作线程退出
+            } end_try
+        }
+
+        void setUncaughtExceptionHandler(Ref<RefConsumer<Exception>> handler) {
+            Mutex::Scope scope(this->mutex);
+            this->uncaughtExceptionHandler = handler;
+        }
+
+        Ref<ExecutorStats> snapshot(
+                int poolSize,
+                int activeCount,
+                int64_t queueSize,
+                int64_t completedTaskCount,
+                int64_t failedTaskCount) {
+            Ref<Exception> lastFailure;
+            {
+                Mutex::Scope scope(this->mutex);
+                lastFailure = this->lastFailure;
+            }
+            return new_<ExecutorStats>(
+                poolSize,
+                activeCount,
+                queueSize,
+                this->submittedTaskCount.sum(),
+                completedTaskCount,
+                failedTaskCount,
+                this->getSamplingInterval(),
+                this->queueWaitTime.snapshot(),
+                this->executionTime.snapshot(),
+                lastFailure
+            );
+        }
+
+    private:
+        class SampledRunnable : extends Object, implements Runnable, implements Prioritized, implements Delayed {
+        public:
+            SampledRunnable(Ref<ExecutorMetrics> metrics, Ref<Runnable> target) :
+                metrics(metrics),
+                target(target),
+                prioritized(dynamic_cast<Prioritized*>(target.get())),
+                delayed(dynamic_cast<Delayed*>(target.get())),
+                submitNanos(System::nanoTime()) {}
+            virtual ~SampledRunnable() {}
+            virtual void run() override {
+                int64_t startNanos = System::nanoTime();
+                this->metrics->queueWaitTime.record(startNanos - this->submitNanos);
+                defer([this, startNanos]() {
+                    this->metrics->executionTime.record(System::nanoTime() - startNanos);
+                });
+                this->target();
+            }
+            // 原任务不是Prioritized/Delayed时, 返回队列对普通元素使用的默认值
+            virtual int getPriority() override {
+                return this->prioritized != nullptr ? this->prioritized->getPriority() : INT_MIN;
+            }
+            virtual int64_t getDelay() override {
+                return this->delayed != nullptr ? this->delayed->getDelay() : 0;
+            }
+        private:
+            Ref<ExecutorMetrics> metrics;
+            Ref<Runnable> target;
+            Prioritized *prioritized; //由target持有
+            Delayed *delayed; //由target持有
+            int64_t submitNanos;
+            interface_refcount()
+        };
+
+        static unsigned &sampleCounter() {
+            static thread_local unsigned counter = 0;
+            return counter;
+        }
+
+        atomic<int> samplingInterval { 0 };
+        LongAdder submittedTaskCount;
+        LatencyHistogram queueWaitTime;
+        LatencyHistogram executionTime;
+        Mutex mutex;
+        Ref<Exception> lastFailure;
+        Ref<RefConsumer<Exception>> uncaughtExceptionHandler;
+    };
+}
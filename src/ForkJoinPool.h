@@ -0,0 +1,604 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Functional.h"
+#include "Executor.h"
+#include "BlockingQueue.h"
+#include "Auxiliary.h"
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sched.h>
+
+namespace com_lanjing_cpp_common {
+
+    class ForkJoinPool;
+
+    /**
+     * java.util.concurrent.ForkJoinTask的简化实现, 请继承RecursiveTask<T>或RecursiveAction
+     *
+     * 在ForkJoinPool的工作线程中调用fork()只是把任务压入当前线程自己的双端队列, 不加锁也不分配内存;
+     * join()在任务尚未完成时不会立即挂起, 而是先执行本线程和其他线程队列中的任务(helping join),
+     * 只有确实无事可做时才挂起, 所以递归分治的任务不会因为等待子任务而耗尽工作线程
+     */
+    abstract class ForkJoinTask : extends Object {
+    public:
+        virtual ~ForkJoinTask() {}
+
+        // 安排任务异步执行; 在ForkJoinPool之外调用时提交给ForkJoinPool::commonPool()
+        void fork();
+
+        bool isDone() const {
+            return (this->status.load(memory_order_acquire) & DONE_MASK) != 0;
+        }
+
+        bool isCompletedAbnormally() const {
+            return (this->status.load(memory_order_acquire) & EXCEPTIONAL) != 0;
+        }
+
+        // 异常完成时返回compute抛出的异常, 否则返回nullptr
+        Ref<Exception> getException() const {
+            return this->isCompletedAbnormally() ? this->exception : nullptr;
+        }
+
+        // 等价于Java的ForkJoinTask.invokeAll(t1, t2): fork第二个任务, 在当前线程执行第一个任务, 然后join第二个任务
+        static void invokeAll(Ref<ForkJoinTask> task1, Ref<ForkJoinTask> task2) {
+            task2->fork();
+            task1->doExec();
+            task1->awaitDone();
+            task2->awaitDone();
+        }
+
+    protected:
+        ForkJoinTask() : status(0) {}
+
+        // 由子类实现, 执行compute并保存结果
+        virtual void exec() = 0;
+
+        // 等待任务完成(期间帮助执行其他任务), 异常完成时重新抛出compute抛出的异常
+        void awaitDone();
+
+        // 在当前线程中执行任务, 已完成的任务不会再次执行
+        void doExec() {
+            if (this->isDone()) {
+                return;
+            }
+            int completion = NORMAL;
+            try_ {
+                this->exec();
+            } catch_(Exception, ex) {
+                this->exception = ex;
+                completion = EXCEPTIONAL;
+            } end_try
+            if (this->status.fetch_or(completion) & SIGNAL) {
+                completionEvent().notifyAll();
+            }
+        }
+
+    private:
+        // 挂起直到任务完成; 先设置SIGNAL, 完成者只有看到SIGNAL才会发出通知
+        void awaitCompletion() {
+            EventCount &event = completionEvent();
+            unsigned key = event.prepareWait();
+            if (this->status.fetch_or(SIGNAL) & DONE_MASK) {
+                event.cancelWait();
+                return;
+            }
+            event.wait(key);
+        }
+
+        // 所有被挂起的join共用, 只有完成一个已有线程在等待的任务时才会发出通知
+        static EventCount &completionEvent() {
+            static EventCount instance;
+            return instance;
+        }
+
+    private:
+        static const int NORMAL = 1;
+        static const int EXCEPTIONAL = 2;
+        static const int DONE_MASK = NORMAL | EXCEPTIONAL;
+        static const int SIGNAL = 4;
+
+        atomic<int> status;
+        Ref<Exception> exception;
+
+        friend class ForkJoinPool;
+    };
+
+    // 有返回值的分治任务, 对应java.util.concurrent.RecursiveTask<V>
+    template <typename T>
+    abstract class RecursiveTask : extends ForkJoinTask {
+    public:
+        T join() {
+            this->awaitDone();
+            return this->result;
+        }
+
+        // 在当前线程中直接执行
+        T invoke() {
+            this->doExec();
+            return this->join();
+        }
+
+        T getRawResult() const {
+            return this->result;
+        }
+
+    protected:
+        virtual T compute() = 0;
+
+    private:
+        virtual void exec() override {
+            this->result = this->compute();
+        }
+
+    private:
+        T result {};
+    };
+
+    // 没有返回值的分治任务, 对应java.util.concurrent.RecursiveAction
+    abstract class RecursiveAction : extends ForkJoinTask {
+    public:
+        void join() {
+            this->awaitDone();
+        }
+
+        // 在当前线程中直接执行
+        void invoke() {
+            this->doExec();
+            this->join();
+        }
+
+    protected:
+        virtual void compute() = 0;
+
+    private:
+        virtual void exec() override {
+            this->compute();
+        }
+    };
+
+    /**
+     * java.util.concurrent.ForkJoinPool的简化实现
+     *
+     * 每个工作线程拥有一个Chase-Lev双端队列: 所有者在底部无锁地压入和弹出(LIFO, 数据在缓存中是热的),
+     * 其他线程从顶部窃取(FIFO, 窃取到的往往是较大的子任务), 只有争抢最后一个任务时才需要CAS.
+     * 空闲的工作线程从随机选择的线程开始窃取, 全部为空时才通过EventCount挂起.
+     * 非工作线程提交的任务进入一个共享的提交队列
+     */
+    class ForkJoinPool : extends Object, implements Executor {
+    public:
+        ForkJoinPool(int parallelism = defaultParallelism()) {
+            if (parallelism < 1) {
+                throw_new(IllegalArgumentException, "parallelism cannot be less than 1");
+            }
+            this->sharedPool = new_<SharedPool>(parallelism);
+        }
+        virtual ~ForkJoinPool() {
+            this->sharedPool->shutdown();
+        }
+
+        // 进程内共享的线程池, 并行度为CPU核心数; 在线程池之外调用fork()的任务提交到这里
+        static Ref<ForkJoinPool> commonPool() {
+            static Ref<ForkJoinPool> instance = new_<ForkJoinPool>();
+            return instance;
+        }
+
+        static int defaultParallelism() {
+            return max((int)thread::hardware_concurrency(), 1);
+        }
+
+        int getParallelism() const {
+            return this->sharedPool->getParallelism();
+        }
+
+        // 从其他工作线程的队列中窃取任务的总次数
+        int64_t getStealCount() const {
+            return this->sharedPool->getStealCount();
+        }
+
+        bool isShutdown() const {
+            return this->sharedPool->isShutdown();
+        }
+
+        // 不再接受外部提交的任务; 已提交的任务(以及它们fork的子任务)执行完毕后工作线程才会退出
+        void shutdown() {
+            this->sharedPool->shutdown();
+        }
+
+        virtual void execute(Ref<Runnable> runnable) override {
+            if (runnable == nullptr) {
+                throw_new(IllegalArgumentException, "runnable cannot be null");
+            }
+            this->sharedPool->submit(new_<RunnableTask>(runnable).get());
+        }
+
+        template <typename T>
+        Ref<T> submit(Ref<T> task) {
+            if (task == nullptr) {
+                throw_new(IllegalArgumentException, "task cannot be null");
+            }
+            this->sharedPool->submit(task.get());
+            return task;
+        }
+
+        // 提交任务并等待其结果
+        template <typename T>
+        T invoke(Ref<RecursiveTask<T>> task) {
+            return this->submit(task)->join();
+        }
+
+        void invoke(Ref<RecursiveAction> task) {
+            this->submit(task)->join();
+        }
+
+    private:
+        class RunnableTask : extends RecursiveAction {
+        public:
+            RunnableTask(Ref<Runnable> runnable) : runnable(runnable) {}
+        protected:
+            virtual void compute() override {
+                try_ {
+                    this->runnable();
+                } catch_(Exception, ex) {
+                    ex->printStackTrace();
+                } end_try
+            }
+        private:
+            Ref<Runnable> runnable;
+        };
+
+        /*
+         * Chase-Lev工作窃取双端队列(按"Correct and Efficient Work-Stealing for Weak Memory Models"的C11版本实现)
+         *
+         * 队列中的任务是额外持有一个引用的原始指针, 取出任务的线程负责释放该引用.
+         * 扩容后的旧数组可能仍被窃取者读取, 所以保留到队列析构时才释放
+         */
+        class WorkQueue {
+        public:
+            WorkQueue() : top(0), bottom(0) {
+                this->arrays.emplace_back(new TaskArray(INITIAL_CAPACITY));
+                this->array.store(this->arrays.back().get(), memory_order_relaxed);
+            }
+            ~WorkQueue() {
+                while (ForkJoinTask *task = this->pop()) {
+                    task->release();
+                }
+            }
+
+            // 仅供所有者调用
+            void push(ForkJoinTask *task) {
+                int64_t b = this->bottom.load(memory_order_relaxed);
+                int64_t t = this->top.load(memory_order_acquire);
+                TaskArray *a = this->array.load(memory_order_relaxed);
+                if (b - t > a->mask) {
+                    a = this->grow(a, t, b);
+                }
+                a->put(b, task);
+                this->bottom.store(b + 1, memory_order_release);
+            }
+
+            // 仅供所有者调用, 从底部弹出最近压入的任务
+            ForkJoinTask *pop() {
+                int64_t b = this->bottom.load(memory_order_relaxed) - 1;
+                TaskArray *a = this->array.load(memory_order_relaxed);
+                this->bottom.store(b, memory_order_seq_cst); //必须先于读取top对窃取者可见
+                int64_t t = this->top.load(memory_order_seq_cst);
+                if (t > b) {
+                    this->bottom.store(b + 1, memory_order_relaxed);
+                    return nullptr;
+                }
+                ForkJoinTask *task = a->get(b);
+                if (t == b) {
+                    // 只剩最后一个任务, 和窃取者竞争
+                    if (!this->top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+                        task = nullptr;
+                    }
+                    this->bottom.store(b + 1, memory_order_relaxed);
+                }
+                return task;
+            }
+
+            // 可被任何线程调用, 从顶部窃取最早压入的任务; 队列为空或竞争失败时返回nullptr
+            ForkJoinTask *steal() {
+                int64_t t = this->top.load(memory_order_seq_cst);
+                int64_t b = this->bottom.load(memory_order_seq_cst);
+                if (t >= b) {
+                    return nullptr;
+                }
+                TaskArray *a = this->array.load(memory_order_acquire);
+                ForkJoinTask *task = a->get(t);
+                if (!this->top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+                    return nullptr;
+                }
+                return task;
+            }
+
+            bool isEmpty() const {
+                return this->top.load(memory_order_acquire) >= this->bottom.load(memory_order_acquire);
+            }
+
+        private:
+            struct TaskArray {
+                TaskArray(int64_t capacity) : mask(capacity - 1), slots(new atomic<ForkJoinTask*>[capacity]) {}
+                ForkJoinTask *get(int64_t index) const {
+                    return this->slots[index & this->mask].load(memory_order_relaxed);
+                }
+                void put(int64_t index, ForkJoinTask *task) {
+                    this->slots[index & this->mask].store(task, memory_order_relaxed);
+                }
+                const int64_t mask;
+                unique_ptr<atomic<ForkJoinTask*>[]> slots;
+            };
+
+            TaskArray *grow(TaskArray *a, int64_t t, int64_t b) {
+                TaskArray *newArray = new TaskArray((a->mask + 1) * 2);
+                for (int64_t i = t; i < b; i++) {
+                    newArray->put(i, a->get(i));
+                }
+                this->arrays.emplace_back(newArray);
+                this->array.store(newArray, memory_order_release);
+                return newArray;
+            }
+
+        private:
+            static const int64_t INITIAL_CAPACITY = 256;
+            static const size_t CACHE_LINE_SIZE = 64;
+
+            // 窃取者竞争的top和所有者独占的bottom位于不同的缓存行
+            atomic<int64_t> top;
+            char topPadding[CACHE_LINE_SIZE - sizeof(atomic<int64_t>)];
+            atomic<int64_t> bottom;
+            atomic<TaskArray*> array;
+            vector<unique_ptr<TaskArray>> arrays;
+            char bottomPadding[CACHE_LINE_SIZE];
+        };
+
+        class SharedPool;
+
+        struct Worker {
+            Worker(SharedPool *pool, int index) : pool(pool), index(index), seed(0x9E3779B9u * (index + 1)) {}
+            WorkQueue queue;
+            SharedPool *pool;
+            int index;
+            unsigned seed;
+            // xorshift, 用于随机选择窃取对象
+            unsigned nextRandom() {
+                this->seed ^= this->seed << 13;
+                this->seed ^= this->seed >> 17;
+                this->seed ^= this->seed << 5;
+                return this->seed;
+            }
+        };
+
+        // 和ExecutorService一样分为内外两层, 外层ForkJoinPool的析构使线程池关闭, 内层被工作线程共享
+        class SharedPool : extends Object {
+        public:
+            SharedPool(int parallelism) {
+                this->submissionQueue = new_<LinkedBlockingQueue<ForkJoinTask>>();
+                for (int i = 0; i < parallelism; i++) {
+                    this->workers.emplace_back(new Worker(this, i));
+                }
+                this->semaphore = new_<Semaphore>();
+                this->threads = Array<pthread_t>::newInstance(parallelism, ArrayElementType::C);
+                for (int i = 0; i < parallelism; i++) {
+                    this->retain();
+                    int error = pthread_create(&this->threads[i], nullptr, threadProc, this->workers[i].get());
+                    if (error != 0) {
+                        this->release();
+                        this->shutdown(i);
+                        ostringstream oss;
+                        oss << "Cannot create ForkJoinPool thread-" << i;
+                        throw_new(OSException, error, oss.str().c_str());
+                    }
+                }
+            }
+            virtual ~SharedPool() {}
+
+            int getParallelism() const {
+                return (int)this->workers.size();
+            }
+
+            int64_t getStealCount() const {
+                return this->stealCount.sum();
+            }
+
+            bool isShutdown() const {
+                return this->closed;
+            }
+
+            void shutdown() {
+                this->shutdown(this->threads.length());
+            }
+
+            // 外部线程提交任务
+            void submit(ForkJoinTask *task) {
+                if (this->closed) {
+                    throw_new(IllegalStateException, "The ForkJoinPool has been shut down");
+                }
+                this->submissionQueue->put(task);
+                this->workAvailable.notify();
+            }
+
+            // 工作线程fork任务, 调用者已为队列持有一个引用
+            void push(Worker *worker, ForkJoinTask *task) {
+                worker->queue.push(task);
+                this->workAvailable.notify();
+            }
+
+            // 工作线程join尚未完成的任务: 先执行本线程和其他线程队列中的任务, 无事可做时才挂起
+            void helpJoin(Worker *worker, ForkJoinTask *task) {
+                unsigned idleCount = 0;
+                while (!task->isDone()) {
+                    ForkJoinTask *other = worker->queue.pop();
+                    if (other == nullptr) {
+                        other = this->scan(worker);
+                    }
+                    if (other != nullptr) {
+                        runTask(other);
+                        idleCount = 0;
+                    } else if (++idleCount < YIELD_COUNT) {
+                        sched_yield();
+                    } else {
+                        task->awaitCompletion();
+                    }
+                }
+            }
+
+            // 当前线程是本进程中某个ForkJoinPool的工作线程时返回它, 否则返回nullptr
+            static Worker *&currentWorker() {
+                static thread_local Worker *worker = nullptr;
+                return worker;
+            }
+
+        private:
+            void shutdown(int count) {
+                if (this->closed.compareAndSet(false, true)) {
+                    this->workAvailable.notifyAll();
+                    // 和ExecutorService一样, 最后一个外部引用可能在工作线程中被释放, 此时不能等待自己
+                    pthread_t self = pthread_self();
+                    int selfIndex = -1;
+                    for (int i = 0; i < count; i++) {
+                        if (pthread_equal(this->threads[i], self)) {
+                            selfIndex = i;
+                            break;
+                        }
+                    }
+                    this->semaphore->acquire(selfIndex == -1 ? count : count - 1);
+                    for (int i = 0; i < count; i++) {
+                        if (i == selfIndex) {
+                            pthread_detach(self);
+                        } else {
+                            pthread_join(this->threads[i], nullptr);
+                        }
+                    }
+                }
+            }
+
+            static void *threadProc(void *data) {
+                Worker *worker = reinterpret_cast<Worker*>(data);
+                SharedPool *pool = worker->pool;
+                defer([=]() {
+                    currentWorker() = nullptr;
+                    pool->semaphore->signal();
+                    pool->release();
+                });
+                currentWorker() = worker;
+                pool->threadRun(worker);
+                return nullptr;
+            }
+
+            void threadRun(Worker *worker) {
+                unsigned idleCount = 0;
+                while (true) {
+                    ForkJoinTask *task = worker->queue.pop();
+                    if (task == nullptr) {
+                        task = this->scan(worker);
+                    }
+                    if (task != nullptr) {
+                        runTask(task);
+                        idleCount = 0;
+                        continue;
+                    }
+                    if (++idleCount < YIELD_COUNT) {
+                        sched_yield();
+                        continue;
+                    }
+                    // 先登记为等待者再重新扫描, 与"先压入任务再检查等待者"的提交方构成Dekker式同步
+                    unsigned key = this->workAvailable.prepareWait();
+                    bool closed = this->closed;
+                    task = this->scan(worker);
+                    if (task != nullptr || closed) {
+                        this->workAvailable.cancelWait();
+                        if (task == nullptr) {
+                            return; //已关闭且所有队列都已为空
+                        }
+                        runTask(task);
+                        idleCount = 0;
+                        continue;
+                    }
+                    this->workAvailable.wait(key);
+                }
+            }
+
+            // 从随机选择的线程开始依次尝试窃取, 最后检查外部提交队列
+            ForkJoinTask *scan(Worker *worker) {
+                int count = (int)this->workers.size();
+                int start = (int)(worker->nextRandom() % count);
+                for (int i = 0; i < count; i++) {
+                    Worker *victim = this->workers[(start + i) % count].get();
+                    if (victim != worker && !victim->queue.isEmpty()) {
+                        ForkJoinTask *task = victim->queue.steal();
+                        if (task != nullptr) {
+                            this->stealCount.increment();
+                            return task;
+                        }
+                    }
+                }
+                if (this->submissionQueue->size() > 0) {
+                    vector<Ref<ForkJoinTask>> tasks;
+                    if (this->submissionQueue->drainTo(tasks, 1) == 1) {
+                        ForkJoinTask *task = tasks[0].get();
+                        task->retain();
+                        return task;
+                    }
+                }
+                return nullptr;
+            }
+
+            static void runTask(ForkJoinTask *task) {
+                task->doExec();
+                task->release(); //队列持有的引用
+            }
+
+        private:
+            static const unsigned YIELD_COUNT = 16;
+
+            vector<unique_ptr<Worker>> workers;
+            Ref<LinkedBlockingQueue<ForkJoinTask>> submissionQueue;
+            EventCount workAvailable;
+            LongAdder stealCount;
+            AtomicBoolean closed;
+            Ref<Semaphore> semaphore;
+            Arr<pthread_t> threads;
+        };
+
+    private:
+        Ref<SharedPool> sharedPool;
+        interface_refcount()
+
+        friend class ForkJoinTask;
+    };
+
+    inline void ForkJoinTask::fork() {
+        ForkJoinPool::Worker *worker = ForkJoinPool::SharedPool::currentWorker();
+        if (worker != nullptr) {
+            this->retain(); //由取出任务的线程释放
+            worker->pool->push(worker, this);
+        } else {
+            ForkJoinPool::commonPool()->sharedPool->submit(this);
+        }
+    }
+
+    inline void ForkJoinTask::awaitDone() {
+        if (!this->isDone()) {
+            ForkJoinPool::Worker *worker = ForkJoinPool::SharedPool::currentWorker();
+            if (worker != nullptr) {
+                worker->pool->helpJoin(worker, this);
+            } else {
+                while (!this->isDone()) {
+                    this->awaitCompletion();
+                }
+            }
+        }
+        if (this->isCompletedAbnormally()) {
+            throw_(this->exception);
+        }
+    }
+}
@@ -8,6 +8,10 @@
 #pragma once
 #include "Common.h"
 #include <functional>
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
+#include <new>
 
 namespace com_lanjing_cpp_common {
 
@@ -48,18 +52,23 @@ namespace com_lanjing_cpp_common {
 
         virtual void run() = 0;
 
-        static Ref<Runnable> of(function<void()> lambda) {
+        /*
+         * lambda可以是任何可调用对象(包括function<void()>), 它被直接存放在包装对象内部,
+         * 整个包装只需一次内存分配, 调用时也只经过一次虚函数, 不会再经过std::function的间接调用
+         */
+        template <typename F>
+        static Ref<Runnable> of(F &&lambda) {
             class Wrapper : extends Object, implements Runnable {
             public:
-                Wrapper(function<void()> lambda) : lambda(lambda) {}
+                Wrapper(F &&lambda) : lambda(forward<F>(lambda)) {}
                 virtual void run() override {
                     this->lambda();
                 }
             private:
-                function<void()> lambda;
+                typename decay<F>::type lambda;
                 interface_refcount()
             };
-            return new_<Wrapper>(lambda);
+            return new_<Wrapper>(forward<F>(lambda));
         }
 
         template <typename O>
@@ -136,18 +145,20 @@ namespace com_lanjing_cpp_common {
 
         virtual void accept(Args ...args) = 0;
 
-        static Ref<Consumer<Args...>> of(function<void(Args...)> lambda) {
+        // 和Runnable::of一样, lambda被直接存放在包装对象内部
+        template <typename F>
+        static Ref<Consumer<Args...>> of(F &&lambda) {
             class Wrapper : extends Object, implements Consumer<Args...> {
             public:
-                Wrapper(function<void(Args...)> lambda) : lambda(lambda) {}
+                Wrapper(F &&lambda) : lambda(forward<F>(lambda)) {}
                 virtual void accept(Args... args) override {
                     this->lambda(args...);
                 }
             private:
-                function<void(Args...)> lambda;
+                typename decay<F>::type lambda;
                 interface_refcount()
             };
-            return new_<Wrapper>(lambda);
+            return new_<Wrapper>(forward<F>(lambda));
         }
 
         template <typename O>
@@ -228,18 +239,20 @@ namespace com_lanjing_cpp_common {
 
         virtual T get() = 0;
 
-        static Ref<Supplier<T>> of(function<T()> lambda) {
+        // 和Runnable::of一样, lambda被直接存放在包装对象内部
+        template <typename F>
+        static Ref<Supplier<T>> of(F &&lambda) {
             class Wrapper : extends Object, implements Supplier<T> {
             public:
-                Wrapper(function<T()> lambda) : lambda(lambda) {}
+                Wrapper(F &&lambda) : lambda(forward<F>(lambda)) {}
                 virtual T get() override {
                     return this->lambda();
                 }
             private:
-                function<T()> lambda;
+                typename decay<F>::type lambda;
                 interface_refcount()
             };
-            return new_<Wrapper>(lambda);
+            return new_<Wrapper>(forward<F>(lambda));
         }
 
         template <typename O>
@@ -308,6 +321,13 @@ namespace com_lanjing_cpp_common {
         Ref<Function<R(Args...)>> &operator += (Ref<Function<R(Args...)>> right);
         Ref<Function<R(Args...)>> &operator -= (Ref<Function<R(Args...)>> right);
         R operator()(Args ...args) const;
+        // 运行时组合: 先调用自己再以结果调用after, 连续组合得到的是一段扁平的阶段列表而不是层层嵌套的包装;
+        // 编译期已知各阶段时请使用Functions::andThen以避免虚函数调用
+        template <typename V, typename X>
+        Ref<Function<V(Args...)>> andThen(Ref<Function<V(X)>> after) const;
+        // 运行时组合: 先调用before再以结果调用自己
+        template <typename B, typename ...T>
+        Ref<Function<R(T...)>> compose(Ref<Function<B(T...)>> before) const;
     private:
         typedef Function<R(Args...)> _SelfType;
     public:
@@ -322,18 +342,20 @@ namespace com_lanjing_cpp_common {
 
         virtual R apply(Args ...args) = 0;
 
-        static Ref<Function<R(Args...)>> of(function<R(Args...)> lambda) {
+        // 和Runnable::of一样, lambda被直接存放在包装对象内部
+        template <typename F>
+        static Ref<Function<R(Args...)>> of(F &&lambda) {
             class Wrapper : extends Object, implements Function<R(Args...)> {
             public:
-                Wrapper(function<R(Args...)> lambda) : lambda(lambda) {}
+                Wrapper(F &&lambda) : lambda(forward<F>(lambda)) {}
                 virtual R apply(Args... args) override {
                     return this->lambda(args...);
                 }
             private:
-                function<R(Args...)> lambda;
+                typename decay<F>::type lambda;
                 interface_refcount()
             };
-            return new_<Wrapper>(lambda);
+            return new_<Wrapper>(forward<F>(lambda));
         }
 
         template <typename O>
@@ -396,8 +418,203 @@ namespace com_lanjing_cpp_common {
     };
 
 
+    /**
+     * 编译期组合的函数: 先调用first, 再以其结果调用then
+     *
+     * 值类型, 整条流水线是一个具体的类型, 编译器可以把所有阶段内联为一次调用, 不经过任何虚函数;
+     * 只有需要类型擦除时, 才通过Function<R(Args...)>::of把整条流水线包装为一次虚函数调用
+     */
+    template <typename First, typename Then>
+    struct FunctionPipeline {
+        First first;
+        Then then;
+        template <typename ...A>
+        auto operator()(A &&...args) const -> decltype(declval<const Then&>()(declval<const First&>()(forward<A>(args)...))) {
+            return this->then(this->first(forward<A>(args)...));
+        }
+        template <typename G>
+        FunctionPipeline<FunctionPipeline<First, Then>, typename decay<G>::type> andThen(G &&after) const {
+            return { *this, forward<G>(after) };
+        }
+        template <typename G>
+        FunctionPipeline<typename decay<G>::type, FunctionPipeline<First, Then>> compose(G &&before) const {
+            return { forward<G>(before), *this };
+        }
+    };
+
+    /*
+     * 以下为运行时组合(Ref<Function<...>>::andThen/compose)的内部实现.
+     *
+     * 组合结果由一个源(接受原始参数的第一个函数)和一段连续的阶段列表组成, 每个阶段是一个单参数函数;
+     * 中间结果以各自的真实类型存放在调用栈上, 通过void*交给下一个阶段, 最后一个阶段把结果构造到调用者提供的存储中.
+     * 对已经是组合结果的函数再次组合时, 只复制并扩展其阶段列表, 不会把它作为一个整体再嵌套一层
+     */
+    abstract class _PipelineStage : extends Object {
+    public:
+        // input指向上一阶段的结果, 由本阶段消费; next == end时本阶段是最后一个, 把结果构造到result中
+        virtual void step(const Ref<_PipelineStage> *next, const Ref<_PipelineStage> *end, void *input, void *result) = 0;
+    };
+
+    // 一个阶段结果的存放和传递方式, 引用类型的结果以指针存放
+    template <typename T>
+    struct _PipelineValue {
+        typename aligned_storage<sizeof(T), alignof(T)>::type storage;
+        template <typename F>
+        static void produce(F &&compute, const Ref<_PipelineStage> *next, const Ref<_PipelineStage> *end, void *result) {
+            if (next == end) {
+                new (result) T(compute());
+            } else {
+                T value = compute();
+                next->get()->step(next + 1, end, &value, result);
+            }
+        }
+        T take() {
+            T *p = reinterpret_cast<T*>(&this->storage);
+            T value = move(*p);
+            p->~T();
+            return value;
+        }
+    };
+    template <typename T>
+    struct _PipelineValue<T&> {
+        T *storage;
+        template <typename F>
+        static void produce(F &&compute, const Ref<_PipelineStage> *next, const Ref<_PipelineStage> *end, void *result) {
+            T &value = compute();
+            if (next == end) {
+                *static_cast<T**>(result) = &value;
+            } else {
+                next->get()->step(next + 1, end, const_cast<void*>(static_cast<const void*>(&value)), result);
+            }
+        }
+        T &take() {
+            return *this->storage;
+        }
+    };
+
+    // 以In类型的上一阶段结果调用function, 并把结果转换为Out类型交给下一阶段
+    template <typename In, typename Out, typename R, typename ...X>
+    class _FunctionPipelineStage : extends _PipelineStage {
+    public:
+        _FunctionPipelineStage(Ref<Function<R(X...)>> function) : function(function) {}
+        virtual void step(const Ref<_PipelineStage> *next, const Ref<_PipelineStage> *end, void *input, void *result) override {
+            Function<R(X...)> *f = this->function.get();
+            In &&argument = static_cast<In&&>(*static_cast<typename remove_reference<In>::type*>(input));
+            _PipelineValue<Out>::produce([f, &argument]() -> Out {
+                return f->apply(static_cast<In&&>(argument));
+            }, next, end, result);
+        }
+    private:
+        Ref<Function<R(X...)>> function;
+    };
+
+    template <typename ...Args>
+    abstract class _PipelineSource : extends Object {
+    public:
+        virtual void start(const Ref<_PipelineStage> *begin, const Ref<_PipelineStage> *end, void *result, Args ...args) = 0;
+        // 把源函数转换为以其唯一参数为输入的阶段, 以便在它前面接上其他函数
+        virtual Ref<_PipelineStage> toStage() const = 0;
+    };
+
+    template <typename Out, typename R, typename ...Args>
+    class _FunctionPipelineSource : extends _PipelineSource<Args...> {
+    public:
+        _FunctionPipelineSource(Ref<Function<R(Args...)>> function) : function(function) {}
+        virtual void start(const Ref<_PipelineStage> *begin, const Ref<_PipelineStage> *end, void *result, Args ...args) override {
+            Function<R(Args...)> *f = this->function.get();
+            _PipelineValue<Out>::produce([&]() -> Out {
+                return f->apply(args...);
+            }, begin, end, result);
+        }
+        virtual Ref<_PipelineStage> toStage() const override {
+            return toStage(this->function);
+        }
+    private:
+        template <typename A>
+        static Ref<_PipelineStage> toStage(const Ref<Function<R(A)>> &function) {
+            return new_<_FunctionPipelineStage<A, Out, R, A>>(function);
+        }
+        // 源函数有多个参数时无法成为阶段, 不会被调用
+        template <typename F>
+        static Ref<_PipelineStage> toStage(const F &) {
+            return nullptr;
+        }
+        Ref<Function<R(Args...)>> function;
+    };
+
+    template <typename> class _ComposedFunction; //未定义
+
+    template <typename V, typename ...Args>
+    class _ComposedFunction<V(Args...)> : extends Object, implements Function<V(Args...)> {
+    public:
+        _ComposedFunction(Ref<_PipelineSource<Args...>> source, const vector<Ref<_PipelineStage>> &stages)
+            : source(source), stages(stages) {}
+        virtual V apply(Args ...args) override {
+            _PipelineValue<V> value;
+            const Ref<_PipelineStage> *begin = this->stages.data();
+            this->source.get()->start(begin, begin + this->stages.size(), &value.storage, args...);
+            return value.take();
+        }
+        // 以O(1)的typeid比较识别一个函数是否已经是组合结果
+        static _ComposedFunction<V(Args...)> *unwrap(const Ref<Function<V(Args...)>> &function) {
+            Function<V(Args...)> *p = function.get();
+            if (typeid(*p) == typeid(_ComposedFunction<V(Args...)>)) {
+                return static_cast<_ComposedFunction<V(Args...)>*>(dynamic_cast<void*>(p));
+            }
+            return nullptr;
+        }
+        const Ref<_PipelineSource<Args...>> source;
+        const vector<Ref<_PipelineStage>> stages;
+    private:
+        interface_refcount()
+    };
+
+    // 先调用first, 再以其结果调用then; 已经是组合结果的一方被展开到新的阶段列表中
+    template <typename R, typename ...Args, typename V, typename X>
+    Ref<Function<V(Args...)>> _composeFunctions(const Ref<Function<R(Args...)>> &first, const Ref<Function<V(X)>> &then) {
+        if (first == nullptr || then == nullptr) {
+            throw_new(NullPointerException, "Cannot compose nullptr functions");
+        }
+        _ComposedFunction<R(Args...)> *composedFirst = _ComposedFunction<R(Args...)>::unwrap(first);
+        // then的第一个阶段以X为输入, 只有first的结果恰好是X时才能直接展开
+        _ComposedFunction<V(X)> *composedThen = is_same<R, X>::value ? _ComposedFunction<V(X)>::unwrap(then) : nullptr;
+        Ref<_PipelineSource<Args...>> source;
+        vector<Ref<_PipelineStage>> stages;
+        stages.reserve(
+            (composedFirst != nullptr ? composedFirst->stages.size() : 0) +
+            (composedThen != nullptr ? composedThen->stages.size() + 1 : 1)
+        );
+        if (composedFirst != nullptr) {
+            source = composedFirst->source;
+            stages.insert(stages.end(), composedFirst->stages.begin(), composedFirst->stages.end());
+        } else {
+            source = new_<_FunctionPipelineSource<R, R, Args...>>(first);
+        }
+        if (composedThen != nullptr) {
+            stages.push_back(composedThen->source->toStage());
+            stages.insert(stages.end(), composedThen->stages.begin(), composedThen->stages.end());
+        } else {
+            stages.push_back(new_<_FunctionPipelineStage<R, V, V, X>>(then));
+        }
+        return new_<_ComposedFunction<V(Args...)>>(source, stages);
+    }
+
     struct Functions {
     public:
+        /*
+         * 编译期组合, 参数可以是lambda, 函数对象, 也可以是Ref<Function<...>>.
+         * 对于后者, 一次性组合出的流水线每个阶段恰好一次虚函数调用, 没有嵌套的组合对象
+         */
+        template <typename F, typename G>
+        static FunctionPipeline<typename decay<F>::type, typename decay<G>::type> andThen(F &&first, G &&then) {
+            return { forward<F>(first), forward<G>(then) };
+        }
+        // 等价于andThen(before, function)
+        template <typename F, typename G>
+        static FunctionPipeline<typename decay<G>::type, typename decay<F>::type> compose(F &&function, G &&before) {
+            return { forward<G>(before), forward<F>(function) };
+        }
+
         static Ref<Runnable> combine(Ref<Runnable> a, Ref<Runnable> b);
         static Ref<Runnable> remove(Ref<Runnable> a, Ref<Runnable> b);
 
@@ -419,223 +636,209 @@ namespace com_lanjing_cpp_common {
     private:
         Functions();
 
-        template <typename I>
+        /**
+         * 合并后的功能接口实例, 内部是一个扁平且不可变的调用列表
+         *
+         * "+"和"-"总是复制出一个新的调用列表(O(n)), 调用时只需顺序遍历一段连续的指针, 没有递归;
+         * C为具体的合并类型, 用于在O(1)时间内识别一个实例是否已经是合并实例, 从而将其展开.
+         * 调用列表使用std::vector而不是Array: Array是堆上的引用计数对象, 作为字段时每次调用都要多一次间接访问,
+         * 而调用列表创建后不再修改, 也从不暴露给调用者, 不需要Array的共享语义.
+         * 参见demo/functional/benchmark.cpp
+         */
+        template <typename I, typename C>
         abstract class AbstractCombinedInterface : extends Object, implements I {
         public:
-            static Ref<I> combine(
-                    function<Ref<AbstractCombinedInterface<I>>(Ref<I>, Ref<I>)> combinedInstanceFactory,
-                    Ref<I> a,
-                    Ref<I> b) {
+            static Ref<I> combine(Ref<I> a, Ref<I> b) {
                 if (a == nullptr) {
                     return b;
                 }
                 if (b == nullptr) {
                     return a;
                 }
-                return combinedInstanceFactory(a, b);
+                const Ref<I> *aBegin, *bBegin;
+                int aLength = invocationList(a, aBegin);
+                int bLength = invocationList(b, bBegin);
+                vector<Ref<I>> delegates;
+                delegates.reserve(aLength + bLength);
+                delegates.insert(delegates.end(), aBegin, aBegin + aLength);
+                delegates.insert(delegates.end(), bBegin, bBegin + bLength);
+                return new_internal(C, delegates);
             }
-            static Ref<I> remove(
-                    function<Ref<AbstractCombinedInterface<I>>(Ref<I>, Ref<I>)> combinedInstanceFactory,
-                    Ref<I> a,
-                    Ref<I> b) {
+            // 对于b中的每个原始实例, 从a的调用列表中剔除第一个与之相同的实例
+            static Ref<I> remove(Ref<I> a, Ref<I> b) {
                 if (a == nullptr) {
                     return nullptr;
                 }
                 if (b == nullptr) {
                     return a;
                 }
-                list<Ref<I>> removingInstances;
-                forEach(b, [&](Ref<I> instance){
-                    removingInstances.push_back(instance);
-                });
-                Ref<I> resultInstance = nullptr;
-                forEach(a, [&](Ref<I> instance){
-                    bool removed = false;
-                    for (auto
-                            itr = removingInstances.begin(),
-                            endItr = removingInstances.end();
-                            itr != endItr;
-                            itr++) {
-                        if (instance == *itr) {
-                            removingInstances.erase(itr);
-                            removed = true;
-                            break;
+                const Ref<I> *aBegin, *bBegin;
+                int aLength = invocationList(a, aBegin);
+                int bLength = invocationList(b, bBegin);
+                unordered_map<I*, int> removingCounts;
+                for (int i = 0; i < bLength; i++) {
+                    removingCounts[bBegin[i].get()]++;
+                }
+                vector<bool> removed(aLength, false);
+                int remaining = aLength;
+                for (int i = 0; i < aLength && !removingCounts.empty(); i++) {
+                    auto itr = removingCounts.find(aBegin[i].get());
+                    if (itr != removingCounts.end()) {
+                        if (--itr->second == 0) {
+                            removingCounts.erase(itr);
+                        }
+                        removed[i] = true;
+                        --remaining;
+                    }
+                }
+                if (remaining == aLength) {
+                    return a;
+                }
+                if (remaining == 0) {
+                    return nullptr;
+                }
+                if (remaining == 1) {
+                    for (int i = 0; i < aLength; i++) {
+                        if (!removed[i]) {
+                            return aBegin[i];
                         }
                     }
-                    if (!removed) {
-                        resultInstance = combine(combinedInstanceFactory, resultInstance, instance);
+                }
+                vector<Ref<I>> delegates;
+                delegates.reserve(remaining);
+                for (int i = 0; i < aLength; i++) {
+                    if (!removed[i]) {
+                        delegates.push_back(aBegin[i]);
                     }
-                });
-                return resultInstance;
+                }
+                return new_internal(C, delegates);
             }
         protected:
-            AbstractCombinedInterface(Ref<I> self, Ref<I> next)
-                : self(self), next(next) {
-                if (self == nullptr) {
-                    throw_new(IllegalArgumentException, "self cannot be null");
+            AbstractCombinedInterface(const vector<Ref<I>> &delegates) : delegates(delegates) {
+                if (this->delegates.size() < 2) {
+                    throw_new(IllegalArgumentException, "delegates must contain at least two elements");
                 }
-                if (next == nullptr) {
-                    throw_new(IllegalArgumentException, "next cannot be null");
+            }
+            template <typename F>
+            void forEachDelegate(F invoker) {
+                // 调用过程中某个原始实例可能通过"-="把自己从宿主中移除, 从而导致当前合并实例被释放
+                Ref<AbstractCombinedInterface<I, C>> keepAlive = this;
+                const Ref<I> *p = this->delegates.data();
+                const Ref<I> *end = p + this->delegates.size();
+                for (; p != end; ++p) {
+                    invoker(p->get());
                 }
             }
+            const vector<Ref<I>> delegates;
         private:
-            static void forEach(Ref<I> instance, function<void(Ref<I>)> consumer) {
-
-                Ref<AbstractCombinedInterface<I>> combinedInstance =
-                        dynamic_cast<AbstractCombinedInterface<I>*>(instance.get());
-                // Why does "instance.dynamicCast<AbstractCombinedInterface<I>>()" report error?
-
-                if (combinedInstance != nullptr) {
-                    forEach(combinedInstance->self, consumer);
-                    forEach(combinedInstance->next, consumer);
-                } else if (instance != nullptr) {
-                    consumer(instance);
+            static int invocationList(Ref<I> &instance, const Ref<I> *&begin) {
+                I *p = instance.get();
+                if (typeid(*p) == typeid(C)) {
+                    // 类型已确定为C, dynamic_cast<void*>只需从虚表读取到完整对象的偏移, 无需搜索继承体系
+                    const vector<Ref<I>> &delegates = static_cast<C*>(dynamic_cast<void*>(p))->delegates;
+                    begin = delegates.data();
+                    return (int)delegates.size();
                 }
+                begin = &instance;
+                return 1;
             }
-        protected:
-            Ref<I> self;
-            Ref<I> next;
             interface_refcount()
         };
 
-        class CombinedRunnable : extends AbstractCombinedInterface<Runnable> {
+        class CombinedRunnable : extends AbstractCombinedInterface<Runnable, CombinedRunnable> {
         public:
-            CombinedRunnable(Ref<Runnable> a, Ref<Runnable> b)
-                    : AbstractCombinedInterface<Runnable>(a, b) {}
+            CombinedRunnable(const vector<Ref<Runnable>> &delegates)
+                    : AbstractCombinedInterface<Runnable, CombinedRunnable>(delegates) {}
             virtual void run() override {
-                this->self->run();
-                this->next->run();
+                this->forEachDelegate([](Runnable *delegate) {
+                    delegate->run();
+                });
             }
         };
 
         template <typename ...Args>
-        class CombinedConsumer : extends AbstractCombinedInterface<Consumer<Args...>> {
+        class CombinedConsumer : extends AbstractCombinedInterface<Consumer<Args...>, CombinedConsumer<Args...>> {
         public:
-            CombinedConsumer(Ref<Consumer<Args...>> a, Ref<Consumer<Args...>> b)
-                    : AbstractCombinedInterface<Consumer<Args...>>(a, b) {}
+            CombinedConsumer(const vector<Ref<Consumer<Args...>>> &delegates)
+                    : AbstractCombinedInterface<Consumer<Args...>, CombinedConsumer<Args...>>(delegates) {}
             virtual void accept(Args ...args) override {
-                this->self->accept(args...);
-                this->next->accept(args...);
+                this->forEachDelegate([&](Consumer<Args...> *delegate) {
+                    delegate->accept(args...);
+                });
             }
         };
 
         template <typename T>
-        class CombinedSupplier : extends AbstractCombinedInterface<Supplier<T>> {
+        class CombinedSupplier : extends AbstractCombinedInterface<Supplier<T>, CombinedSupplier<T>> {
         public:
-            CombinedSupplier(Ref<Supplier<T>> a, Ref<Supplier<T>> b)
-                    : AbstractCombinedInterface<Supplier<T>>(a, b) {}
+            CombinedSupplier(const vector<Ref<Supplier<T>>> &delegates)
+                    : AbstractCombinedInterface<Supplier<T>, CombinedSupplier<T>>(delegates) {}
             virtual T get() override {
-                this->self->get();
-                return this->next->get();
+                Ref<CombinedSupplier<T>> keepAlive = this;
+                const Ref<Supplier<T>> *p = this->delegates.data();
+                const Ref<Supplier<T>> *last = p + this->delegates.size() - 1;
+                for (; p != last; ++p) {
+                    p->get()->get();
+                }
+                return last->get()->get();
             }
         };
 
         template <typename> class CombinedFunction; //未定义
 
         template <typename R, typename ...Args>
-        class CombinedFunction<R(Args...)> : extends AbstractCombinedInterface<Function<R(Args...)>> {
+        class CombinedFunction<R(Args...)> : extends AbstractCombinedInterface<Function<R(Args...)>, CombinedFunction<R(Args...)>> {
         public:
-            CombinedFunction(Ref<Function<R(Args...)>> a, Ref<Function<R(Args...)>> b)
-                    : AbstractCombinedInterface<Function<R(Args...)>>(a, b) {}
+            CombinedFunction(const vector<Ref<Function<R(Args...)>>> &delegates)
+                    : AbstractCombinedInterface<Function<R(Args...)>, CombinedFunction<R(Args...)>>(delegates) {}
             virtual R apply(Args ...args) override {
-                this->self->apply(args...);
-                return this->next->apply(args...);
+                Ref<CombinedFunction<R(Args...)>> keepAlive = this;
+                const Ref<Function<R(Args...)>> *p = this->delegates.data();
+                const Ref<Function<R(Args...)>> *last = p + this->delegates.size() - 1;
+                for (; p != last; ++p) {
+                    p->get()->apply(args...);
+                }
+                return last->get()->apply(args...);
             }
         };
     };
 
     inline Ref<Runnable> Functions::combine(Ref<Runnable> a, Ref<Runnable> b) {
-        return CombinedRunnable::combine(
-                [&](Ref<Runnable> a, Ref<Runnable> b) {
-                    return new_internal(CombinedRunnable, a, b);
-                },
-                a,
-                b
-        );
+        return CombinedRunnable::combine(a, b);
     }
 
     inline Ref<Runnable> Functions::remove(Ref<Runnable> a, Ref<Runnable> b) {
-        return CombinedRunnable::remove(
-                [&](Ref<Runnable> a, Ref<Runnable> b) {
-                    return new_internal(CombinedRunnable, a, b);
-                },
-                a,
-                b
-        );
+        return CombinedRunnable::remove(a, b);
     }
 
     template <typename ...Args>
     Ref<Consumer<Args...>> Functions::combine(Ref<Consumer<Args...>> a, Ref<Consumer<Args...>> b) {
-        return CombinedConsumer<Args...>::combine(
-                [&](Ref<Consumer<Args...>> a, Ref<Consumer<Args...>> b) {
-                    return new_internal(CombinedConsumer<Args...>, a, b);
-                },
-                a,
-                b
-        );
+        return CombinedConsumer<Args...>::combine(a, b);
     }
 
     template <typename ...Args>
     Ref<Consumer<Args...>> Functions::remove(Ref<Consumer<Args...>> a, Ref<Consumer<Args...>> b) {
-        return CombinedConsumer<Args...>::remove(
-                [&](Ref<Consumer<Args...>> a, Ref<Consumer<Args...>> b) {
-                    return new_internal(CombinedConsumer<Args...>, a, b);
-                },
-                a,
-                b
-        );
+        return CombinedConsumer<Args...>::remove(a, b);
     }
 
     template <typename T>
     Ref<Supplier<T>> Functions::combine(Ref<Supplier<T>> a, Ref<Supplier<T>> b) {
-        return CombinedSupplier<T>::combine(
-                [&](Ref<Supplier<T>> a, Ref<Supplier<T>> b) {
-                    return newInternalObject<CombinedSupplier<T>>([=](void *address){
-                        new(address) CombinedSupplier<T>(a, b);
-                    });
-                },
-                a,
-                b
-        );
+        return CombinedSupplier<T>::combine(a, b);
     }
 
     template <typename T>
     Ref<Supplier<T>> Functions::remove(Ref<Supplier<T>> a, Ref<Supplier<T>> b) {
-        return CombinedSupplier<T>::remove(
-                [&](Ref<Supplier<T>> a, Ref<Supplier<T>> b) {
-                    return newInternalObject<CombinedSupplier<T>>([=](void *address){
-                        new(address) CombinedSupplier<T>(a, b);
-                    });
-                },
-                a,
-                b
-        );
+        return CombinedSupplier<T>::remove(a, b);
     }
 
     template <typename R, typename ...Args>
     Ref<Function<R(Args...)>> Functions::combine(Ref<Function<R(Args...)>> a, Ref<Function<R(Args...)>> b) {
-        return CombinedFunction<R(Args...)>::combine(
-                [&](Ref<Function<R(Args...)>> a, Ref<Function<R(Args...)>> b) {
-                    return newInternalObject<CombinedFunction<R(Args...)>>([=](void *address){
-                        new(address) CombinedFunction<R(Args...)>(a, b);
-                    });
-                },
-                a,
-                b
-        );
+        return CombinedFunction<R(Args...)>::combine(a, b);
     }
 
     template <typename R, typename ...Args>
     Ref<Function<R(Args...)>> Functions::remove(Ref<Function<R(Args...)>> a, Ref<Function<R(Args...)>> b) {
-        return CombinedFunction<R(Args...)>::remove(
-                [&](Ref<Function<R(Args...)>> a, Ref<Function<R(Args...)>> b) {
-                    return newInternalObject<CombinedFunction<R(Args...)>>([=](void *address){
-                        new(address) CombinedFunction<R(Args...)>(a, b);
-                    });
-                },
-                a,
-                b
-        );
+        return CombinedFunction<R(Args...)>::remove(a, b);
     }
 
     inline Ref<Runnable>& Ref<Runnable>::operator += (Ref<Runnable> right) {
@@ -709,6 +912,16 @@ namespace com_lanjing_cpp_common {
         return this->get()->apply(args...);
     }
     template <typename R, typename ...Args>
+    template <typename V, typename X>
+    Ref<Function<V(Args...)>> Ref<Function<R(Args...)>>::andThen(Ref<Function<V(X)>> after) const {
+        return _composeFunctions(*this, after);
+    }
+    template <typename R, typename ...Args>
+    template <typename B, typename ...T>
+    Ref<Function<R(T...)>> Ref<Function<R(Args...)>>::compose(Ref<Function<B(T...)>> before) const {
+        return _composeFunctions(before, *this);
+    }
+    template <typename R, typename ...Args>
     Ref<Function<R(Args...)>> operator + (Ref<Function<R(Args...)>> a, Ref<Function<R(Args...)>> b) {
         return Functions::combine(a, b);
     }
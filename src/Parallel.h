@@ -0,0 +1,240 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "ExecutorService.h"
+#include "ForkJoinPool.h"
+#include <sched.h>
+#include <vector>
+
+namespace com_lanjing_cpp_common {
+
+    /**
+     * 类似OpenMP的并行循环, 不需要编译器支持.
+     *
+     * 下标区间[begin, end)被动态地切分为块: 每个参与者用一次CAS领取"剩余数量 / (2 * 参与者数)"个下标
+     * (至少grain个), 先领取的块较大, 越接近结束块越小(即OpenMP的guided调度), 执行快的线程自然会领取更多的块.
+     * 调用者线程本身也参与执行, 其余参与者是提交给线程池(默认为ForkJoinPool::commonPool())的任务;
+     * 线程池繁忙时这些任务可能在所有块都已被领取之后才开始执行, 此时它们直接返回, 调用者不会等待它们.
+     * 所以在线程池的工作线程中嵌套调用也不会死锁.
+     *
+     * body是模板参数, 在循环内被内联调用, 每个下标没有虚函数调用和内存分配.
+     * 某个下标抛出异常后, 尚未开始的块被跳过, 所有正在执行的块结束后在调用者线程中重新抛出第一个异常
+     */
+    struct Parallel {
+    public:
+        // body(int64_t index)
+        template <typename F>
+        static void forEach(int64_t begin, int64_t end, F &&body, int64_t grain = 1) {
+            forEach(ForkJoinPool::commonPool(), begin, end, forward<F>(body), grain);
+        }
+
+        template <typename E, typename F>
+        static void forEach(Ref<E> executor, int64_t begin, int64_t end, F &&body, int64_t grain = 1) {
+            run(executor.get(), begin, end, grain, [&body](int, int64_t from, int64_t to) {
+                for (int64_t i = from; i < to; i++) {
+                    body(i);
+                }
+            });
+        }
+
+        // body(T &element), 适合对大数组逐元素变换
+        template <typename T, typename F>
+        static void forEach(Arr<T> array, F &&body, int64_t grain = 1) {
+            forEach(ForkJoinPool::commonPool(), array, forward<F>(body), grain);
+        }
+
+        template <typename E, typename T, typename F>
+        static void forEach(Ref<E> executor, Arr<T> array, F &&body, int64_t grain = 1) {
+            T *data = array.unsafe();
+            run(executor.get(), 0, array.length(), grain, [&body, data](int, int64_t from, int64_t to) {
+                for (int64_t i = from; i < to; i++) {
+                    body(data[i]);
+                }
+            });
+        }
+
+        /*
+         * 计算combine(...combine(combine(identity, map(begin)), map(begin + 1))..., map(end - 1)).
+         * combine必须满足结合律, identity必须是它的单位元; 由于块是动态分配的, 浮点数求和的结果可能有舍入上的差异
+         */
+        template <typename T, typename M, typename C>
+        static T reduce(int64_t begin, int64_t end, const T &identity, M &&map, C &&combine, int64_t grain = 1) {
+            return reduce(ForkJoinPool::commonPool(), begin, end, identity, forward<M>(map), forward<C>(combine), grain);
+        }
+
+        template <typename E, typename T, typename M, typename C>
+        static T reduce(Ref<E> executor, int64_t begin, int64_t end, const T &identity, M &&map, C &&combine, int64_t grain = 1) {
+            // 每个参与者只累加到自己的槽中(已按缓存行填充), 结束后由调用者依次合并, 不需要任何锁
+            vector<Partial<T>> partials(maxParticipants(executor.get(), begin, end, grain), Partial<T>(identity));
+            run(executor.get(), begin, end, grain, [&](int participant, int64_t from, int64_t to) {
+                T value = identity;
+                for (int64_t i = from; i < to; i++) {
+                    value = combine(value, map(i));
+                }
+                T &partial = partials[participant].value;
+                partial = combine(partial, value);
+            });
+            T result = identity;
+            for (Partial<T> &partial : partials) {
+                result = combine(result, partial.value);
+            }
+            return result;
+        }
+
+        // 并行执行所有任务, 全部结束后返回
+        static void invokeAll(const vector<Ref<Runnable>> &tasks) {
+            invokeAll(ForkJoinPool::commonPool(), tasks);
+        }
+
+        template <typename E>
+        static void invokeAll(Ref<E> executor, const vector<Ref<Runnable>> &tasks) {
+            forEach(executor, 0, (int64_t)tasks.size(), [&tasks](int64_t i) {
+                tasks[i]();
+            });
+        }
+
+    private:
+        static const unsigned YIELD_COUNT = 16;
+
+        template <typename T>
+        struct Partial {
+            Partial(const T &value) : value(value) {}
+            T value;
+            char padding[64]; //避免相邻参与者的槽位于同一缓存行
+        };
+
+        static int parallelismOf(ForkJoinPool *pool) {
+            return pool->getParallelism();
+        }
+
+        static int parallelismOf(ExecutorService *executorService) {
+            return executorService->getPoolSize();
+        }
+
+        static int parallelismOf(Executor *) {
+            return ForkJoinPool::defaultParallelism();
+        }
+
+        // 调用者加上提交给线程池的参与者, 块数不足时不提交多余的任务
+        template <typename E>
+        static int maxParticipants(E *executor, int64_t begin, int64_t end, int64_t grain) {
+            if (executor == nullptr) {
+                throw_new(IllegalArgumentException, "executor cannot be null");
+            }
+            if (grain < 1) {
+                throw_new(IllegalArgumentException, "grain cannot be less than 1");
+            }
+            int64_t chunkCount = end > begin ? (end - begin + grain - 1) / grain : 0;
+            return (int)max(min((int64_t)parallelismOf(executor) + 1, chunkCount), (int64_t)1);
+        }
+
+        // 一次并行循环的共享状态, 被迟到的参与者任务引用, 所以分配在堆上; chunkBody只在还有块可领取时被访问
+        template <typename F>
+        class Loop : extends Object {
+        public:
+            Loop(int64_t begin, int64_t end, int64_t grain, int participantCount, F *chunkBody) :
+                next(begin),
+                end(end),
+                grain(grain),
+                participantCount(participantCount),
+                remaining(end - begin),
+                chunkBody(chunkBody) {}
+            virtual ~Loop() {}
+
+            void participate(int participant) {
+                while (true) {
+                    int64_t from = this->next.load(memory_order_relaxed);
+                    int64_t size;
+                    do {
+                        if (from >= this->end) {
+                            return;
+                        }
+                        size = min(max(this->grain, (this->end - from) / (2 * this->participantCount)), this->end - from);
+                    } while (!this->next.compare_exchange_weak(from, from + size, memory_order_relaxed));
+                    if (!this->failed) {
+                        try_ {
+                            (*this->chunkBody)(participant, from, from + size);
+                        } catch_(Exception, ex) {
+                            if (this->failed.compareAndSet(false, true)) {
+                                this->exception = ex;
+                            }
+                        } end_try
+                    }
+                    // 最后一块完成时唤醒调用者, 之后不能再访问chunkBody
+                    if (this->remaining.fetch_sub(size) == size) {
+                        this->completion.notifyAll();
+                    }
+                }
+            }
+
+            // 由调用者在自己领取不到块之后调用, 等待其他参与者手中的块全部完成
+            void await() {
+                for (unsigned spinCount = 0; this->remaining.load() != 0; spinCount++) {
+                    if (spinCount < YIELD_COUNT) {
+                        sched_yield();
+                        continue;
+                    }
+                    unsigned key = this->completion.prepareWait();
+                    if (this->remaining.load() == 0) {
+                        this->completion.cancelWait();
+                        break;
+                    }
+                    this->completion.wait(key);
+                }
+                if (this->exception != nullptr) {
+                    throw_(this->exception);
+                }
+            }
+
+        private:
+            atomic<int64_t> next;
+            const int64_t end;
+            const int64_t grain;
+            const int64_t participantCount;
+            atomic<int64_t> remaining; //尚未完成的下标数
+            F *chunkBody;
+            AtomicBoolean failed;
+            Ref<Exception> exception;
+            EventCount completion;
+        };
+
+        // chunkBody(int participant, int64_t from, int64_t to), participant在[0, 参与者数)之间, 调用者为0
+        template <typename E, typename F>
+        static void run(E *executor, int64_t begin, int64_t end, int64_t grain, F &&chunkBody) {
+            int participantCount = maxParticipants(executor, begin, end, grain);
+            if (end <= begin) {
+                return;
+            }
+            if (participantCount == 1) {
+                chunkBody(0, begin, end);
+                return;
+            }
+            typedef typename remove_reference<F>::type Body;
+            Ref<Loop<Body>> loop = new_<Loop<Body>>(begin, end, grain, participantCount, &chunkBody);
+            // 已提交的参与者引用着栈上的chunkBody, 所以提交失败(例如线程池拒绝或已关闭)时也必须先由调用者
+            // 完成剩余的块并等待它们结束, 然后才能抛出异常
+            Ref<Exception> submitException;
+            for (int participant = 1; participant < participantCount; participant++) {
+                try_ {
+                    executor->execute(Runnable::of([loop, participant] {
+                        loop->participate(participant);
+                    }));
+                } catch_(Exception, ex) {
+                    submitException = ex;
+                    break;
+                } end_try
+            }
+            loop->participate(0);
+            loop->await();
+            if (submitException != nullptr) {
+                throw_(submitException);
+            }
+        }
+    };
+}
@@ -0,0 +1,337 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+/**
+ * 安全内存回收, 无锁数据结构的基础设施
+ *
+ * 无锁数据结构的读者总是先原子地读到一个原始指针, 再去访问它(或对它执行retain);
+ * 如果此时另外一个线程恰好release掉了最后一个引用, 读者就会访问到已被析构的对象.
+ * 本文件提供两种互补的保护手段:
+ *
+ * 1、危险指针(Reclamation::HazardPointer): 精确保护单个指针, 适合只访问少数几个节点的操作
+ * 2、纪元(Reclamation::EpochGuard): 一次进入临界区即可保护整个遍历过程中读到的所有指针, 适合批量遍历
+ *
+ * 写者一方有两种延迟回收方式:
+ *
+ * 1、Reclamation::deferRelease(target): 推迟对target执行一次release, AtomicRef用它处理被替换下来的旧引用
+ * 2、从Reclaimable派生的对象在引用计数耗尽时不会立即finalize和析构,
+ *    而是自动交由本子系统推迟到所有读者都已离开(既无危险指针指向它, 所有线程也都已越过其退役纪元)之后
+ *
+ * 读者拿到Reclaimable对象的原始指针后若想长期持有, 应当使用Object::tryRetain,
+ * 因为该对象的引用计数可能已经耗尽, 只是尚未被回收
+ *
+ * @author 陈涛
+ */
+
+#include "Common.h"
+#include <vector>
+#include <unordered_set>
+#include <type_traits>
+
+namespace com_lanjing_cpp_common {
+
+    using namespace std;
+
+    struct Reclamation {
+    public:
+        // 每个线程可以同时持有的危险指针数量
+        static const int HAZARD_POINTERS_PER_THREAD = 4;
+
+        /**
+         * 危险指针, 值类型, 只能作为局部变量使用
+         *
+         *     Reclamation::HazardPointer hp;
+         *     Node *node = hp.protect(this->head); //此后node不会被回收, 直到hp被reset或析构
+         */
+        struct HazardPointer {
+        public:
+            HazardPointer() : slot(localContext().acquireSlot()) {}
+            ~HazardPointer() {
+                this->slot->store(nullptr, memory_order_release);
+                localContext().releaseSlot(this->slot);
+            }
+            template <typename T>
+            T *protect(const atomic<T*> &source) {
+                T *p = source.load();
+                while (true) {
+                    this->slot->store(keyOf(p)); //seq_cst, 和回收之前的扫描构成Dekker式同步
+                    T *again = source.load();
+                    if (again == p) {
+                        return p;
+                    }
+                    p = again;
+                }
+            }
+            void reset() {
+                this->slot->store(nullptr, memory_order_release);
+            }
+            HazardPointer(const HazardPointer &) = delete;
+            HazardPointer &operator = (const HazardPointer &) = delete;
+        private:
+            atomic<const void*> *slot;
+        };
+
+        /**
+         * 纪元临界区, 值类型, 只能作为局部变量使用, 可以嵌套
+         *
+         * 在其生命周期内读到的任何Reclaimable对象或被retire的引用都不会被回收
+         */
+        struct EpochGuard {
+        public:
+            EpochGuard() {
+                localContext().enterEpoch();
+            }
+            ~EpochGuard() {
+                localContext().leaveEpoch();
+            }
+            EpochGuard(const EpochGuard &) = delete;
+            EpochGuard &operator = (const EpochGuard &) = delete;
+        };
+
+        // 推迟对target执行一次release, 直到没有读者能够再通过原始指针访问到它
+        template <typename T>
+        static void deferRelease(T *target) {
+            if (target != nullptr) {
+                localContext().retire(Retired { keyOf(target), target, nullptr, 0 });
+            }
+        }
+
+        // 推迟finalize并析构一个引用计数已经耗尽的对象, 通常由Reclaimable自动调用
+        static void retire(Object *object) {
+            if (object != nullptr) {
+                localContext().retire(Retired { object, nullptr, object, 0 });
+            }
+        }
+
+        // 尽力回收当前线程已退役的所有对象, 被任何线程保护的对象仍会保留
+        static void flush() {
+            LocalContext &context = localContext();
+            for (int i = 0; i < 3; i++) {
+                context.collect();
+            }
+        }
+
+    private:
+        static const uint64_t ACTIVE = 1;
+
+        // 危险指针和退役记录统一以Object*的地址作为键, 以免多重继承下同一对象的不同指针值互不相等
+        template <typename T>
+        static const void *keyOf(T *p) {
+            return keyOf(p, is_base_of<Object, T>());
+        }
+        template <typename T>
+        static const void *keyOf(T *p, true_type) {
+            return static_cast<const Object*>(p);
+        }
+        template <typename T>
+        static const void *keyOf(T *p, false_type) {
+            return p;
+        }
+
+        struct Record {
+            atomic<const void*> hazards[HAZARD_POINTERS_PER_THREAD];
+            atomic<uint64_t> epoch; //低位为ACTIVE标志, 其余为该线程进入临界区时观察到的全局纪元
+            AtomicBoolean inUse;
+            Record *next;
+        };
+        struct Retired {
+            const void *key;
+            Interface *reference; //需要release的引用
+            Object *object; //需要finalize并析构的对象
+            uint64_t epoch;
+        };
+
+        struct Domain {
+            atomic<Record*> head;
+            atomic<int> recordCount;
+            atomic<uint64_t> epoch;
+            Mutex orphanMutex;
+            vector<Retired> orphans;
+            AtomicBoolean hasOrphans;
+            Domain() : head(nullptr), recordCount(0), epoch(0) {}
+
+            // 只有当所有处于临界区中的线程都已观察到当前纪元时, 全局纪元才能前进
+            uint64_t tryAdvance() {
+                uint64_t current = this->epoch.load();
+                for (Record *r = this->head.load(); r != nullptr; r = r->next) {
+                    uint64_t local = r->epoch.load();
+                    if ((local & ACTIVE) != 0 && (local >> 1) != current) {
+                        return current;
+                    }
+                }
+                this->epoch.compare_exchange_strong(current, current + 1);
+                return this->epoch.load();
+            }
+        };
+        // 故意不析构, 以免进程退出时和各线程的thread_local析构顺序纠缠不清
+        static Domain &domain() {
+            static Domain *instance = new Domain();
+            return *instance;
+        }
+
+        struct LocalContext {
+        public:
+            LocalContext() : record(nullptr), usedSlots(0), epochDepth(0), closed(false) {}
+            ~LocalContext() {
+                for (int i = 0; i < 3 && !this->retiredList.empty(); i++) {
+                    this->collect();
+                }
+                this->closed = true;
+                this->orphan(this->retiredList);
+                if (this->record != nullptr) {
+                    for (int i = 0; i < HAZARD_POINTERS_PER_THREAD; i++) {
+                        this->record->hazards[i].store(nullptr);
+                    }
+                    this->record->epoch.store(0);
+                    this->record->inUse.store(false);
+                }
+            }
+            atomic<const void*> *acquireSlot() {
+                Record *r = this->ownRecord();
+                for (int i = 0; i < HAZARD_POINTERS_PER_THREAD; i++) {
+                    if ((this->usedSlots & (1 << i)) == 0) {
+                        this->usedSlots |= 1 << i;
+                        return &r->hazards[i];
+                    }
+                }
+                throw_new(IllegalStateException, "Too many hazard pointers are held by the current thread");
+            }
+            void releaseSlot(atomic<const void*> *slot) {
+                this->usedSlots &= ~(1 << (int)(slot - this->record->hazards));
+            }
+            void enterEpoch() {
+                if (this->epochDepth++ == 0) {
+                    Record *r = this->ownRecord();
+                    Domain &d = domain();
+                    uint64_t epoch = d.epoch.load();
+                    while (true) {
+                        r->epoch.store((epoch << 1) | ACTIVE); //seq_cst, 发布之后必须再次确认全局纪元
+                        uint64_t again = d.epoch.load();
+                        if (again == epoch) {
+                            break;
+                        }
+                        epoch = again;
+                    }
+                }
+            }
+            void leaveEpoch() {
+                if (--this->epochDepth == 0) {
+                    this->record->epoch.store(0, memory_order_release);
+                }
+            }
+            void retire(Retired retired) {
+                retired.epoch = domain().epoch.load();
+                if (this->closed) { //线程退出阶段(如pthread_key析构函数中)仍可能有对象被退役, 交给其他线程回收
+                    vector<Retired> single(1, retired);
+                    this->orphan(single);
+                    return;
+                }
+                this->retiredList.push_back(retired);
+                int threshold = 2 * HAZARD_POINTERS_PER_THREAD * domain().recordCount.load(memory_order_relaxed) + 64;
+                if ((int)this->retiredList.size() >= threshold) {
+                    this->collect();
+                }
+            }
+            void collect() {
+                Domain &d = domain();
+                if (d.hasOrphans && d.hasOrphans.compareAndSet(true, false)) {
+                    Mutex::Scope scope(d.orphanMutex);
+                    this->retiredList.insert(this->retiredList.end(), d.orphans.begin(), d.orphans.end());
+                    d.orphans.clear();
+                }
+                if (this->retiredList.empty()) {
+                    return;
+                }
+                uint64_t epoch = d.tryAdvance();
+                unordered_set<const void*> hazards;
+                for (Record *r = d.head.load(); r != nullptr; r = r->next) {
+                    for (int i = 0; i < HAZARD_POINTERS_PER_THREAD; i++) {
+                        const void *hazard = r->hazards[i].load(); //seq_cst
+                        if (hazard != nullptr) {
+                            hazards.insert(hazard);
+                        }
+                    }
+                }
+                vector<Retired> reclaimable;
+                size_t kept = 0;
+                for (size_t i = 0; i < this->retiredList.size(); i++) {
+                    Retired &retired = this->retiredList[i];
+                    if (retired.epoch + 2 > epoch || hazards.find(retired.key) != hazards.end()) {
+                        this->retiredList[kept++] = retired;
+                    } else {
+                        reclaimable.push_back(retired);
+                    }
+                }
+                this->retiredList.resize(kept);
+                // 回收可能触发finalize并再次retire, 所以必须在整理完retiredList之后执行
+                for (Retired &retired : reclaimable) {
+                    if (retired.reference != nullptr) {
+                        retired.reference->release();
+                    } else {
+                        retired.object->finalizeAndDelete();
+                    }
+                }
+            }
+        private:
+            static void orphan(vector<Retired> &retiredList) {
+                if (!retiredList.empty()) {
+                    Domain &d = domain();
+                    Mutex::Scope scope(d.orphanMutex);
+                    d.orphans.insert(d.orphans.end(), retiredList.begin(), retiredList.end());
+                    d.hasOrphans.store(true);
+                    retiredList.clear();
+                }
+            }
+            Record *ownRecord() {
+                if (this->record == nullptr) {
+                    Domain &d = domain();
+                    for (Record *r = d.head.load(); r != nullptr; r = r->next) {
+                        if (!r->inUse && r->inUse.compareAndSet(false, true)) {
+                            this->record = r;
+                            return r;
+                        }
+                    }
+                    Record *r = new Record();
+                    for (int i = 0; i < HAZARD_POINTERS_PER_THREAD; i++) {
+                        r->hazards[i].store(nullptr);
+                    }
+                    r->epoch.store(0);
+                    r->inUse.store(true);
+                    r->next = d.head.load();
+                    while (!d.head.compare_exchange_weak(r->next, r));
+                    ++d.recordCount;
+                    this->record = r;
+                }
+                return this->record;
+            }
+            Record *record;
+            int usedSlots;
+            int epochDepth;
+            bool closed;
+            vector<Retired> retiredList;
+        };
+        static LocalContext &localContext() {
+            static thread_local LocalContext instance;
+            return instance;
+        }
+
+        Reclamation();
+    };
+
+    /**
+     * 引用计数耗尽后不立即finalize和析构, 而是交由Reclamation推迟到所有读者都已离开之后.
+     * 无锁数据结构的节点应从此类派生
+     */
+    abstract class Reclaimable : extends Object {
+    protected:
+        virtual void reclaim() override {
+            Reclamation::retire(this);
+        }
+    };
+}
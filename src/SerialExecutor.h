@@ -0,0 +1,221 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "ExecutorService.h"
+
+namespace com_lanjing_cpp_common {
+
+    using namespace std;
+
+    /**
+     * 多生产者单消费者的无界链表队列(Vyukov MPSC), 不是BlockingQueue, 供SerialExecutor内部使用.
+     *
+     * push只有一次atomic exchange和一次store, 是wait-free的; pop只允许一个线程调用(同一时刻).
+     * 生产者已exchange但尚未链接节点的短暂窗口内, pop会返回false, 调用者需另行保证之后还会再次pop
+     */
+    template <typename E>
+    class _MpscQueue {
+    public:
+        _MpscQueue() : head(&stub), tail(&stub) {}
+        _MpscQueue(const _MpscQueue &) = delete;
+        _MpscQueue &operator = (const _MpscQueue &) = delete;
+        ~_MpscQueue() {
+            E element;
+            while (this->pop(element));
+            if (this->tail != &this->stub) {
+                delete this->tail;
+            }
+        }
+
+        void push(E &&element) {
+            Node *node = new Node(move(element));
+            Node *prev = this->head.exchange(node, memory_order_acq_rel);
+            prev->next.store(node); //seq_cst, 与SerialExecutor中scheduled的检查构成Dekker式的同步
+        }
+
+        bool pop(E &element) {
+            Node *tail = this->tail;
+            Node *next = tail->next.load();
+            if (next == nullptr) {
+                return false;
+            }
+            element = move(next->element);
+            next->element = E();
+            this->tail = next;
+            if (tail != &this->stub) {
+                delete tail;
+            }
+            return true;
+        }
+
+        // 仅供消费者调用, 已链接的节点为空时返回true
+        bool isEmpty() const {
+            return this->tail->next.load() == nullptr;
+        }
+
+    private:
+        struct Node {
+            Node() : next(nullptr) {}
+            Node(E &&element) : next(nullptr), element(move(element)) {}
+            atomic<Node*> next;
+            E element;
+        };
+
+        Node stub;
+        alignas(64) atomic<Node*> head; //生产者端
+        alignas(64) Node *tail; //消费者端, 它指向的节点是已出队的哑节点
+    };
+
+    /**
+     * 串行执行器(strand): 包装一个Executor, 提交给同一个SerialExecutor的任务按FIFO顺序逐个执行,
+     * 可能在线程池的任意线程中执行, 但前一个任务结束之后下一个任务才开始(happens-before), 所以任务之间无需加锁.
+     * 典型用法是一个连接, 一个日志文件或一个会话对应一个SerialExecutor, 代替只用于串行化的互斥锁.
+     *
+     * 不使用任何锁: 任务放入MPSC队列后, 只有把scheduled从false改为true的线程才向底层Executor提交排空任务;
+     * 排空任务一次最多执行maxBatchSize个任务, 之后重新提交自己, 不会独占共享线程池.
+     * 任务抛出的异常被打印, 不影响后续任务
+     *
+     *     Ref<SerialExecutor> strand = new_<SerialExecutor>(executorService);
+     *     strand->execute(Runnable::of([connection] { connection->write(...); }));
+     */
+    class SerialExecutor : extends Object, implements Executor {
+    public:
+        SerialExecutor(Ref<Executor> executor, int maxBatchSize = 64) :
+            executor(executor),
+            maxBatchSize(maxBatchSize),
+            scheduled(false) {
+            if (executor == nullptr) {
+                throw_new(NullPointerException, "executor cannot be nullptr");
+            }
+            if (maxBatchSize < 1) {
+                throw_new(IllegalArgumentException, "maxBatchSize cannot be less than 1");
+            }
+        }
+        virtual ~SerialExecutor() {}
+
+        virtual void execute(Ref<Runnable> runnable) override {
+            if (runnable == nullptr) {
+                throw_new(NullPointerException, "runnable cannot be nullptr");
+            }
+            this->queue.push(move(runnable));
+            if (!this->scheduled.exchange(true)) {
+                this->schedule();
+            }
+        }
+
+        Ref<Executor> getExecutor() const {
+            return this->executor;
+        }
+
+        // 当前线程是否正在执行此SerialExecutor的任务, 可用于断言调用者已处于该strand中
+        bool isRunningInCurrentThread() const {
+            return currentSerialExecutor() == this;
+        }
+
+    private:
+        void schedule() {
+            Ref<SerialExecutor> self = this;
+            try_ {
+                this->executor->execute(Runnable::of([self] {
+                    self->drain();
+                }));
+            } catch_(Exception, ex) {
+                // 底层Executor拒绝了排空任务(例如已关闭), 下一次execute会重新尝试提交
+                this->scheduled.store(false);
+                throw_(ex);
+            } end_try
+        }
+
+        void drain() {
+            SerialExecutor *&current = currentSerialExecutor();
+            SerialExecutor *outer = current;
+            current = this;
+            defer([&current, outer] {
+                current = outer;
+            });
+            Ref<Runnable> runnable;
+            for (int i = 0; i < this->maxBatchSize; i++) {
+                if (!this->queue.pop(runnable)) {
+                    this->scheduled.store(false);
+                    // 生产者先入队再检查scheduled, 所以这里必须在清除scheduled之后再检查一次队列
+                    if (this->queue.isEmpty() || this->scheduled.exchange(true)) {
+                        return;
+                    }
+                    continue;
+                }
+                try_ {
+                    runnable->run();
+                } catch_(Exception, ex) {
+                    ex->printStackTrace();
+                } end_try
+                runnable = nullptr;
+            }
+            this->schedule();
+        }
+
+        static SerialExecutor *&currentSerialExecutor() {
+            static thread_local SerialExecutor *current = nullptr;
+            return current;
+        }
+
+        Ref<Executor> executor;
+        const int maxBatchSize;
+        _MpscQueue<Ref<Runnable>> queue;
+        atomic<bool> scheduled;
+        interface_refcount()
+    };
+
+    typedef SerialExecutor Strand;
+
+    /**
+     * 类似Actor的邮箱: 投递给同一个Mailbox的消息由handler在SerialExecutor中按投递顺序逐个处理,
+     * handler及其独占的状态因此不需要加锁. post是非阻塞的, 可以在任意线程(包括handler内部)调用
+     *
+     *     Ref<Mailbox<Ref<Order>>> mailbox = Mailbox<Ref<Order>>::of(orderBook, executorService);
+     *     mailbox->post(order);
+     */
+    template <typename T>
+    class Mailbox : extends Object, implements Consumer<T> {
+    public:
+        static Ref<Mailbox<T>> of(Ref<Consumer<T>> handler, Ref<Executor> executor) {
+            return new_<Mailbox<T>>(handler, new_<SerialExecutor>(executor));
+        }
+
+        // 多个Mailbox可以共享同一个strand, 它们的消息合并为一个顺序
+        Mailbox(Ref<Consumer<T>> handler, Ref<SerialExecutor> strand) : handler(handler), strand(strand) {
+            if (handler == nullptr) {
+                throw_new(NullPointerException, "handler cannot be nullptr");
+            }
+            if (strand == nullptr) {
+                throw_new(NullPointerException, "strand cannot be nullptr");
+            }
+        }
+        virtual ~Mailbox() {}
+
+        void post(const T &message) {
+            Ref<Consumer<T>> handler = this->handler;
+            this->strand->execute(Runnable::of([handler, message] {
+                handler->accept(message);
+            }));
+        }
+
+        virtual void accept(T message) override {
+            this->post(message);
+        }
+
+        Ref<SerialExecutor> getStrand() const {
+            return this->strand;
+        }
+
+    private:
+        Ref<Consumer<T>> handler;
+        Ref<SerialExecutor> strand;
+        interface_refcount()
+    };
+}
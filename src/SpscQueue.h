@@ -0,0 +1,290 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Common.h"
+#include "Auxiliary.h"
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <vector>
+#include <sched.h>
+
+namespace com_lanjing_cpp_common {
+
+    using namespace std;
+
+    // 队列满(生产者)或空(消费者)时的等待方式, 类似Disruptor的WaitStrategy
+    enum class WaitStrategy {
+        BLOCKING, //短暂让出CPU后通过EventCount挂起, 不占用CPU, 但每次入队和出队都要多一次内存屏障以检查对方是否在等待
+        YIELDING, //循环调用sched_yield, 延迟低且不挂起线程, 但等待期间仍占用CPU
+        BUSY_SPIN //纯自旋, 延迟最低, 只适合生产者和消费者各自独占一个CPU核心的场景
+    };
+
+    /**
+     * 单生产者单消费者的有界环形队列
+     *
+     * 只允许一个线程入队且只允许一个线程出队(两者可以不同), 适合流水线中两个阶段一对一的交接.
+     * 不加任何锁, offer和poll都是wait-free的: 生产者只写tail, 消费者只写head, 双方各自缓存对方的下标,
+     * 只有缓存值显示队列满或空时才去读取对方的缓存行. head和tail分别位于不同的缓存行.
+     *
+     * E可以是Ref<T>, 也可以是int, 结构体等POD类型, 元素直接存放在环形缓冲区中;
+     * offerAll/pollAll一次处理一批元素, 整批只发布一次下标, 只通知一次
+     */
+    template <typename E>
+    class SpscQueue : extends Object {
+    public:
+        SpscQueue(int capacity, WaitStrategy waitStrategy = WaitStrategy::BLOCKING) : waitStrategy(waitStrategy) {
+            if (capacity < 2) {
+                throw_new(IllegalArgumentException, "capacity cannot be less than 2");
+            }
+            if (capacity > (1 << 30)) {
+                throw_new(IllegalArgumentException, "capacity cannot be greater than 2^30");
+            }
+            size_t actualCapacity = 2;
+            while (actualCapacity < (size_t)capacity) {
+                actualCapacity <<= 1;
+            }
+            this->mask = actualCapacity - 1;
+            this->elements.reset(new E[actualCapacity]());
+        }
+        virtual ~SpscQueue() {}
+
+        // 实际容量, 即构造参数向上取整到2的幂
+        int getCapacity() const {
+            return (int)(this->mask + 1);
+        }
+
+        // 先读head再读tail: 两次读取之间消费者只会使head变大, 生产者只会使tail变大, 结果不会为负
+        int size() const {
+            size_t h = this->head.load(memory_order_acquire);
+            size_t t = this->tail.load(memory_order_acquire);
+            return (int)(t - h);
+        }
+
+        // 仅供生产者线程调用, 队列满时立即返回false
+        bool offer(const E &element) {
+            size_t t = this->tail.load(memory_order_relaxed);
+            if (!this->hasSpace(t, 1)) {
+                return false;
+            }
+            this->elements[t & this->mask] = element;
+            this->tail.store(t + 1, memory_order_release);
+            this->signal(this->notEmpty);
+            return true;
+        }
+
+        // 仅供生产者线程调用, 队列满时按WaitStrategy等待, 超时返回false
+        bool offer(const E &element, long timeout) {
+            int64_t deadline = System::currentTimeMillis() + timeout;
+            while (!this->offer(element)) {
+                if (!this->awaitSpace(deadline)) {
+                    return this->offer(element);
+                }
+            }
+            return true;
+        }
+
+        // 仅供生产者线程调用, 队列满时按WaitStrategy等待
+        void put(const E &element) {
+            while (!this->offer(element)) {
+                this->awaitSpace(-1);
+            }
+        }
+
+        // 仅供生产者线程调用, 尽可能多地放入elements中的元素(不等待), 返回实际放入的个数
+        int offerAll(const E *elements, int count) {
+            size_t t = this->tail.load(memory_order_relaxed);
+            size_t available = this->mask + 1 - (t - this->cachedHead);
+            if (available < (size_t)count) {
+                this->cachedHead = this->head.load(memory_order_acquire);
+                available = this->mask + 1 - (t - this->cachedHead);
+            }
+            int n = (int)min(available, (size_t)count);
+            for (int i = 0; i < n; i++) {
+                this->elements[(t + i) & this->mask] = elements[i];
+            }
+            if (n > 0) {
+                this->tail.store(t + n, memory_order_release);
+                this->signal(this->notEmpty);
+            }
+            return n;
+        }
+
+        int offerAll(const vector<E> &elements) {
+            return this->offerAll(elements.data(), (int)elements.size());
+        }
+
+        // 仅供生产者线程调用, 放入所有元素, 队列满时按WaitStrategy等待
+        void putAll(const E *elements, int count) {
+            while (true) {
+                int n = this->offerAll(elements, count);
+                elements += n;
+                count -= n;
+                if (count == 0) {
+                    return;
+                }
+                this->awaitSpace(-1);
+            }
+        }
+
+        void putAll(const vector<E> &elements) {
+            this->putAll(elements.data(), (int)elements.size());
+        }
+
+        // 仅供消费者线程调用, 队列空时立即返回false
+        bool poll(E &element) {
+            size_t h = this->head.load(memory_order_relaxed);
+            if (h == this->cachedTail) {
+                this->cachedTail = this->tail.load(memory_order_acquire);
+                if (h == this->cachedTail) {
+                    return false;
+                }
+            }
+            E &slot = this->elements[h & this->mask];
+            element = slot;
+            slot = E(); //不能让槽位继续持有已出队的引用
+            this->head.store(h + 1, memory_order_release);
+            this->signal(this->notFull);
+            return true;
+        }
+
+        // 仅供消费者线程调用, 队列空时按WaitStrategy等待, 超时返回false
+        bool poll(E &element, long timeout) {
+            int64_t deadline = System::currentTimeMillis() + timeout;
+            while (!this->poll(element)) {
+                if (!this->awaitElement(deadline)) {
+                    return this->poll(element);
+                }
+            }
+            return true;
+        }
+
+        // 仅供消费者线程调用, 队列空时按WaitStrategy等待
+        E take() {
+            E element;
+            while (!this->poll(element)) {
+                this->awaitElement(-1);
+            }
+            return element;
+        }
+
+        // 仅供消费者线程调用, 最多取出maxCount个元素追加到elements末尾(不等待), 返回实际取出的个数
+        int pollAll(vector<E> &elements, int maxCount = INT_MAX) {
+            size_t h = this->head.load(memory_order_relaxed);
+            if ((size_t)maxCount > this->cachedTail - h) {
+                this->cachedTail = this->tail.load(memory_order_acquire);
+            }
+            int n = (int)min(this->cachedTail - h, (size_t)maxCount);
+            for (int i = 0; i < n; i++) {
+                E &slot = this->elements[(h + i) & this->mask];
+                elements.push_back(slot);
+                slot = E();
+            }
+            if (n > 0) {
+                this->head.store(h + n, memory_order_release);
+                this->signal(this->notFull);
+            }
+            return n;
+        }
+
+        // 仅供消费者线程调用, 至少取出一个元素, 队列空时按WaitStrategy等待
+        int takeAll(vector<E> &elements, int maxCount = INT_MAX) {
+            while (true) {
+                int n = this->pollAll(elements, maxCount);
+                if (n > 0) {
+                    return n;
+                }
+                this->awaitElement(-1);
+            }
+        }
+
+    private:
+        // 仅供生产者线程调用
+        bool hasSpace(size_t t, size_t count) {
+            if (t + count - this->cachedHead > this->mask + 1) {
+                this->cachedHead = this->head.load(memory_order_acquire);
+                return t + count - this->cachedHead <= this->mask + 1;
+            }
+            return true;
+        }
+
+        // 仅供生产者线程调用, deadlineMillis小于0表示无限等待; 超时返回false
+        bool awaitSpace(int64_t deadlineMillis) {
+            return this->await(this->notFull, deadlineMillis, [this] {
+                return this->tail.load(memory_order_relaxed) - this->head.load(memory_order_acquire) <= this->mask;
+            });
+        }
+
+        // 仅供消费者线程调用, deadlineMillis小于0表示无限等待; 超时返回false
+        bool awaitElement(int64_t deadlineMillis) {
+            return this->await(this->notEmpty, deadlineMillis, [this] {
+                return this->head.load(memory_order_relaxed) != this->tail.load(memory_order_acquire);
+            });
+        }
+
+        template <typename C>
+        bool await(EventCount &eventCount, int64_t deadlineMillis, C ready) {
+            for (unsigned spin = 0; !ready(); spin++) {
+                if (deadlineMillis >= 0 && (spin & 0xFF) == 0 && System::currentTimeMillis() >= deadlineMillis) {
+                    return false;
+                }
+                if (this->waitStrategy == WaitStrategy::BUSY_SPIN) {
+                    cpuRelax();
+                } else if (this->waitStrategy == WaitStrategy::YIELDING || spin < YIELD_COUNT) {
+                    sched_yield();
+                } else {
+                    unsigned key = eventCount.prepareWait();
+                    if (ready()) {
+                        eventCount.cancelWait();
+                        return true;
+                    }
+                    if (deadlineMillis < 0) {
+                        eventCount.wait(key);
+                    } else if (!eventCount.wait(key, deadlineMillis)) {
+                        return ready();
+                    }
+                }
+            }
+            return true;
+        }
+
+        void signal(EventCount &eventCount) {
+            if (this->waitStrategy == WaitStrategy::BLOCKING) {
+                eventCount.notify();
+            }
+        }
+
+        static void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+            asm volatile("yield");
+#endif
+        }
+
+    private:
+        static const size_t CACHE_LINE_SIZE = 64;
+        static const unsigned YIELD_COUNT = 16;
+
+        const WaitStrategy waitStrategy;
+        size_t mask;
+        unique_ptr<E[]> elements;
+        char headPadding[CACHE_LINE_SIZE];
+        // 消费者独占的缓存行
+        atomic<size_t> head { 0 };
+        size_t cachedTail = 0;
+        char tailPadding[CACHE_LINE_SIZE - sizeof(atomic<size_t>) - sizeof(size_t)];
+        // 生产者独占的缓存行
+        atomic<size_t> tail { 0 };
+        size_t cachedHead = 0;
+        char eventCountPadding[CACHE_LINE_SIZE - sizeof(atomic<size_t>) - sizeof(size_t)];
+        EventCount notEmpty;
+        EventCount notFull;
+    };
+}
@@ -0,0 +1,432 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "ExecutorService.h"
+#include <vector>
+#include <map>
+#include <iterator>
+#include <exception>
+
+namespace com_lanjing_cpp_common {
+
+    using namespace std;
+
+    /*
+     * 对应java.util.stream.Stream<T>, 但是为值类型且完全基于模板:
+     *
+     * 1. 中间操作(filter, map)只是在类型上叠加一个阶段, 不做任何计算, 也不产生中间数组
+     * 2. 终结操作(reduce, collect, forEach...)执行时, 所有阶段被编译器内联为对源区间的一次遍历,
+     *    每个元素只经过普通的函数调用, 没有虚函数调用, 元素以引用传递, 也不会增减Ref的引用计数
+     * 3. parallel(executorService)之后, 终结操作把源区间切分成若干段, 由线程池线程和调用者线程动态领取,
+     *    (先做完的线程领取更多的段), 各段的部分结果最后按原顺序合并, 所以toVector等操作的结果顺序不变
+     *
+     *     int sum = Arrays::stream(arr)
+     *         .filter([](int value) { return value % 2 == 0; })
+     *         .map([](int value) { return value * value; })
+     *         .reduce(0, [](int a, int b) { return a + b; });
+     *
+     * 流引用着源数组(对于STL容器则仅仅引用其区间, 容器必须比流活得更久), 可以被多次执行终结操作.
+     * 并行模式下各段可能被多个线程同时处理, 所以filter/map/forEach的回调必须是线程安全的
+     */
+    template <typename T, typename Stage> class Stream;
+
+    // 源阶段: 遍历迭代器区间; 所有阶段的run返回false表示下游要求提前终止(例如anyMatch已经找到)
+    template <typename I>
+    struct _SourceStage {
+        typedef I Iterator;
+        template <typename Sink>
+        bool run(I from, I to, Sink &sink) const {
+            for (; from != to; ++from) {
+                if (!sink(*from)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    template <typename Upstream, typename Predicate>
+    struct _FilterStage {
+        typedef typename Upstream::Iterator Iterator;
+        template <typename Sink>
+        struct FilterSink {
+            const Predicate &predicate;
+            Sink &sink;
+            template <typename V>
+            bool operator()(V &&value) {
+                return !this->predicate(value) || this->sink(forward<V>(value));
+            }
+        };
+        template <typename Sink>
+        bool run(Iterator from, Iterator to, Sink &sink) const {
+            FilterSink<Sink> filterSink { this->predicate, sink };
+            return this->upstream.run(from, to, filterSink);
+        }
+        Upstream upstream;
+        Predicate predicate;
+    };
+
+    template <typename Upstream, typename F>
+    struct _MapStage {
+        typedef typename Upstream::Iterator Iterator;
+        template <typename Sink>
+        struct MapSink {
+            const F &function;
+            Sink &sink;
+            template <typename V>
+            bool operator()(V &&value) {
+                return this->sink(this->function(forward<V>(value)));
+            }
+        };
+        template <typename Sink>
+        bool run(Iterator from, Iterator to, Sink &sink) const {
+            MapSink<Sink> mapSink { this->function, sink };
+            return this->upstream.run(from, to, mapSink);
+        }
+        Upstream upstream;
+        F function;
+    };
+
+    // 终结操作的接收器: 把元素累积到某一段的部分结果中
+    template <typename R, typename Accumulator>
+    struct _AccumulateSink {
+        R &partial;
+        const Accumulator &accumulator;
+        template <typename V>
+        bool operator()(V &&value) {
+            return this->accumulator(this->partial, forward<V>(value));
+        }
+    };
+
+    // 部分结果的包装, 避免vector<bool>的特化
+    template <typename R>
+    struct _StreamPartial {
+        R value;
+    };
+
+    /*
+     * 并行执行的共享状态. 线程池中的辅助任务可能在调用者返回后才开始执行, 所以它必须是堆上的引用计数对象;
+     * 辅助任务只有领取到有效的段时才会访问调用者栈上的流水线, 而此时调用者必然还在等待
+     */
+    class _ParallelStreamTask : extends Object {
+    public:
+        static void run(Ref<ExecutorService> executorService, int chunkCount, const function<void(int)> &processChunk) {
+            Ref<_ParallelStreamTask> task = new_<_ParallelStreamTask>(chunkCount, processChunk);
+            int helperCount = min(executorService->getPoolSize(), chunkCount - 1);
+            for (int i = 0; i < helperCount; i++) {
+                executorService->execute(Runnable::of([task] {
+                    task->work();
+                }));
+            }
+            task->work(); //调用者线程同样参与计算, 所以在线程池线程中使用并行流也不会死锁
+            while (task->pendingChunks.load() != 0) {
+                unsigned key = task->eventCount.prepareWait();
+                if (task->pendingChunks.load() == 0) {
+                    task->eventCount.cancelWait();
+                    break;
+                }
+                task->eventCount.wait(key);
+            }
+            if (task->exception) {
+                rethrow_exception(task->exception); //保持原始异常类型
+            }
+        }
+        _ParallelStreamTask(int chunkCount, const function<void(int)> &processChunk) :
+            chunkCount(chunkCount),
+            nextChunk(0),
+            pendingChunks(chunkCount),
+            failed(false),
+            processChunk(processChunk) {}
+    private:
+        void work() {
+            int index;
+            while ((index = this->nextChunk.fetch_add(1)) < this->chunkCount) {
+                if (!this->failed.load(memory_order_relaxed)) {
+                    // 异常需要跨线程原样转交给调用者, 只能使用原生的try/catch
+                    try {
+                        this->processChunk(index);
+                    } catch (Exception *ex) {
+                        if (this->failed.exchange(true)) {
+                            ex->release();
+                        } else {
+                            this->exception = current_exception(); //持有的引用随exception_ptr转交给调用者
+                        }
+                    } catch (...) {
+                        if (!this->failed.exchange(true)) {
+                            this->exception = current_exception();
+                        }
+                    }
+                }
+                if (this->pendingChunks.fetch_sub(1) == 1) {
+                    this->eventCount.notifyAll();
+                }
+            }
+        }
+        const int chunkCount;
+        atomic<int> nextChunk;
+        atomic<int> pendingChunks;
+        atomic<bool> failed;
+        exception_ptr exception;
+        function<void(int)> processChunk;
+        EventCount eventCount;
+    };
+
+    template <typename E>
+    struct _StreamArrayFactory {
+        static Arr<E> newInstance(int size) {
+            return Array<E>::newInstance(size, ArrayElementType::CPP); //基本类型的特化版本将其视为"无需清零"
+        }
+    };
+    template <typename E>
+    struct _StreamArrayFactory<Ref<E>> {
+        static Arr<Ref<E>> newInstance(int size) {
+            return Array<Ref<E>>::newInstance(size);
+        }
+    };
+
+    template <typename T, typename Stage>
+    class Stream {
+    public:
+        typedef typename Stage::Iterator Iterator;
+
+        Stream(
+                const Stage &stage,
+                Iterator first,
+                Iterator last,
+                Ref<Object> owner,
+                Ref<ExecutorService> executorService = nullptr) :
+            stage(stage),
+            first(first),
+            last(last),
+            owner(owner),
+            executorService(executorService) {}
+
+        Stream<T, Stage> parallel(Ref<ExecutorService> executorService) const {
+            if (executorService == nullptr) {
+                throw_new(NullPointerException, "executorService cannot be nullptr");
+            }
+            return Stream<T, Stage>(this->stage, this->first, this->last, this->owner, executorService);
+        }
+        Stream<T, Stage> sequential() const {
+            return Stream<T, Stage>(this->stage, this->first, this->last, this->owner);
+        }
+        bool isParallel() const {
+            return this->executorService != nullptr;
+        }
+
+        template <typename P>
+        Stream<T, _FilterStage<Stage, P>> filter(P predicate) const {
+            return Stream<T, _FilterStage<Stage, P>>(
+                    _FilterStage<Stage, P> { this->stage, predicate },
+                    this->first,
+                    this->last,
+                    this->owner,
+                    this->executorService
+            );
+        }
+
+        template <typename F>
+        Stream<typename decay<decltype(declval<const F&>()(declval<T&>()))>::type, _MapStage<Stage, F>> map(F function) const {
+            return Stream<typename decay<decltype(declval<const F&>()(declval<T&>()))>::type, _MapStage<Stage, F>>(
+                    _MapStage<Stage, F> { this->stage, function },
+                    this->first,
+                    this->last,
+                    this->owner,
+                    this->executorService
+            );
+        }
+
+        template <typename C>
+        void forEach(C consumer) const {
+            this->template evaluate<bool>(
+                    [] { return true; },
+                    [&consumer](bool &, const T &value) {
+                        consumer(value);
+                        return true;
+                    },
+                    [](bool &, bool &&) {}
+            );
+        }
+
+        template <typename Op>
+        T reduce(const T &identity, Op op) const {
+            return this->template evaluate<T>(
+                    [&identity] { return identity; },
+                    [&op](T &partial, const T &value) {
+                        partial = op(partial, value);
+                        return true;
+                    },
+                    [&op](T &left, T &&right) {
+                        left = op(left, right);
+                    }
+            );
+        }
+
+        long count() const {
+            return this->template evaluate<long>(
+                    [] { return 0L; },
+                    [](long &partial, const T &) {
+                        ++partial;
+                        return true;
+                    },
+                    [](long &left, long &&right) {
+                        left += right;
+                    }
+            );
+        }
+
+        template <typename P>
+        bool anyMatch(P predicate) const {
+            return this->template evaluate<bool>(
+                    [] { return false; },
+                    [&predicate](bool &partial, const T &value) {
+                        partial = predicate(value);
+                        return !partial;
+                    },
+                    [](bool &left, bool &&right) {
+                        left = left || right;
+                    }
+            );
+        }
+        template <typename P>
+        bool allMatch(P predicate) const {
+            return !this->anyMatch([&predicate](const T &value) {
+                return !predicate(value);
+            });
+        }
+        template <typename P>
+        bool noneMatch(P predicate) const {
+            return !this->anyMatch(predicate);
+        }
+
+        /*
+         * 对应Java的collect(supplier, accumulator, combiner):
+         * supplier创建每一段的结果容器, accumulator(R&, const T&)把元素加入容器, combiner(R&, R&&)把右侧容器合并到左侧
+         */
+        template <typename S, typename A, typename C>
+        typename decay<decltype(declval<S&>()())>::type collect(S supplier, A accumulator, C combiner) const {
+            typedef typename decay<decltype(declval<S&>()())>::type R;
+            return this->template evaluate<R>(
+                    supplier,
+                    [&accumulator](R &partial, const T &value) {
+                        accumulator(partial, value);
+                        return true;
+                    },
+                    combiner
+            );
+        }
+
+        vector<T> toVector() const {
+            return this->collect(
+                    [] { return vector<T>(); },
+                    [](vector<T> &partial, const T &value) {
+                        partial.push_back(value);
+                    },
+                    [](vector<T> &left, vector<T> &&right) {
+                        left.insert(left.end(), make_move_iterator(right.begin()), make_move_iterator(right.end()));
+                    }
+            );
+        }
+
+        Arr<T> toArray() const {
+            vector<T> values = this->toVector();
+            Arr<T> arr = _StreamArrayFactory<T>::newInstance((int)values.size());
+            for (size_t i = 0; i < values.size(); i++) {
+                arr[(int)i] = move(values[i]);
+            }
+            return arr;
+        }
+
+        // 对应Collectors.groupingBy(classifier), 每组内元素保持原顺序
+        template <typename F>
+        std::map<typename decay<decltype(declval<const F&>()(declval<const T&>()))>::type, vector<T>> groupingBy(F classifier) const {
+            typedef std::map<typename decay<decltype(declval<const F&>()(declval<const T&>()))>::type, vector<T>> R;
+            return this->collect(
+                    [] { return R(); },
+                    [&classifier](R &partial, const T &value) {
+                        partial[classifier(value)].push_back(value);
+                    },
+                    [](R &left, R &&right) {
+                        for (auto &entry : right) {
+                            vector<T> &group = left[entry.first];
+                            group.insert(group.end(), make_move_iterator(entry.second.begin()), make_move_iterator(entry.second.end()));
+                        }
+                    }
+            );
+        }
+
+    private:
+        /*
+         * 所有终结操作的实现: 每一段由supplier创建部分结果, 流水线的输出经accumulator累积进去,
+         * 最后按段的顺序用combiner合并. 串行模式下只有一段, 即对整个源区间的一次遍历
+         */
+        template <typename R, typename S, typename A, typename C>
+        R evaluate(S supplier, A accumulator, C combiner) const {
+            long size = distance(this->first, this->last);
+            if (this->executorService == nullptr || size < 2) {
+                R result = supplier();
+                _AccumulateSink<R, A> sink { result, accumulator };
+                this->stage.run(this->first, this->last, sink);
+                return result;
+            }
+            // 段数多于线程数, 以便先完成的线程继续领取剩余的段(动态负载均衡)
+            int chunkCount = (int)min(size, (long)(this->executorService->getPoolSize() + 1) * 4);
+            vector<Iterator> bounds;
+            bounds.reserve(chunkCount + 1);
+            Iterator iterator = this->first;
+            for (int i = 0; i < chunkCount; i++) {
+                bounds.push_back(iterator);
+                advance(iterator, size / chunkCount + (i < size % chunkCount ? 1 : 0));
+            }
+            bounds.push_back(this->last);
+            vector<_StreamPartial<R>> partials;
+            partials.reserve(chunkCount);
+            for (int i = 0; i < chunkCount; i++) {
+                partials.push_back(_StreamPartial<R> { supplier() });
+            }
+            _ParallelStreamTask::run(this->executorService, chunkCount, [&](int index) {
+                _AccumulateSink<R, A> sink { partials[index].value, accumulator };
+                this->stage.run(bounds[index], bounds[index + 1], sink);
+            });
+            R result = move(partials[0].value);
+            for (int i = 1; i < chunkCount; i++) {
+                combiner(result, move(partials[i].value));
+            }
+            return result;
+        }
+
+        Stage stage;
+        Iterator first;
+        Iterator last;
+        Ref<Object> owner; //保证源数组在流的生命周期内不被释放
+        Ref<ExecutorService> executorService;
+    };
+
+    // 对应java.util.Arrays
+    struct Arrays {
+        template <typename E>
+        static Stream<E, _SourceStage<E*>> stream(const Arr<E> &arr) {
+            return Stream<E, _SourceStage<E*>>(_SourceStage<E*>(), arr.begin(), arr.end(), arr.get());
+        }
+    };
+
+    // 对应Java的Collection.stream(), 适用于任何提供begin()/end()的STL容器, 容器必须比流活得更久
+    struct Collections {
+        template <typename C>
+        static Stream<
+            typename decay<decltype(*declval<const C&>().begin())>::type,
+            _SourceStage<typename C::const_iterator>
+        > stream(const C &collection) {
+            return Stream<
+                typename decay<decltype(*declval<const C&>().begin())>::type,
+                _SourceStage<typename C::const_iterator>
+            >(_SourceStage<typename C::const_iterator>(), collection.begin(), collection.end(), nullptr);
+        }
+    };
+}
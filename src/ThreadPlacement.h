@@ -0,0 +1,206 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Common.h"
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <sched.h>
+
+namespace com_lanjing_cpp_common {
+
+    /**
+     * NUMA拓扑, 读取自/sys/devices/system/node, 不依赖libnuma.
+     * 非Linux系统或不支持NUMA的内核上视为只有一个节点, 包含所有CPU
+     */
+    struct NumaTopology {
+    public:
+        static int nodeCount() {
+            return (int)nodes().size();
+        }
+
+        static const vector<int> &cpusOfNode(int node) {
+            if (node < 0 || node >= nodeCount()) {
+                throw_new(IllegalArgumentException, "Illegal NUMA node");
+            }
+            return nodes()[node];
+        }
+
+        static int nodeOfCpu(int cpu) {
+            const vector<vector<int>> &allNodes = nodes();
+            for (size_t node = 0; node < allNodes.size(); node++) {
+                for (int c : allNodes[node]) {
+                    if (c == cpu) {
+                        return (int)node;
+                    }
+                }
+            }
+            return 0;
+        }
+
+        // 当前线程正在其上运行的NUMA节点
+        static int currentNode() {
+            if (nodeCount() == 1) {
+                return 0;
+            }
+#ifdef __linux__
+            int cpu = sched_getcpu();
+            return cpu < 0 ? 0 : nodeOfCpu(cpu);
+#else
+            return 0;
+#endif //__linux__
+        }
+
+        // 解析形如"0-3,8-11"的CPU列表
+        static vector<int> parseCpuList(const string &text) {
+            vector<int> cpus;
+            istringstream stream(text);
+            string range;
+            while (getline(stream, range, ',')) {
+                const char *begin = range.c_str();
+                char *end;
+                long first = strtol(begin, &end, 10);
+                if (end == begin) {
+                    continue; //忽略无法解析的部分(例如空行)
+                }
+                long last = first;
+                if (*end == '-') {
+                    last = strtol(end + 1, nullptr, 10);
+                }
+                for (long cpu = first; cpu <= last; cpu++) {
+                    cpus.push_back((int)cpu);
+                }
+            }
+            return cpus;
+        }
+
+    private:
+        static const vector<vector<int>> &nodes() {
+            static vector<vector<int>> instance = loadNodes();
+            return instance;
+        }
+
+        static vector<vector<int>> loadNodes() {
+            vector<vector<int>> result;
+            for (int node = 0; ; node++) {
+                ostringstream path;
+                path << "/sys/devices/system/node/node" << node << "/cpulist";
+                ifstream file(path.str());
+                if (!file) {
+                    break;
+                }
+                string text;
+                getline(file, text);
+                vector<int> cpus = parseCpuList(text);
+                if (!cpus.empty()) { //没有CPU的节点(只有内存)不参与线程放置
+                    result.push_back(cpus);
+                }
+            }
+            if (result.empty()) {
+                vector<int> cpus;
+                int count = max((int)thread::hardware_concurrency(), 1);
+                for (int cpu = 0; cpu < count; cpu++) {
+                    cpus.push_back(cpu);
+                }
+                result.push_back(cpus);
+            }
+            return result;
+        }
+    };
+
+    /**
+     * 线程池线程的放置策略(类似于Java的ThreadFactory): 决定线程的名称以及可以运行在哪些CPU上.
+     *
+     * 线程池中的第index个线程在开始执行任务之前调用applyToCurrentThread(index).
+     * 名称为"前缀-序号", 会被截断为15个字符(Linux的限制), 便于在top -H, perf和gdb中辨认;
+     * 第index个线程绑定到cpuSets[index % cpuSets.size()], cpuSets为空时不绑定.
+     * 子类可以覆盖applyToCurrentThread以设置优先级等其他属性
+     */
+    class ThreadPlacement : extends Object {
+    public:
+        ThreadPlacement(const string &namePrefix, const vector<vector<int>> &cpuSets = vector<vector<int>>()) :
+            namePrefix(namePrefix), cpuSets(cpuSets) {
+            for (const vector<int> &cpuSet : cpuSets) {
+                if (cpuSet.empty()) {
+                    throw_new(IllegalArgumentException, "CPU set cannot be empty");
+                }
+                for (int cpu : cpuSet) {
+                    if (cpu < 0) {
+                        throw_new(IllegalArgumentException, "Illegal CPU index");
+                    }
+                }
+            }
+        }
+        virtual ~ThreadPlacement() {}
+
+        // 只设置线程名称
+        static Ref<ThreadPlacement> named(const string &namePrefix) {
+            return new_<ThreadPlacement>(namePrefix);
+        }
+
+        // 每个线程独占一个CPU, 线程数多于CPU数时轮流分配
+        static Ref<ThreadPlacement> pinned(const string &namePrefix, const vector<int> &cpus) {
+            vector<vector<int>> cpuSets;
+            for (int cpu : cpus) {
+                cpuSets.push_back(vector<int> { cpu });
+            }
+            return new_<ThreadPlacement>(namePrefix, cpuSets);
+        }
+
+        // 所有线程共享一组CPU, 由操作系统在其中调度
+        static Ref<ThreadPlacement> onCpus(const string &namePrefix, const vector<int> &cpus) {
+            return new_<ThreadPlacement>(namePrefix, vector<vector<int>> { cpus });
+        }
+
+        // 所有线程运行在指定NUMA节点的CPU上, 它们分配的内存(按first-touch策略)也就位于该节点
+        static Ref<ThreadPlacement> onNumaNode(const string &namePrefix, int node) {
+            return onCpus(namePrefix, NumaTopology::cpusOfNode(node));
+        }
+
+        const string &getNamePrefix() const {
+            return this->namePrefix;
+        }
+
+        const vector<vector<int>> &getCpuSets() const {
+            return this->cpuSets;
+        }
+
+        // 尽力而为: 设置失败(例如CPU不在当前进程允许的范围内)时返回false, 线程照常运行
+        virtual bool applyToCurrentThread(int index) {
+            bool success = true;
+            if (!this->namePrefix.empty()) {
+                ostringstream name;
+                name << this->namePrefix << '-' << index;
+                string text = name.str().substr(0, 15);
+#ifdef __APPLE__
+                success = pthread_setname_np(text.c_str()) == 0;
+#else
+                success = pthread_setname_np(pthread_self(), text.c_str()) == 0;
+#endif //__APPLE__
+            }
+#ifdef __linux__
+            if (!this->cpuSets.empty()) {
+                cpu_set_t cpuSet;
+                CPU_ZERO(&cpuSet);
+                for (int cpu : this->cpuSets[index % this->cpuSets.size()]) {
+                    if (cpu < CPU_SETSIZE) {
+                        CPU_SET(cpu, &cpuSet);
+                    }
+                }
+                success = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0 && success;
+            }
+#endif //__linux__
+            return success;
+        }
+
+    private:
+        string namePrefix;
+        vector<vector<int>> cpuSets;
+    };
+}
@@ -0,0 +1,508 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Functional.h"
+#include "Executor.h"
+#include "BlockingQueue.h"
+#include "Auxiliary.h"
+#include "CompletableFuture.h"
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+namespace com_lanjing_cpp_common {
+
+    class RejectedExecutionException : extends Exception {
+    public:
+        RejectedExecutionException(exception_param_prefix, const string &message, Ref<Exception> cause = nullptr) :
+            Exception(exception_arg_prefix, message, cause) {}
+    };
+
+    // 任务队列已满且线程数已达maximumPoolSize(或线程池已关闭)时如何处理新任务
+    enum class RejectionPolicy {
+        ABORT,          //抛出RejectedExecutionException(默认)
+        CALLER_RUNS,    //在调用execute的线程中直接执行, 使提交者自然地慢下来
+        DISCARD_OLDEST, //丢弃队列中最早的任务, 然后重新提交
+        DISCARD,        //丢弃新任务
+        BLOCK           //阻塞提交者直到队列有空位
+    };
+
+    /**
+     * java.util.concurrent.ThreadPoolExecutor的简化实现
+     *
+     * 线程数少于corePoolSize时, 每个新任务都会创建一个新线程; 否则任务进入workQueue;
+     * 队列已满时再创建新线程, 直到maximumPoolSize; 仍然无法接受的任务交给RejectionPolicy处理.
+     * 超出corePoolSize的线程空闲超过keepAliveMillis后退出(allowCoreThreadTimeOut(true)时核心线程也会退出).
+     * 使用有界队列可以在负载突增时产生背压, 而不是无限制地堆积任务
+     */
+    class ThreadPoolExecutor : extends Object, implements Executor {
+    public:
+        // 使用容量为queueCapacity的LinkedBlockingQueue作为任务队列
+        ThreadPoolExecutor(
+                int corePoolSize,
+                int maximumPoolSize,
+                long keepAliveMillis,
+                int queueCapacity = INT_MAX,
+                RejectionPolicy rejectionPolicy = RejectionPolicy::ABORT) {
+            this->sharedExecutor = new_<SharedExecutor>(
+                corePoolSize,
+                maximumPoolSize,
+                keepAliveMillis,
+                new_<LinkedBlockingQueue<Runnable>>(queueCapacity),
+                rejectionPolicy
+            );
+        }
+        // 使用指定的阻塞队列作为任务队列, Q必须实现BlockingQueue<Runnable>
+        template <typename Q>
+        ThreadPoolExecutor(
+                int corePoolSize,
+                int maximumPoolSize,
+                long keepAliveMillis,
+                Ref<Q> workQueue,
+                RejectionPolicy rejectionPolicy = RejectionPolicy::ABORT) {
+            if (workQueue == nullptr) {
+                throw_new(IllegalArgumentException, "workQueue cannot be null");
+            }
+            this->sharedExecutor = new_<SharedExecutor>(
+                corePoolSize,
+                maximumPoolSize,
+                keepAliveMillis,
+                workQueue,
+                rejectionPolicy
+            );
+        }
+        // 关闭线程池并等待已提交的任务执行完毕(在线程池自己的线程中析构时不等待)
+        virtual ~ThreadPoolExecutor() {
+            this->sharedExecutor->shutdown();
+            if (!this->sharedExecutor->isCurrentThreadWorker()) {
+                this->sharedExecutor->awaitTermination(-1);
+            }
+        }
+
+        virtual void execute(Ref<Runnable> runnable) override {
+            this->sharedExecutor->execute(runnable);
+        }
+
+        template <typename T>
+        Ref<CompletableFuture<T>> submit(Ref<Supplier<T>> supplier) {
+            return CompletableFuture<T>::supplyAsync(supplier, this);
+        }
+
+        // 不再接受新任务, 已提交的任务仍会被执行; 不等待
+        void shutdown() {
+            this->sharedExecutor->shutdown();
+        }
+
+        // 不再接受新任务, 丢弃并返回尚未开始执行的任务; 正在执行的任务不受影响
+        vector<Ref<Runnable>> shutdownNow() {
+            return this->sharedExecutor->shutdownNow();
+        }
+
+        bool isShutdown() const {
+            return this->sharedExecutor->isShutdown();
+        }
+
+        // 关闭之后所有线程都已退出
+        bool isTerminated() const {
+            return this->sharedExecutor->isTerminated();
+        }
+
+        // 等待线程池终止, timeoutMillis小于0表示无限等待; 超时返回false
+        bool awaitTermination(long timeoutMillis) {
+            return this->sharedExecutor->awaitTermination(timeoutMillis);
+        }
+
+        // 启动一个核心线程等待任务, 所有核心线程都已启动时返回false
+        bool prestartCoreThread() {
+            return this->sharedExecutor->addWorker(nullptr, true);
+        }
+
+        // 启动所有核心线程, 返回启动的线程数
+        int prestartAllCoreThreads() {
+            int count = 0;
+            while (this->sharedExecutor->addWorker(nullptr, true)) {
+                count++;
+            }
+            return count;
+        }
+
+        void allowCoreThreadTimeOut(bool value) {
+            this->sharedExecutor->allowCoreThreadTimeOut(value);
+        }
+
+        int getCorePoolSize() const {
+            return this->sharedExecutor->corePoolSize;
+        }
+
+        int getMaximumPoolSize() const {
+            return this->sharedExecutor->maximumPoolSize;
+        }
+
+        long getKeepAliveMillis() const {
+            return this->sharedExecutor->keepAliveMillis;
+        }
+
+        RejectionPolicy getRejectionPolicy() const {
+            return this->sharedExecutor->rejectionPolicy;
+        }
+
+        // 当前线程数
+        int getPoolSize() const {
+            return this->sharedExecutor->workerCount.load();
+        }
+
+        // 正在执行任务的线程数
+        int getActiveCount() const {
+            return this->sharedExecutor->activeCount.load();
+        }
+
+        // 曾经同时存在的最大线程数
+        int getLargestPoolSize() const {
+            return this->sharedExecutor->largestPoolSize.load();
+        }
+
+        int64_t getCompletedTaskCount() const {
+            return this->sharedExecutor->completedTaskCount.sum();
+        }
+
+        Ref<BlockingQueue<Runnable>> getQueue() const {
+            return this->sharedExecutor->workQueue;
+        }
+
+    private:
+        /*
+         * 和ExecutorService::SharedService一样, 被调用者线程和线程池线程共享;
+         * 外层ThreadPoolExecutor析构时关闭线程池, 最后一个线程退出时才释放本对象
+         */
+        class SharedExecutor : extends Object {
+        public:
+            SharedExecutor(
+                    int corePoolSize,
+                    int maximumPoolSize,
+                    long keepAliveMillis,
+                    Ref<BlockingQueue<Runnable>> workQueue,
+                    RejectionPolicy rejectionPolicy) :
+                corePoolSize(corePoolSize),
+                maximumPoolSize(maximumPoolSize),
+                keepAliveMillis(keepAliveMillis),
+                rejectionPolicy(rejectionPolicy),
+                workQueue(workQueue) {
+                if (corePoolSize < 0) {
+                    throw_new(IllegalArgumentException, "corePoolSize cannot be negative");
+                }
+                if (maximumPoolSize < 1 || maximumPoolSize < corePoolSize) {
+                    throw_new(IllegalArgumentException, "maximumPoolSize cannot be less than 1 or corePoolSize");
+                }
+                if (keepAliveMillis < 0) {
+                    throw_new(IllegalArgumentException, "keepAliveMillis cannot be negative");
+                }
+                this->terminationCondition = new_<Condition>(this->mainLock);
+            }
+            virtual ~SharedExecutor() {}
+
+            void execute(Ref<Runnable> runnable) {
+                if (runnable == nullptr) {
+                    throw_new(IllegalArgumentException, "runnable cannot be null");
+                }
+                if (this->workerCount.load() < this->corePoolSize && this->addWorker(runnable, true)) {
+                    return;
+                }
+                if (this->state.load() == RUNNING && this->offerNow(runnable)) {
+                    // 核心线程可能都已超时退出, 至少保留一个线程处理队列
+                    if (this->workerCount.load() == 0) {
+                        this->addWorker(nullptr, false);
+                    }
+                    return;
+                }
+                if (this->addWorker(runnable, false)) {
+                    return;
+                }
+                this->reject(runnable);
+            }
+
+            // 创建线程, core决定线程数的上限是corePoolSize还是maximumPoolSize; 已关闭或达到上限时返回false
+            bool addWorker(Ref<Runnable> firstTask, bool core) {
+                int limit = core ? this->corePoolSize : this->maximumPoolSize;
+                int count = this->workerCount.load();
+                do {
+                    if (count >= limit || this->state.load() != RUNNING) {
+                        return false;
+                    }
+                } while (!this->workerCount.compare_exchange_weak(count, count + 1));
+                // 先增加线程数再检查状态, 与shutdown"先改变状态再检查线程数"构成Dekker式同步
+                if (this->state.load() != RUNNING) {
+                    this->workerExited();
+                    return false;
+                }
+                int largest = this->largestPoolSize.load();
+                while (largest < count + 1 && !this->largestPoolSize.compare_exchange_weak(largest, count + 1));
+
+                WorkerStart *start = new WorkerStart { this, firstTask };
+                this->retain();
+                pthread_t thread;
+                int error = pthread_create(&thread, nullptr, threadProc, start);
+                if (error != 0) {
+                    delete start;
+                    this->workerExited();
+                    this->release();
+                    throw_new(OSException, error, "Cannot create thread for ThreadPoolExecutor");
+                }
+                pthread_detach(thread);
+                return true;
+            }
+
+            void shutdown() {
+                int expected = RUNNING;
+                if (this->state.compare_exchange_strong(expected, SHUTDOWN)) {
+                    this->wakeUpIdleWorker();
+                    this->tryTerminate();
+                }
+            }
+
+            vector<Ref<Runnable>> shutdownNow() {
+                int current = this->state.load();
+                while (current < STOP && !this->state.compare_exchange_weak(current, STOP));
+                vector<Ref<Runnable>> runnables;
+                this->workQueue->drainTo(runnables);
+                runnables.erase(remove(runnables.begin(), runnables.end(), nilRunnable()), runnables.end());
+                this->wakeUpIdleWorker();
+                this->tryTerminate();
+                return runnables;
+            }
+
+            bool isShutdown() const {
+                return this->state.load() != RUNNING;
+            }
+
+            bool isTerminated() const {
+                return this->state.load() == TERMINATED;
+            }
+
+            bool awaitTermination(long timeoutMillis) {
+                int64_t deadline = System::currentTimeMillis() + timeoutMillis;
+                Mutex::Scope scope(this->mainLock);
+                while (this->state.load() != TERMINATED) {
+                    if (timeoutMillis < 0) {
+                        this->terminationCondition->wait();
+                    } else {
+                        int64_t remaining = deadline - System::currentTimeMillis();
+                        if (remaining <= 0) {
+                            return false;
+                        }
+                        this->terminationCondition->wait(remaining);
+                    }
+                }
+                return true;
+            }
+
+            void allowCoreThreadTimeOut(bool value) {
+                if (value && this->keepAliveMillis <= 0) {
+                    throw_new(IllegalArgumentException, "Core threads must have nonzero keep alive times");
+                }
+                if (!this->coreThreadTimeOut.exchange(value) && value) {
+                    // 唤醒正在take中挂起的线程, 使其改为带超时地等待
+                    for (int i = this->workerCount.load(); i > 0 && this->workQueue->remainingCapacity() > 0; --i) {
+                        this->workQueue->offer(nilRunnable(), 0);
+                    }
+                }
+            }
+
+            bool isCurrentThreadWorker() const {
+                return currentExecutor() == this;
+            }
+
+        private:
+            struct WorkerStart {
+                SharedExecutor *executor;
+                Ref<Runnable> firstTask;
+            };
+
+            static void *threadProc(void *data) {
+                WorkerStart *start = reinterpret_cast<WorkerStart*>(data);
+                SharedExecutor *executor = start->executor;
+                Ref<Runnable> task = start->firstTask;
+                delete start;
+                defer([=]() {
+                    currentExecutor() = nullptr;
+                    executor->release();
+                });
+                currentExecutor() = executor;
+                executor->threadRun(task);
+                return nullptr;
+            }
+
+            void threadRun(Ref<Runnable> task) {
+                while (task != nullptr || (task = this->getTask()) != nullptr) {
+                    this->activeCount.fetch_add(1);
+                    try_ {
+                        task();
+                    } catch_(Exception, ex) {
+                        ex->printStackTrace();
+                    } end_try
+                    this->activeCount.fetch_sub(1);
+                    this->completedTaskCount.increment();
+                    task = nullptr;
+                    if (this->state.load() >= STOP) {
+                        this->workerExited();
+                        return;
+                    }
+                }
+                // getTask返回nullptr时已经减少了线程数
+                this->afterWorkerExited();
+            }
+
+            // 返回nullptr表示当前线程应当退出, 此时已减少了线程数
+            Ref<Runnable> getTask() {
+                bool timedOut = false;
+                while (true) {
+                    int s = this->state.load();
+                    if (s >= STOP || (s == SHUTDOWN && this->workQueue->size() == 0)) {
+                        this->workerCount.fetch_sub(1);
+                        return nullptr;
+                    }
+                    int count = this->workerCount.load();
+                    bool timed = this->coreThreadTimeOut.load() || count > this->corePoolSize;
+                    if (timed && timedOut && (count > 1 || this->workQueue->size() == 0)) {
+                        if (this->workerCount.compare_exchange_strong(count, count - 1)) {
+                            return nullptr;
+                        }
+                        continue;
+                    }
+                    Ref<Runnable> runnable;
+                    if (s == SHUTDOWN) {
+                        // 关闭后不再有新任务, 不能挂起
+                        runnable = this->workQueue->poll(0);
+                    } else if (timed) {
+                        runnable = this->workQueue->poll(this->keepAliveMillis);
+                        timedOut = runnable == nullptr;
+                    } else {
+                        runnable = this->workQueue->take();
+                    }
+                    if (runnable != nullptr && runnable != nilRunnable()) {
+                        return runnable;
+                    }
+                }
+            }
+
+            void workerExited() {
+                this->workerCount.fetch_sub(1);
+                this->afterWorkerExited();
+            }
+
+            void afterWorkerExited() {
+                if (this->state.load() != RUNNING) {
+                    this->wakeUpIdleWorker(); //接力唤醒可能仍在take中挂起的线程
+                    this->tryTerminate();
+                }
+            }
+
+            /*
+             * 关闭时可能有线程正在take中挂起, 放入一个退出标记唤醒其中之一;
+             * 每个退出的线程都会再放入一个, 直到所有线程都退出. 队列已满说明没有线程挂起, 放入失败也无妨
+             */
+            void wakeUpIdleWorker() {
+                if (this->workerCount.load() > 0 && this->workQueue->remainingCapacity() > 0) {
+                    this->workQueue->offer(nilRunnable(), 0);
+                }
+            }
+
+            void tryTerminate() {
+                int s = this->state.load();
+                if (s == TERMINATED || s == RUNNING || this->workerCount.load() != 0) {
+                    return;
+                }
+                Mutex::Scope scope(this->mainLock);
+                if (this->state.compare_exchange_strong(s, TERMINATED)) {
+                    // 清除残留的退出标记
+                    vector<Ref<Runnable>> runnables;
+                    this->workQueue->drainTo(runnables);
+                    runnables.erase(remove(runnables.begin(), runnables.end(), nilRunnable()), runnables.end());
+                    this->workQueue->offerAll(runnables);
+                    this->terminationCondition->notifyAll();
+                }
+            }
+
+            // 不等待地放入任务, 队列已满时返回false
+            bool offerNow(const Ref<Runnable> &runnable) {
+                return this->workQueue->remainingCapacity() > 0 && this->workQueue->offer(runnable, 0);
+            }
+
+            void reject(Ref<Runnable> runnable) {
+                bool shutdown = this->state.load() != RUNNING;
+                if (this->rejectionPolicy == RejectionPolicy::ABORT || shutdown) {
+                    if (this->rejectionPolicy == RejectionPolicy::ABORT) {
+                        throw_new(
+                            RejectedExecutionException,
+                            shutdown ?
+                                "The ThreadPoolExecutor has been shut down" :
+                                "The work queue is full and the pool size has reached maximumPoolSize"
+                        );
+                    }
+                    return; //关闭之后其余策略都丢弃任务
+                }
+                switch (this->rejectionPolicy) {
+                case RejectionPolicy::CALLER_RUNS:
+                    runnable();
+                    break;
+                case RejectionPolicy::DISCARD_OLDEST: {
+                        vector<Ref<Runnable>> oldest;
+                        this->workQueue->drainTo(oldest, 1);
+                        this->execute(runnable);
+                    }
+                    break;
+                case RejectionPolicy::BLOCK:
+                    this->workQueue->put(runnable);
+                    if (this->workerCount.load() == 0) {
+                        this->addWorker(nullptr, false);
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            static SharedExecutor *&currentExecutor() {
+                static thread_local SharedExecutor *executor = nullptr;
+                return executor;
+            }
+
+            // 用于唤醒挂起在take中的线程
+            static Ref<Runnable> &nilRunnable() {
+                static Ref<Runnable> instance = Runnable::of([=]{});
+                return instance;
+            }
+
+        private:
+            static const int RUNNING = 0;
+            static const int SHUTDOWN = 1;
+            static const int STOP = 2;
+            static const int TERMINATED = 3;
+
+            const int corePoolSize;
+            const int maximumPoolSize;
+            const long keepAliveMillis;
+            const RejectionPolicy rejectionPolicy;
+            Ref<BlockingQueue<Runnable>> workQueue;
+            atomic<int> state { RUNNING };
+            atomic<int> workerCount { 0 };
+            atomic<int> activeCount { 0 };
+            atomic<int> largestPoolSize { 0 };
+            atomic<bool> coreThreadTimeOut { false };
+            LongAdder completedTaskCount;
+            Mutex mainLock { false };
+            Ref<Condition> terminationCondition;
+
+            friend class ThreadPoolExecutor;
+        };
+
+    private:
+        Ref<SharedExecutor> sharedExecutor;
+        interface_refcount()
+    };
+}
@@ -0,0 +1,233 @@
+/*
+ * 本框架版权归"成都蓝景信息技术有限公司所有", 更多细节请参见LICENSE文件
+ *
+ * 本框架提供以Java思维来开发C++应用程序的能力, 并对本公司相关项目需要用到的JDK和开源框架的API给出类似实现
+ *
+ * @author 陈涛
+ */
+#pragma once
+
+#include "Common.h"
+#include <vector>
+
+namespace com_lanjing_cpp_common {
+
+    /**
+     * 可以挂在TimingWheel上的节点, 使用者继承它(侵入式链表, 挂入和摘下都不分配内存).
+     * TimingWheel不管理节点的生命周期, 节点在挂入期间必须保持有效
+     */
+    struct TimerNode {
+    public:
+        TimerNode() : prev(nullptr), next(nullptr), expiryTick(0), slotIndex(-1) {}
+        bool isLinked() const {
+            return this->slotIndex != -1;
+        }
+        int64_t getExpiryTick() const {
+            return this->expiryTick;
+        }
+    private:
+        TimerNode *prev;
+        TimerNode *next;
+        int64_t expiryTick;
+        int slotIndex; //level * SLOT_COUNT + slot, 未挂入时为-1
+        friend class TimingWheel;
+    };
+
+    /**
+     * 分层时间轮(Varghese & Lauck), 不是线程安全的, 由使用者加锁.
+     *
+     * 共LEVEL_COUNT层, 每层SLOT_COUNT个槽, 第L层的一个槽跨越SLOT_COUNT^L个tick.
+     * 节点按到期时间与当前时间之差放入能容纳它的最低层, 上层的槽在时间推进到它的起点时被拆散到下层,
+     * 所以add和remove都是O(1), 每个节点最多迁移LEVEL_COUNT-1次.
+     * 每层用一个位图记录非空的槽, nextEventTick据此直接算出下一个需要处理的tick, 空闲的时间轮不需要逐tick推进
+     */
+    class TimingWheel {
+    public:
+        static const int SLOT_BITS = 6;
+        static const int SLOT_COUNT = 1 << SLOT_BITS;
+        static const int LEVEL_COUNT = 6; //1毫秒的tick可以覆盖约2年, 更远的节点停留在最高层并在每轮重新放置
+
+        TimingWheel(int64_t currentTick = 0) : currentTick(currentTick), nodeCount(0) {
+            for (int i = 0; i < LEVEL_COUNT * SLOT_COUNT; i++) {
+                this->slots[i] = nullptr;
+            }
+            for (int level = 0; level < LEVEL_COUNT; level++) {
+                this->occupiedSlots[level] = 0;
+            }
+        }
+        TimingWheel(const TimingWheel &) = delete;
+        TimingWheel &operator = (const TimingWheel &) = delete;
+
+        int64_t getCurrentTick() const {
+            return this->currentTick;
+        }
+
+        int size() const {
+            return this->nodeCount;
+        }
+
+        bool isEmpty() const {
+            return this->nodeCount == 0;
+        }
+
+        // expiryTick不晚于当前tick的节点在下一个tick到期
+        void add(TimerNode *node, int64_t expiryTick) {
+            if (node->isLinked()) {
+                throw_new(IllegalStateException, "TimerNode is already linked");
+            }
+            node->expiryTick = expiryTick;
+            this->link(node);
+            this->nodeCount++;
+        }
+
+        void remove(TimerNode *node) {
+            if (!node->isLinked()) {
+                return;
+            }
+            this->unlink(node);
+            this->nodeCount--;
+        }
+
+        // 把时间推进到tick(如果它晚于当前tick), 到期的节点被摘下并追加到expired中
+        void advanceTo(int64_t tick, vector<TimerNode*> &expired) {
+            while (this->currentTick < tick) {
+                int64_t eventTick = this->nextEventTick();
+                if (eventTick > tick) {
+                    this->currentTick = tick;
+                    break;
+                }
+                this->currentTick = eventTick;
+                this->cascade(expired);
+                TimerNode *node = this->detachSlot((int)(this->currentTick & (SLOT_COUNT - 1)));
+                while (node != nullptr) {
+                    TimerNode *next = node->next;
+                    node->prev = node->next = nullptr;
+                    expired.push_back(node);
+                    this->nodeCount--;
+                    node = next;
+                }
+            }
+        }
+
+        // 下一个有节点到期或有槽需要拆散的tick, 时间轮为空时返回INT64_MAX
+        int64_t nextEventTick() const {
+            int64_t result = INT64_MAX;
+            for (int level = 0; level < LEVEL_COUNT; level++) {
+                uint64_t occupied = this->occupiedSlots[level];
+                if (occupied == 0) {
+                    continue;
+                }
+                int shift = level * SLOT_BITS;
+                int64_t base = (this->currentTick >> shift) + 1;
+                int rotation = (int)(base & (SLOT_COUNT - 1));
+                uint64_t rotated = rotation == 0 ? occupied : (occupied >> rotation) | (occupied << (SLOT_COUNT - rotation));
+                int64_t tick = (base + __builtin_ctzll(rotated)) << shift;
+                if (tick < result) {
+                    result = tick;
+                }
+            }
+            return result;
+        }
+
+        // 摘下所有节点, 追加到removed中
+        void clear(vector<TimerNode*> &removed) {
+            for (int i = 0; i < LEVEL_COUNT * SLOT_COUNT; i++) {
+                TimerNode *node = this->detachSlot(i);
+                while (node != nullptr) {
+                    TimerNode *next = node->next;
+                    node->prev = node->next = nullptr;
+                    removed.push_back(node);
+                    node = next;
+                }
+            }
+            this->nodeCount = 0;
+        }
+
+    private:
+        void link(TimerNode *node) {
+            int64_t delta = node->expiryTick - this->currentTick;
+            int64_t placementTick = node->expiryTick;
+            if (delta <= 0) {
+                placementTick = this->currentTick + 1;
+                delta = 1;
+            }
+            int level = 0;
+            while (level < LEVEL_COUNT - 1 && delta >= ((int64_t)1 << ((level + 1) * SLOT_BITS))) {
+                level++;
+            }
+            if (level == LEVEL_COUNT - 1 && delta >= ((int64_t)1 << (LEVEL_COUNT * SLOT_BITS))) {
+                placementTick = this->currentTick + ((int64_t)1 << (LEVEL_COUNT * SLOT_BITS)) - 1;
+            }
+            int slot = (int)((placementTick >> (level * SLOT_BITS)) & (SLOT_COUNT - 1));
+            int slotIndex = level * SLOT_COUNT + slot;
+            TimerNode *head = this->slots[slotIndex];
+            node->prev = nullptr;
+            node->next = head;
+            if (head != nullptr) {
+                head->prev = node;
+            }
+            this->slots[slotIndex] = node;
+            node->slotIndex = slotIndex;
+            this->occupiedSlots[level] |= (uint64_t)1 << slot;
+        }
+
+        void unlink(TimerNode *node) {
+            int slotIndex = node->slotIndex;
+            if (node->prev != nullptr) {
+                node->prev->next = node->next;
+            } else {
+                this->slots[slotIndex] = node->next;
+            }
+            if (node->next != nullptr) {
+                node->next->prev = node->prev;
+            }
+            node->prev = node->next = nullptr;
+            node->slotIndex = -1;
+            if (this->slots[slotIndex] == nullptr) {
+                this->occupiedSlots[slotIndex / SLOT_COUNT] &= ~((uint64_t)1 << (slotIndex % SLOT_COUNT));
+            }
+        }
+
+        // 摘下整个槽, 返回链表头, 节点已被标记为未挂入
+        TimerNode *detachSlot(int slotIndex) {
+            TimerNode *head = this->slots[slotIndex];
+            if (head == nullptr) {
+                return nullptr;
+            }
+            this->slots[slotIndex] = nullptr;
+            this->occupiedSlots[slotIndex / SLOT_COUNT] &= ~((uint64_t)1 << (slotIndex % SLOT_COUNT));
+            for (TimerNode *node = head; node != nullptr; node = node->next) {
+                node->slotIndex = -1;
+            }
+            return head;
+        }
+
+        // 当前tick是上层某个槽的起点时, 把该槽的节点重新放入下层, 恰好在当前tick到期的节点直接追加到expired中
+        void cascade(vector<TimerNode*> &expired) {
+            for (int level = 1; level < LEVEL_COUNT; level++) {
+                int shift = level * SLOT_BITS;
+                if ((this->currentTick & (((int64_t)1 << shift) - 1)) != 0) {
+                    break;
+                }
+                int slot = (int)((this->currentTick >> shift) & (SLOT_COUNT - 1));
+                TimerNode *node = this->detachSlot(level * SLOT_COUNT + slot);
+                while (node != nullptr) {
+                    TimerNode *next = node->next;
+                    if (node->expiryTick <= this->currentTick) {
+                        node->prev = node->next = nullptr;
+                        expired.push_back(node);
+                        this->nodeCount--;
+                    } else {
+                        this->link(node);
+                    }
+                    node = next;
+                }
+            }
+        }
+
+        int64_t currentTick;
+        int nodeCount;
+        TimerNode *slots[LEVEL_COUNT * SLOT_COUNT];
+        uint64_t occupiedSlots[LEVEL_COUNT];
+    };
+}
@@ -11,6 +11,7 @@
 #include <list>
 #include <sstream>
 #include "../Common.h"
+#include "../CompletableFuture.h"
 
 namespace com_lanjing_cpp_common_database {
 
@@ -63,6 +64,22 @@ namespace com_lanjing_cpp_common_database {
         }
         virtual Ref<ResultSet> executeQuery() = 0;
         virtual int executeUpdate() = 0;
+        /*
+         * executeQuery/executeUpdate的非阻塞版本, 在executor(通常是专供数据库访问的小线程池)中执行语句,
+         * 调用者线程(或co_await它的协程所在的线程)不会被阻塞. 执行期间不要在其他线程中使用同一个连接
+         */
+        virtual Ref<CompletableFuture<Ref<ResultSet>>> executeQueryAsync(Ref<Executor> executor) {
+            Ref<Statement> statement = this;
+            return CompletableFuture<Ref<ResultSet>>::supplyAsync([statement] {
+                return statement->executeQuery();
+            }, executor);
+        }
+        virtual Ref<CompletableFuture<int>> executeUpdateAsync(Ref<Executor> executor) {
+            Ref<Statement> statement = this;
+            return CompletableFuture<int>::supplyAsync([statement] {
+                return statement->executeUpdate();
+            }, executor);
+        }
     };
 
     interface Connection : implements Closeable {
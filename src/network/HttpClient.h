@@ -8,8 +8,11 @@
 #pragma once
 
 #include "../Auxiliary.h"
+#include "../CompletableFuture.h"
 #include <curl/curl.h>
 #include <vector>
+#include <list>
+#include <map>
 
 namespace com_lanjing_cpp_common_network {
 
@@ -36,6 +39,12 @@ namespace com_lanjing_cpp_common_network {
     class Call : extends Object {
     public:
         Ref<Response> execute();
+        /*
+         * execute的非阻塞版本: 请求交给后台的curl multi驱动线程, 一个线程即可同时驱动任意多个请求.
+         * 返回的future在驱动线程中完成, 所以其就地执行的后续操作(或co_await之后的协程代码)不应长时间阻塞,
+         * 必要时先切换到线程池(co_await executorService->schedule())
+         */
+        Ref<CompletableFuture<Ref<Response>>> executeAsync();
     private:
         static size_t readCallback(void *ptr, size_t size, size_t nmemb, void *userData);
         static size_t writeCallback(void *ptr, size_t size, size_t nmemb, void *userData);
@@ -51,6 +60,9 @@ namespace com_lanjing_cpp_common_network {
         }
     private:
         Call(Ref<Request> request);
+        void prepare();
+        Ref<Response> finish(CURLcode code);
+        void cleanup();
         struct GlobalController {
             GlobalController() {
                 CURLcode code = curl_global_init(CURL_GLOBAL_ALL);
@@ -70,6 +82,112 @@ namespace com_lanjing_cpp_common_network {
             static GlobalController instance;
             return instance;
         }
+        class AsyncController {
+        public:
+            AsyncController() : closed(false) {
+                globalController(); //保证curl的全局初始化先于本对象, 全局清理后于本对象
+                this->multi = curl_multi_init();
+                if (this->multi == nullptr) {
+                    throw_new(HttpException, "Cannot initialize curl multi handle");
+                }
+                int error = pthread_create(&this->thread, nullptr, threadProc, this);
+                if (error != 0) {
+                    curl_multi_cleanup(this->multi);
+                    throw_new(OSException, error, "Cannot create the http driver thread");
+                }
+            }
+            ~AsyncController() {
+                {
+                    Mutex::Scope scope(this->mutex);
+                    this->closed = true;
+                }
+                curl_multi_wakeup(this->multi);
+                pthread_join(this->thread, nullptr);
+                for (auto &pair : this->transfers) {
+                    curl_multi_remove_handle(this->multi, pair.first);
+                    pair.second.call->cleanup();
+                }
+                curl_multi_cleanup(this->multi);
+            }
+            void enqueue(Ref<Call> call, Ref<CompletableFuture<Ref<Response>>> future) {
+                Mutex::Scope scope(this->mutex);
+                if (this->closed) {
+                    call->cleanup();
+                    future->completeExceptionally(new_<HttpException>(__FILE__, __LINE__, "The http driver has been closed"));
+                    return;
+                }
+                this->pendingTransfers.push_back(Transfer { call, future });
+                curl_multi_wakeup(this->multi);
+            }
+        private:
+            struct Transfer {
+                Ref<Call> call;
+                Ref<CompletableFuture<Ref<Response>>> future;
+            };
+            static void *threadProc(void *data) {
+                static_cast<AsyncController*>(data)->threadProc();
+                return nullptr;
+            }
+            void threadProc() {
+                while (true) {
+                    list<Transfer> pendingTransfers;
+                    {
+                        Mutex::Scope scope(this->mutex);
+                        if (this->closed) {
+                            break;
+                        }
+                        pendingTransfers.swap(this->pendingTransfers);
+                    }
+                    for (Transfer &transfer : pendingTransfers) {
+                        if (curl_multi_add_handle(this->multi, transfer.call->curl) != CURLM_OK) {
+                            transfer.call->cleanup();
+                            transfer.future->completeExceptionally(
+                                    new_<HttpException>(__FILE__, __LINE__, "Cannot add the request to curl multi handle")
+                            );
+                        } else {
+                            this->transfers[transfer.call->curl] = transfer;
+                        }
+                    }
+                    int runningCount = 0;
+                    curl_multi_perform(this->multi, &runningCount);
+                    CURLMsg *message;
+                    int remainingCount = 0;
+                    while ((message = curl_multi_info_read(this->multi, &remainingCount)) != nullptr) {
+                        if (message->msg != CURLMSG_DONE) {
+                            continue;
+                        }
+                        CURL *curl = message->easy_handle;
+                        CURLcode code = message->data.result; //remove_handle之后message不再有效
+                        curl_multi_remove_handle(this->multi, curl);
+                        auto iterator = this->transfers.find(curl);
+                        Transfer transfer = iterator->second;
+                        this->transfers.erase(iterator);
+                        Ref<Response> response;
+                        try_ {
+                            defer([=] {
+                                transfer.call->cleanup();
+                            });
+                            response = transfer.call->finish(code);
+                        } catch_(Exception, ex) {
+                            transfer.future->completeExceptionally(ex);
+                            continue;
+                        } end_try
+                        transfer.future->complete(response);
+                    }
+                    curl_multi_poll(this->multi, nullptr, 0, 1000, nullptr);
+                }
+            }
+            CURLM *multi;
+            pthread_t thread;
+            Mutex mutex;
+            bool closed;
+            list<Transfer> pendingTransfers;
+            map<CURL*, Transfer> transfers;
+        };
+        static AsyncController &asyncController() {
+            static AsyncController instance;
+            return instance;
+        }
         class BodyWrapper : extends Object {
         public:
             BodyWrapper(Ref<RequestBody> body) : body(body) {}
@@ -430,21 +548,43 @@ namespace com_lanjing_cpp_common_network {
     }
 
     inline Ref<Response> Call::execute() {
-
-        CURLcode code;
         defer([=] {
-            this->bodyWrapper = nullptr;
-            curl_slist *slist = this->slist;
-            if (slist != nullptr) {
-                this->slist = nullptr;
-                curl_slist_free_all(slist);
-            }
-            CURL *curl = this->curl;
-            if (curl != nullptr) {
-                this->curl = nullptr;
-                curl_easy_cleanup(curl);
-            }
+            this->cleanup();
         });
+        this->prepare();
+        return this->finish(curl_easy_perform(this->curl));
+    }
+
+    inline Ref<CompletableFuture<Ref<Response>>> Call::executeAsync() {
+        Ref<CompletableFuture<Ref<Response>>> future = new_<CompletableFuture<Ref<Response>>>();
+        try_ {
+            this->prepare();
+        } catch_(Exception, ex) {
+            this->cleanup();
+            future->completeExceptionally(ex);
+            return future;
+        } end_try
+        asyncController().enqueue(this, future);
+        return future;
+    }
+
+    inline void Call::cleanup() {
+        this->bodyWrapper = nullptr;
+        curl_slist *slist = this->slist;
+        if (slist != nullptr) {
+            this->slist = nullptr;
+            curl_slist_free_all(slist);
+        }
+        CURL *curl = this->curl;
+        if (curl != nullptr) {
+            this->curl = nullptr;
+            curl_easy_cleanup(curl);
+        }
+    }
+
+    inline void Call::prepare() {
+
+        CURLcode code;
 
         this->curl = globalController().initCurl();
 
@@ -573,8 +713,9 @@ namespace com_lanjing_cpp_common_network {
                 CURLOPT_WRITEDATA,
                 this);
         throwIfNecessary(code, "Cannot set request write data");
+    }
 
-        code = curl_easy_perform(this->curl);
+    inline Ref<Response> Call::finish(CURLcode code) {
         throwIfNecessary(code, "Cannot set request write data");
 
         code = curl_easy_getinfo(this->curl, CURLINFO_RESPONSE_CODE, &response->cd);